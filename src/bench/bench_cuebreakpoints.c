@@ -0,0 +1,13 @@
+/*
+ * bench_cuebreakpoints.c -- cuebreakpoints, linked into cuebench
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#define main cuebreakpoints_main
+#define usage cuebreakpoints_usage
+#define version cuebreakpoints_version
+#define progname cuebreakpoints_progname
+
+#include "../tools/cuebreakpoints.c"
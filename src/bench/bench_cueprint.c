@@ -0,0 +1,13 @@
+/*
+ * bench_cueprint.c -- cueprint, linked into cuebench
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#define main cueprint_main
+#define usage cueprint_usage
+#define version cueprint_version
+#define progname cueprint_progname
+
+#include "../tools/cueprint.c"
@@ -0,0 +1,370 @@
+/*
+ * cuebench.c -- measure library and tool performance over a corpus
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#include <fcntl.h>	/* open() */
+#include <getopt.h>	/* getopt_long() */
+#include <stdio.h>	/* fprintf(), printf(), snprintf(), stderr */
+#include <stdlib.h>	/* exit(), qsort() */
+#include <string.h>	/* strcmp() */
+#include <sys/stat.h>	/* stat() */
+#include <time.h>	/* clock_gettime() */
+#include <unistd.h>	/* dup(), dup2() */
+#include "cuefile.h"
+#include "cue.h"
+#include "toc.h"
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#else /* not HAVE_CONFIG_H */
+#define PACKAGE_STRING "cuebench"
+#endif /* HAVE_CONFIG_H */
+
+/* tools linked in from bench_cueprint.c and bench_cuebreakpoints.c */
+int cueprint_main(int argc, char *argv[]);
+int cuebreakpoints_main(int argc, char *argv[]);
+
+/* one sheet of the corpus */
+typedef struct {
+	char *name;
+	int format;
+	long size;		/* file size (in bytes) */
+	Cd *cd;			/* parsed once, for the print benchmarks */
+} Sheet;
+
+typedef struct {
+	char *name;
+	void (*run)(Sheet *sheet);
+	int selected;
+} Bench;
+
+char *progname;
+
+/*
+ * Allocation accounting.  glibc allows the application to replace
+ * malloc(), and calls made from inside the C library (strdup(), etc.)
+ * go through the replacement, so every allocation is counted.
+ */
+#ifdef __GLIBC__
+#define HAVE_ALLOC_COUNT 1
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static unsigned long nalloc = 0;
+static unsigned long nalloc_bytes = 0;
+
+void *malloc(size_t size)
+{
+	nalloc++;
+	nalloc_bytes += size;
+	return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+	nalloc++;
+	nalloc_bytes += nmemb * size;
+	return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+	nalloc++;
+	nalloc_bytes += size;
+	return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr)
+{
+	__libc_free(ptr);
+}
+#else /* not __GLIBC__ */
+#define HAVE_ALLOC_COUNT 0
+
+static unsigned long nalloc = 0;
+static unsigned long nalloc_bytes = 0;
+#endif /* __GLIBC__ */
+
+/* Print usage information and exit */
+void usage(int status)
+{
+	if (0 == status) {
+		printf("Usage: %s [option...] file...\n", progname);
+		printf("Benchmark parsing, printing and the tools over CUE and TOC files.\n"
+		       "\n"
+		       "OPTIONS\n"
+		       "-h, --help			print usage\n"
+		       "-b, --bench <name>		run only this benchmark (may be repeated)\n"
+		       "-n, --iterations <number>	passes over the corpus (default 5)\n"
+		       "-V, --version			print version information\n"
+		       "\n"
+		       "Benchmarks: cf_parse, cue_print, toc_print, cueprint, cuebreakpoints\n");
+	} else {
+		fprintf(stderr, "Try `%s --help' for more information.\n", progname);
+	}
+
+	exit (status);
+}
+
+/* Print version information and exit */
+void version()
+{
+	printf("%s\n", PACKAGE_STRING);
+
+	exit(0);
+}
+
+double now_ns()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*
+ * benchmarks
+ * output goes to /dev/null, which is set up by run_bench()
+ */
+static FILE *null_fp = NULL;
+
+void bench_cf_parse(Sheet *sheet)
+{
+	int format = sheet->format;
+
+	cd_delete(cf_parse(sheet->name, &format));
+}
+
+void bench_cue_print(Sheet *sheet)
+{
+	cue_print(null_fp, sheet->cd);
+}
+
+void bench_toc_print(Sheet *sheet)
+{
+	toc_print(null_fp, sheet->cd);
+}
+
+void bench_cueprint(Sheet *sheet)
+{
+	char *argv[] = {"cueprint", sheet->name, NULL};
+
+	optind = 1;
+	cueprint_main(2, argv);
+}
+
+void bench_cuebreakpoints(Sheet *sheet)
+{
+	char *argv[] = {"cuebreakpoints", sheet->name, NULL};
+
+	optind = 1;
+	cuebreakpoints_main(2, argv);
+}
+
+static Bench benches[] = {
+	{"cf_parse", bench_cf_parse, 0},
+	{"cue_print", bench_cue_print, 0},
+	{"toc_print", bench_toc_print, 0},
+	{"cueprint", bench_cueprint, 0},
+	{"cuebreakpoints", bench_cuebreakpoints, 0},
+	{NULL, NULL, 0}
+};
+
+int compare_double(const void *a, const void *b)
+{
+	double x = *(const double *) a;
+	double y = *(const double *) b;
+
+	return (x > y) - (x < y);
+}
+
+/* latency percentile (in microseconds) of sorted samples */
+double percentile(double *ns, int n, double p)
+{
+	return ns[(int) (p * (n - 1))] / 1e3;
+}
+
+int run_bench(Bench *bench, Sheet *sheets, int nsheet, int iterations)
+{
+	double *ns;
+	double t, total = 0;
+	double bytes = 0;
+	unsigned long allocs, alloc_bytes;
+	int saved_stdout;
+	int i, j, n = 0;
+
+	if (NULL == (ns = malloc(sizeof(double) * nsheet * iterations))) {
+		fprintf(stderr, "%s: error: out of memory\n", progname);
+		return -1;
+	}
+
+	/* the tools print to stdout */
+	fflush(stdout);
+	saved_stdout = dup(1);
+	dup2(fileno(null_fp), 1);
+
+	allocs = nalloc;
+	alloc_bytes = nalloc_bytes;
+
+	for (i = 0; i < iterations; i++) {
+		for (j = 0; j < nsheet; j++) {
+			t = now_ns();
+			bench->run(&sheets[j]);
+			fflush(stdout);
+			ns[n] = now_ns() - t;
+			total += ns[n++];
+			bytes += sheets[j].size;
+		}
+	}
+
+	allocs = nalloc - allocs;
+	alloc_bytes = nalloc_bytes - alloc_bytes;
+
+	dup2(saved_stdout, 1);
+	close(saved_stdout);
+
+	qsort(ns, n, sizeof(double), compare_double);
+
+	printf("%-15s %7d %10.0f %8.2f %9.1f %9.1f %9.1f %9.1f",
+	       bench->name, n, n / (total / 1e9), bytes / (total / 1e3),
+	       percentile(ns, n, 0.50), percentile(ns, n, 0.90),
+	       percentile(ns, n, 0.99), percentile(ns, n, 1.0));
+	if (HAVE_ALLOC_COUNT) {
+		printf(" %9.1f %11.0f\n", (double) allocs / n,
+		       (double) alloc_bytes / n);
+	} else {
+		printf(" %9s %11s\n", "-", "-");
+	}
+
+	free(ns);
+
+	return 0;
+}
+
+int bench(char **names, int nsheet, int iterations)
+{
+	Sheet *sheets;
+	struct stat st;
+	Bench *b;
+	int i;
+	int ret = 0;
+
+	if (NULL == (null_fp = fopen("/dev/null", "w"))) {
+		fprintf(stderr, "%s: error: unable to open /dev/null\n", progname);
+		return -1;
+	}
+
+	if (NULL == (sheets = calloc(nsheet, sizeof(Sheet)))) {
+		fprintf(stderr, "%s: error: out of memory\n", progname);
+		return -1;
+	}
+
+	for (i = 0; i < nsheet; i++) {
+		sheets[i].name = names[i];
+		sheets[i].format = UNKNOWN;
+
+		if (0 != stat(names[i], &st)) {
+			fprintf(stderr, "%s: error: unable to stat `%s'\n",
+			        progname, names[i]);
+			return -1;
+		}
+		sheets[i].size = st.st_size;
+
+		if (NULL == (sheets[i].cd = cf_parse(names[i], &sheets[i].format))) {
+			fprintf(stderr, "%s: error: unable to parse input file"
+			        " `%s'\n", progname, names[i]);
+			return -1;
+		}
+	}
+
+	printf("%-15s %7s %10s %8s %9s %9s %9s %9s %9s %11s\n",
+	       "benchmark", "calls", "files/s", "MB/s", "p50(us)", "p90(us)",
+	       "p99(us)", "max(us)", "allocs", "alloc-bytes");
+
+	for (b = benches; NULL != b->name && 0 == ret; b++) {
+		if (b->selected) {
+			ret = run_bench(b, sheets, nsheet, iterations);
+		}
+	}
+
+	for (i = 0; i < nsheet; i++) {
+		cd_delete(sheets[i].cd);
+	}
+	free(sheets);
+	fclose(null_fp);
+
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	int iterations = 5;
+	int selected = 0;
+	Bench *b;
+
+	/* option variables */
+	int c;
+	/* getopt_long() variables */
+	extern char *optarg;
+	extern int optind;
+
+	static struct option longopts[] = {
+		{"help", no_argument, NULL, 'h'},
+		{"bench", required_argument, NULL, 'b'},
+		{"iterations", required_argument, NULL, 'n'},
+		{"version", no_argument, NULL, 'V'},
+		{NULL, 0, NULL, 0}
+	};
+
+	progname = argv[0];
+
+	while (-1 != (c = getopt_long(argc, argv, "hb:n:V", longopts, NULL))) {
+		switch (c) {
+		case 'h':
+			usage(0);
+			break;
+		case 'b':
+			for (b = benches; NULL != b->name; b++) {
+				if (0 == strcmp(b->name, optarg)) {
+					break;
+				}
+			}
+			if (NULL == b->name) {
+				fprintf(stderr, "%s: error: unknown benchmark"
+				        " `%s'\n", progname, optarg);
+				usage(1);
+			}
+			b->selected = 1;
+			selected = 1;
+			break;
+		case 'n':
+			iterations = atoi(optarg);
+			break;
+		case 'V':
+			version();
+			break;
+		default:
+			usage(1);
+			break;
+		}
+	}
+
+	if (optind == argc || 1 > iterations) {
+		usage(1);
+	}
+
+	if (!selected) {
+		for (b = benches; NULL != b->name; b++) {
+			b->selected = 1;
+		}
+	}
+
+	return bench(argv + optind, argc - optind, iterations);
+}
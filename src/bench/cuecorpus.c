@@ -0,0 +1,417 @@
+/*
+ * cuecorpus.c -- generate a synthetic cue/toc corpus for benchmarking
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#include <errno.h>	/* errno, EEXIST */
+#include <getopt.h>	/* getopt_long() */
+#include <stdio.h>	/* fprintf(), printf(), snprintf(), stderr */
+#include <stdlib.h>	/* exit() */
+#include <string.h>	/* strlen() */
+#include <sys/stat.h>	/* mkdir() */
+#include "cd.h"
+#include "cdtime.h"
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#else /* not HAVE_CONFIG_H */
+#define PACKAGE_STRING "cuecorpus"
+#endif /* HAVE_CONFIG_H */
+
+#define TEXT_MAX	4096	/* longest CD-TEXT string generated */
+
+/* layout of one generated sheet */
+struct Sheet {
+	int ntrack;		/* number of tracks */
+	int nindex;		/* indexes per track, starting at index 01 */
+	int text_len;		/* CD-TEXT string length (0 for short names) */
+	int nfile;		/* number of FILEs, tracks are spread evenly */
+	int crlf;		/* use CRLF line endings */
+	int bom;		/* start with a UTF-8 byte order mark */
+	long length[MAXTRACK];	/* track lengths (in frames) */
+	long pregap[MAXTRACK];	/* index 00 lengths (in frames) */
+};
+
+static const char *words[] = {
+	"Blue", "Night", "River", "Song", "Electric", "Dream", "Stone", "Fire",
+	"Silent", "Morning", "Echo", "Machine", "Garden", "Winter", "Glass",
+	"Ghost", "Paper", "Heart", "Ocean", "Signal", "Golden", "Shadow"
+};
+#define NWORDS	(sizeof(words) / sizeof(words[0]))
+
+char *progname;
+static unsigned long rng_state = 2463534242UL;
+
+/* Print usage information and exit */
+void usage(int status)
+{
+	if (0 == status) {
+		printf("Usage: %s [option...] directory\n", progname);
+		printf("Write a synthetic CUE and TOC benchmark corpus to directory.\n"
+		       "\n"
+		       "OPTIONS\n"
+		       "-h, --help			print usage\n"
+		       "-n, --albums <number>		number of realistic albums (default 100)\n"
+		       "-s, --seed <number>		random seed\n"
+		       "-V, --version			print version information\n");
+	} else {
+		fprintf(stderr, "Try `%s --help' for more information.\n", progname);
+	}
+
+	exit (status);
+}
+
+/* Print version information and exit */
+void version()
+{
+	printf("%s\n", PACKAGE_STRING);
+
+	exit(0);
+}
+
+/* xorshift generator, so a seed always produces the same corpus */
+unsigned long rng()
+{
+	rng_state ^= (rng_state << 13) & 0xffffffffUL;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= (rng_state << 5) & 0xffffffffUL;
+
+	return rng_state;
+}
+
+long rng_range(long lo, long hi)
+{
+	return lo + (long) (rng() % (unsigned long) (hi - lo + 1));
+}
+
+/* fill s with words, up to len characters (or 1-3 words if len is 0) */
+void make_text(char *s, int len)
+{
+	int n = 0;
+	int nword = rng_range(1, 3);
+	const char *w;
+
+	s[0] = '\0';
+	while ((0 == len && 0 < nword--) || (0 != len && n < len)) {
+		w = words[rng() % NWORDS];
+		if (0 != len && n + (int) strlen(w) + 1 > len) {
+			break;
+		}
+		n += sprintf(s + n, "%s%s", (0 == n) ? "" : " ", w);
+	}
+}
+
+void eol(FILE *fp, struct Sheet *sheet)
+{
+	fputs(sheet->crlf ? "\r\n" : "\n", fp);
+}
+
+void sheet_init(struct Sheet *sheet, int ntrack)
+{
+	int i;
+
+	memset(sheet, 0, sizeof(*sheet));
+	sheet->ntrack = ntrack;
+	sheet->nindex = 1;
+	sheet->nfile = 1;
+
+	for (i = 0; i < ntrack; i++) {
+		/* 1 to 7 minutes, a third of the tracks with a pregap */
+		sheet->length[i] = rng_range(60 * 75, 7 * 60 * 75);
+		sheet->pregap[i] = (0 < i && 0 == rng() % 3) ? rng_range(1, 4 * 75) : 0;
+	}
+}
+
+/* which FILE track i (zero based) is stored in */
+int sheet_file(struct Sheet *sheet, int i)
+{
+	return i * sheet->nfile / sheet->ntrack;
+}
+
+void write_cdtext(FILE *fp, struct Sheet *sheet, int istrack, char *indent)
+{
+	static char text[TEXT_MAX + 1];
+	static const int pti[] = {PTI_TITLE, PTI_PERFORMER, PTI_SONGWRITER,
+	                          PTI_COMPOSER, PTI_ARRANGER, PTI_MESSAGE};
+	int i;
+	int n = (0 == sheet->text_len) ? 2 : 6;
+
+	for (i = 0; i < n; i++) {
+		make_text(text, sheet->text_len);
+		fprintf(fp, "%s%s \"%s\"", indent, cdtext_get_key(pti[i], istrack), text);
+		eol(fp, sheet);
+	}
+}
+
+void write_isrc(FILE *fp, int trackno, int quote)
+{
+	fprintf(fp, "ISRC %sUSCUE%02d%05d%s", quote ? "\"" : "",
+	        (int) rng_range(70, 99), trackno, quote ? "\"" : "");
+}
+
+void write_cue(FILE *fp, struct Sheet *sheet)
+{
+	int i, j;
+	int file = -1;
+	long pos = 0;		/* position in current file */
+	long step;
+
+	if (sheet->bom) {
+		fputs("\xef\xbb\xbf", fp);
+	}
+
+	fprintf(fp, "REM GENRE Rock");
+	eol(fp, sheet);
+	fprintf(fp, "REM COMMENT \"generated by cuecorpus\"");
+	eol(fp, sheet);
+	fprintf(fp, "CATALOG %013lu", rng() % 10000000000UL);
+	eol(fp, sheet);
+	write_cdtext(fp, sheet, 0, "");
+
+	for (i = 0; i < sheet->ntrack; i++) {
+		if (file != sheet_file(sheet, i)) {
+			file = sheet_file(sheet, i);
+			pos = 0;
+			fprintf(fp, "FILE \"disc-%02d.wav\" WAVE", file + 1);
+			eol(fp, sheet);
+		}
+
+		fprintf(fp, "  TRACK %02d AUDIO", i + 1);
+		eol(fp, sheet);
+		write_cdtext(fp, sheet, 1, "    ");
+		fprintf(fp, "    ");
+		write_isrc(fp, i + 1, 0);
+		eol(fp, sheet);
+		if (0 == i % 4) {
+			fprintf(fp, "    FLAGS DCP");
+			eol(fp, sheet);
+		}
+
+		if (0 != sheet->pregap[i]) {
+			fprintf(fp, "    INDEX 00 %s", time_frame_to_mmssff(pos));
+			eol(fp, sheet);
+			pos += sheet->pregap[i];
+		}
+
+		step = sheet->length[i] / sheet->nindex;
+		for (j = 1; j <= sheet->nindex; j++) {
+			fprintf(fp, "    INDEX %02d %s", j,
+			        time_frame_to_mmssff(pos + (j - 1) * step));
+			eol(fp, sheet);
+		}
+
+		pos += sheet->length[i];
+	}
+}
+
+void write_toc(FILE *fp, struct Sheet *sheet)
+{
+	int i, j;
+	int file = -1;
+	long pos = 0;		/* position in current file */
+	long step;
+
+	if (sheet->bom) {
+		fputs("\xef\xbb\xbf", fp);
+	}
+
+	fprintf(fp, "CD_DA");
+	eol(fp, sheet);
+	fprintf(fp, "CATALOG \"%013lu\"", rng() % 10000000000UL);
+	eol(fp, sheet);
+	fprintf(fp, "CD_TEXT {");
+	eol(fp, sheet);
+	fprintf(fp, "  LANGUAGE_MAP {");
+	eol(fp, sheet);
+	fprintf(fp, "    0:9");
+	eol(fp, sheet);
+	fprintf(fp, "  }");
+	eol(fp, sheet);
+	fprintf(fp, "  LANGUAGE 0 {");
+	eol(fp, sheet);
+	write_cdtext(fp, sheet, 0, "    ");
+	fprintf(fp, "  }");
+	eol(fp, sheet);
+	fprintf(fp, "}");
+	eol(fp, sheet);
+
+	for (i = 0; i < sheet->ntrack; i++) {
+		if (file != sheet_file(sheet, i)) {
+			file = sheet_file(sheet, i);
+			pos = 0;
+		}
+
+		eol(fp, sheet);
+		fprintf(fp, "// Track %d", i + 1);
+		eol(fp, sheet);
+		fprintf(fp, "TRACK AUDIO");
+		eol(fp, sheet);
+		if (0 == i % 4) {
+			fprintf(fp, "COPY");
+			eol(fp, sheet);
+		}
+		write_isrc(fp, i + 1, 1);
+		eol(fp, sheet);
+		fprintf(fp, "CD_TEXT {");
+		eol(fp, sheet);
+		fprintf(fp, "  LANGUAGE 0 {");
+		eol(fp, sheet);
+		write_cdtext(fp, sheet, 1, "    ");
+		fprintf(fp, "  }");
+		eol(fp, sheet);
+		fprintf(fp, "}");
+		eol(fp, sheet);
+
+		fprintf(fp, "FILE \"disc-%02d.wav\" %s", file + 1,
+		        time_frame_to_mmssff(pos));
+		fprintf(fp, " %s", time_frame_to_mmssff(sheet->pregap[i]
+		        + sheet->length[i]));
+		eol(fp, sheet);
+		if (0 != sheet->pregap[i]) {
+			fprintf(fp, "START %s", time_frame_to_mmssff(sheet->pregap[i]));
+			eol(fp, sheet);
+		}
+
+		step = sheet->length[i] / sheet->nindex;
+		for (j = 2; j <= sheet->nindex; j++) {
+			fprintf(fp, "INDEX %s", time_frame_to_mmssff((j - 1) * step));
+			eol(fp, sheet);
+		}
+
+		pos += sheet->pregap[i] + sheet->length[i];
+	}
+}
+
+/* write sheet as dir/name.cue and dir/name.toc */
+int write_sheet(char *dir, char *name, struct Sheet *sheet)
+{
+	char path[4096];
+	FILE *fp;
+	int cue;
+
+	for (cue = 1; 0 <= cue; cue--) {
+		snprintf(path, sizeof(path), "%s/%s.%s", dir, name,
+		         cue ? "cue" : "toc");
+
+		if (NULL == (fp = fopen(path, "w"))) {
+			fprintf(stderr, "%s: error: unable to open `%s'\n",
+			        progname, path);
+			return -1;
+		}
+
+		if (cue) {
+			write_cue(fp, sheet);
+		} else {
+			write_toc(fp, sheet);
+		}
+
+		fclose(fp);
+	}
+
+	return 0;
+}
+
+int corpus(char *dir, int nalbum)
+{
+	struct Sheet sheet;
+	char name[64];
+	int i;
+	int ret = 0;
+
+	if (0 != mkdir(dir, 0777) && EEXIST != errno) {
+		fprintf(stderr, "%s: error: unable to create `%s'\n", progname, dir);
+		return -1;
+	}
+
+	/* realistic albums, every fourth with one FILE per track */
+	for (i = 1; i <= nalbum && 0 == ret; i++) {
+		sheet_init(&sheet, rng_range(8, 20));
+		if (0 == i % 4) {
+			sheet.nfile = sheet.ntrack;
+		}
+		sheet.crlf = (1 == i % 8);
+		sheet.bom = (2 == i % 8);
+		snprintf(name, sizeof(name), "album-%04d%s", i,
+		         sheet.crlf ? "-crlf" : sheet.bom ? "-bom" : "");
+		ret = write_sheet(dir, name, &sheet);
+	}
+
+	/* worst cases */
+	sheet_init(&sheet, MAXTRACK);
+	ret |= write_sheet(dir, "worst-tracks99", &sheet);
+
+	sheet.crlf = 1;
+	ret |= write_sheet(dir, "worst-tracks99-crlf", &sheet);
+
+	sheet.crlf = 0;
+	sheet.bom = 1;
+	ret |= write_sheet(dir, "worst-tracks99-bom", &sheet);
+
+	sheet_init(&sheet, MAXTRACK);
+	sheet.nindex = MAXINDEX - 1;
+	ret |= write_sheet(dir, "worst-indexes99", &sheet);
+
+	sheet_init(&sheet, MAXTRACK);
+	sheet.text_len = TEXT_MAX;
+	ret |= write_sheet(dir, "worst-cdtext-long", &sheet);
+
+	sheet_init(&sheet, MAXTRACK);
+	sheet.nfile = MAXTRACK;
+	ret |= write_sheet(dir, "worst-multifile", &sheet);
+
+	sheet_init(&sheet, MAXTRACK);
+	sheet.nfile = 3;
+	ret |= write_sheet(dir, "worst-fewfiles", &sheet);
+
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	int nalbum = 100;
+
+	/* option variables */
+	int c;
+	/* getopt_long() variables */
+	extern char *optarg;
+	extern int optind;
+
+	static struct option longopts[] = {
+		{"help", no_argument, NULL, 'h'},
+		{"albums", required_argument, NULL, 'n'},
+		{"seed", required_argument, NULL, 's'},
+		{"version", no_argument, NULL, 'V'},
+		{NULL, 0, NULL, 0}
+	};
+
+	progname = argv[0];
+
+	while (-1 != (c = getopt_long(argc, argv, "hn:s:V", longopts, NULL))) {
+		switch (c) {
+		case 'h':
+			usage(0);
+			break;
+		case 'n':
+			nalbum = atoi(optarg);
+			break;
+		case 's':
+			/* xorshift state must not be zero */
+			rng_state = strtoul(optarg, NULL, 0) | 1;
+			break;
+		case 'V':
+			version();
+			break;
+		default:
+			usage(1);
+			break;
+		}
+	}
+
+	if (optind != argc - 1) {
+		usage(1);
+	}
+
+	return corpus(argv[optind], nalbum);
+}
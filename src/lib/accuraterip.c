@@ -0,0 +1,164 @@
+/*
+ * accuraterip.c -- AccurateRip checksums and database responses
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "accuraterip.h"
+
+void ar_init(ArSum *ar, unsigned long nsamples, int first, int last)
+{
+	ar->v1 = 0;
+	ar->v2 = 0;
+	ar->sum = 0;
+	ar->mult = 1;
+	ar->check_start = first ? AR_SKIP - 1 : 1;
+	ar->check_end = nsamples;
+	if (last) {
+		ar->check_end = (AR_SKIP < nsamples) ? nsamples - AR_SKIP : 0;
+	}
+}
+
+void ar_update(ArSum *ar, const unsigned char *data, size_t n)
+{
+	uint32_t lo = 0;	/* sum of the low halves of the products */
+	uint32_t hi = 0;	/* sum of the high halves */
+	uint32_t sum = 0;
+	uint32_t mult;
+	uint32_t s;
+	uint64_t product;
+	size_t count = n;
+	size_t i = 0;
+
+	/* clip to the counted samples */
+	if (ar->mult < ar->check_start) {
+		i = ar->check_start - ar->mult;
+	}
+	if (ar->mult + n - 1 > ar->check_end) {
+		n = (ar->check_end >= ar->mult) ? ar->check_end - ar->mult + 1 : 0;
+	}
+
+	/* a plain loop, so that the compiler can vectorize it */
+	mult = ar->mult;
+	for (; i < n; i++) {
+		s = (uint32_t) data[4 * i] | (uint32_t) data[4 * i + 1] << 8
+		    | (uint32_t) data[4 * i + 2] << 16
+		    | (uint32_t) data[4 * i + 3] << 24;
+		product = (uint64_t) s * (mult + i);
+		lo += (uint32_t) product;
+		hi += (uint32_t) (product >> 32);
+		sum += s;
+	}
+
+	ar->v1 += lo;
+	ar->v2 += lo + hi;
+	ar->sum += sum;
+	ar->mult += count;
+}
+
+void ar_skip(ArSum *ar, size_t n)
+{
+	ar->mult += n;
+}
+
+/*
+ * with samples s, counted from a to b, moving one sample along gives
+ *   v1' = sum(k = a..b) k s[k + 1]
+ *       = v1 - sum - (a - 1) s[a] + b s[b + 1]
+ *   sum' = sum - s[a] + s[b + 1]
+ */
+void ar_slide(ArSum *ar, uint32_t out, uint32_t in)
+{
+	ar->v1 += ar->check_end * in - ar->sum - (ar->check_start - 1) * out;
+	ar->sum += in - out;
+}
+
+static uint32_t get_le32(const unsigned char *p)
+{
+	return (uint32_t) p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16
+	       | (uint32_t) p[3] << 24;
+}
+
+int ar_read_db(char *name, ArResponse **resp)
+{
+	FILE *fp = NULL;
+	ArResponse *r = NULL;
+	ArResponse *tmp = NULL;
+	unsigned char buf[13];
+	int nresp = 0;
+	int size = 0;
+	int i;
+
+	*resp = NULL;
+
+	if (NULL == (fp = fopen(name, "rb"))) {
+		fprintf(stderr, "%s: error opening file\n", name);
+		return -1;
+	}
+
+	/* header: track count, disc IDs 1 and 2, CDDB ID; then the tracks */
+	while (13 == fread(buf, 1, 13, fp)) {
+		if (nresp == size) {
+			size = (0 == size) ? 4 : 2 * size;
+			if (NULL == (tmp = realloc(r, size * sizeof(ArResponse)))) {
+				fprintf(stderr, "unable to allocate memory\n");
+				free(r);
+				fclose(fp);
+				return -1;
+			}
+			r = tmp;
+		}
+
+		tmp = &r[nresp];
+		tmp->ntrack = buf[0];
+		tmp->id1 = get_le32(buf + 1);
+		tmp->id2 = get_le32(buf + 5);
+		tmp->cddb = get_le32(buf + 9);
+		if (MAXTRACK < tmp->ntrack) {
+			break;
+		}
+		for (i = 0; i < tmp->ntrack; i++) {
+			if (9 != fread(buf, 1, 9, fp)) {
+				break;
+			}
+			tmp->track[i].confidence = buf[0];
+			tmp->track[i].crc = get_le32(buf + 1);
+			tmp->track[i].crc450 = get_le32(buf + 5);
+		}
+		if (i < tmp->ntrack) {
+			break;
+		}
+		nresp++;
+	}
+
+	if (ferror(fp) || !feof(fp)) {
+		fprintf(stderr, "%s: not an AccurateRip response\n", name);
+		free(r);
+		fclose(fp);
+		return -1;
+	}
+
+	fclose(fp);
+	*resp = r;
+
+	return nresp;
+}
+
+int ar_confidence(ArResponse *resp, int nresp, int trackno, uint32_t crc)
+{
+	int confidence = 0;
+	int i;
+
+	for (i = 0; i < nresp; i++) {
+		if (trackno <= resp[i].ntrack
+		    && crc == resp[i].track[trackno - 1].crc) {
+			confidence += resp[i].track[trackno - 1].confidence;
+		}
+	}
+
+	return confidence;
+}
@@ -0,0 +1,77 @@
+/*
+ * accuraterip.h -- AccurateRip checksums and database responses
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#ifndef ACCURATERIP_H
+#define ACCURATERIP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "cd.h"
+
+#define SAMPLES_PER_FRAME	588	/* 16 bit stereo samples per CD frame */
+#define BYTES_PER_SAMPLE	4
+#define AR_SKIP		(5 * SAMPLES_PER_FRAME)	/* samples left out at the
+						 * ends of the disc */
+
+/*
+ * running checksums of one track
+ * samples are numbered from 1; only those in [check_start, check_end]
+ * are counted, leaving out the first and last five frames of the disc
+ */
+typedef struct ArSum ArSum;
+struct ArSum {
+	uint32_t v1;		/* AccurateRip v1 */
+	uint32_t v2;		/* AccurateRip v2 */
+	uint32_t sum;		/* plain sum of the counted samples */
+	uint32_t mult;		/* number of the next sample */
+	uint32_t check_start;
+	uint32_t check_end;
+};
+
+/* nsamples is the track length; first and last mark the ends of the disc */
+void ar_init(ArSum *ar, unsigned long nsamples, int first, int last);
+
+/* add n little-endian stereo samples */
+void ar_update(ArSum *ar, const unsigned char *data, size_t n);
+
+/* add n samples of digital silence */
+void ar_skip(ArSum *ar, size_t n);
+
+/*
+ * move a complete v1 checksum one sample later in the audio
+ * out is the first counted sample, in the one after the last
+ * v2 is not kept up to date
+ */
+void ar_slide(ArSum *ar, uint32_t out, uint32_t in);
+
+/* a response from the AccurateRip database (dBAR-*.bin) */
+typedef struct ArResponse ArResponse;
+struct ArResponse {
+	int ntrack;
+	uint32_t id1;
+	uint32_t id2;
+	uint32_t cddb;
+	struct {
+		int confidence;
+		uint32_t crc;		/* v1 or v2 checksum */
+		uint32_t crc450;	/* checksum of frame 450 */
+	} track[MAXTRACK];
+};
+
+/*
+ * read all responses in a dBAR file
+ * returns the number read, or -1 on error; free *resp when done
+ */
+int ar_read_db(char *name, ArResponse **resp);
+
+/*
+ * total confidence of the responses that agree with checksum crc for
+ * track number trackno (from 1), or 0 if none do
+ */
+int ar_confidence(ArResponse *resp, int nresp, int trackno, uint32_t crc);
+
+#endif
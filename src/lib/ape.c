@@ -0,0 +1,139 @@
+/*
+ * ape.c -- cue sheets in APEv2 tags
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "cuefile.h"
+#include "ape.h"
+#include "stats.h"
+
+#define APE_FOOTER	32
+#define ID3V1_SIZE	128
+#define APE_MAX_TAG	(16 * 1024 * 1024)	/* sanity limit on a tag */
+
+static unsigned long get_le32(const unsigned char *p)
+{
+	return p[0] | p[1] << 8 | p[2] << 16 | (unsigned long) p[3] << 24;
+}
+
+/* find the Cuesheet item among count items of a tag and parse it */
+static Cd *ape_items(const unsigned char *p, size_t size, unsigned long count,
+                     char *name)
+{
+	const unsigned char *key = NULL;
+	const unsigned char *nul = NULL;
+	unsigned long len;
+	unsigned long flags;
+	size_t pos = 0;
+
+	for (; 0 < count && pos + 9 <= size; count--) {
+		len = get_le32(p + pos);
+		flags = get_le32(p + pos + 4);
+		key = p + pos + 8;
+		if (NULL == (nul = memchr(key, '\0', size - pos - 8))
+		    || len > size - (nul + 1 - p)) {
+			break;
+		}
+
+		/* a UTF-8 text item */
+		if (0 == strcasecmp((char *) key, "Cuesheet")
+		    && 0 == ((flags >> 1) & 3)) {
+			return cf_parse_memory((const char *) nul + 1, len, CUE);
+		}
+		pos = nul + 1 + len - p;
+	}
+
+	fprintf(stderr, "%s: no cue sheet in APEv2 tag\n", name);
+
+	return NULL;
+}
+
+int ape_sniff(const unsigned char *head, size_t len)
+{
+	if (4 <= len && (0 == memcmp(head, "MAC ", 4)
+	                 || 0 == memcmp(head, "wvpk", 4))) {
+		return 100;
+	}
+
+	return 0;
+}
+
+Cd *ape_read(char *name)
+{
+	unsigned char tail[APE_FOOTER + ID3V1_SIZE];
+	unsigned char *footer = NULL;
+	unsigned char *tag = NULL;
+	struct stat st;
+	off_t end;		/* of the footer in the file */
+	size_t n;
+	unsigned long size;
+	Cd *cd = NULL;
+	int fd;
+
+	/* the tag is found from the end, so the file must be seekable */
+	if (0 == strcmp("-", name)) {
+		fprintf(stderr, "APEv2 tags can not be read from standard input\n");
+		return NULL;
+	}
+	if (-1 == (fd = open(name, O_RDONLY))) {
+		fprintf(stderr, "%s: error opening file\n", name);
+		return NULL;
+	}
+	if (0 != fstat(fd, &st)) {
+		fprintf(stderr, "%s: error reading file\n", name);
+		close(fd);
+		return NULL;
+	}
+
+	/* the footer is last, or just before an ID3v1 tag */
+	n = (st.st_size < (off_t) sizeof(tail)) ? st.st_size
+	    : (off_t) sizeof(tail);
+	if ((ssize_t) n != pread(fd, tail, n, st.st_size - n)) {
+		n = 0;
+	}
+	stats_count(STATS_BYTES_READ, n);
+	end = st.st_size;
+	if (APE_FOOTER <= n) {
+		footer = tail + n - APE_FOOTER;
+		/* an ID3v1 tag is only looked for if the footer is not last */
+		if (0 != memcmp(footer, "APETAGEX", 8) && sizeof(tail) == n
+		    && 0 == memcmp(tail + APE_FOOTER, "TAG", 3)) {
+			footer -= ID3V1_SIZE;
+			end -= ID3V1_SIZE;
+		}
+	}
+
+	if (NULL == footer || 0 != memcmp(footer, "APETAGEX", 8)) {
+		fprintf(stderr, "%s: no APEv2 tag\n", name);
+		close(fd);
+		return NULL;
+	}
+
+	/* the size counts the items and the footer, but not any header */
+	size = get_le32(footer + 12);
+	if (APE_FOOTER > size || APE_MAX_TAG < size || end < (off_t) size) {
+		fprintf(stderr, "%s: bad APEv2 tag\n", name);
+	} else if (NULL == (tag = malloc(size - APE_FOOTER + 1))) {
+		fprintf(stderr, "unable to allocate memory\n");
+	} else if ((ssize_t) (size - APE_FOOTER)
+	           != pread(fd, tag, size - APE_FOOTER, end - size)) {
+		fprintf(stderr, "%s: error reading file\n", name);
+	} else {
+		stats_count(STATS_BYTES_READ, size - APE_FOOTER);
+		cd = ape_items(tag, size - APE_FOOTER, get_le32(footer + 16),
+		               name);
+	}
+	free(tag);
+	close(fd);
+
+	return cd;
+}
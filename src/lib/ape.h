@@ -0,0 +1,28 @@
+/*
+ * ape.h -- cue sheets in APEv2 tags
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#ifndef APE_H
+#define APE_H
+
+#include <stddef.h>
+#include "cd.h"
+
+/*
+ * 100 if the first bytes of a file are a Monkey's Audio or WavPack header,
+ * else 0
+ */
+int ape_sniff(const unsigned char *head, size_t len);
+
+/*
+ * read the Cuesheet item of the APEv2 tag at the end of a file, such as a
+ * Monkey's Audio or WavPack image.  The footer is found with one read of
+ * the end of the file, and the items with a second.
+ * returns NULL if the file has no tag or the tag no cue sheet
+ */
+Cd *ape_read(char *name);
+
+#endif
@@ -0,0 +1,264 @@
+/*
+ * canon.c -- canonical form and hash of a disc
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "canon.h"
+#include "sha1.h"
+
+#define CANON_VERSION	1	/* first line of the form */
+
+/* where the form goes: a file, a digest, or both */
+typedef struct Sink Sink;
+struct Sink {
+	FILE *fp;
+	Sha1 *sha;
+	int err;
+};
+
+static void canon_put(Sink *sink, const char *s, size_t len)
+{
+	if (NULL != sink->fp && len != fwrite(s, 1, len, sink->fp)) {
+		sink->err = -1;
+	}
+	if (NULL != sink->sha) {
+		sha1_update(sink->sha, s, len);
+	}
+}
+
+/* a short line, or part of one */
+static void canon_line(Sink *sink, const char *fmt, ...)
+{
+	char line[64];
+	va_list ap;
+	int len;
+
+	va_start(ap, fmt);
+	len = vsnprintf(line, sizeof(line), fmt, ap);
+	va_end(ap);
+	canon_put(sink, line, len);
+}
+
+/* collapse runs of whitespace, trim, lowercase ASCII; returns the length */
+static size_t canon_text(char *dst, const char *src)
+{
+	char *p = dst;
+
+	for (; '\0' != *src; src++) {
+		if (isspace((unsigned char) *src)) {
+			if (p != dst && ' ' != p[-1]) {
+				*p++ = ' ';
+			}
+		} else {
+			*p++ = tolower((unsigned char) *src);
+		}
+	}
+	if (p != dst && ' ' == p[-1]) {
+		p--;
+	}
+	*p = '\0';
+
+	return p - dst;
+}
+
+/* letters and digits only, uppercased, as in "US-ABC-12-34567" */
+static size_t canon_code(char *dst, const char *src)
+{
+	char *p = dst;
+
+	for (; '\0' != *src; src++) {
+		if (isalnum((unsigned char) *src)) {
+			*p++ = toupper((unsigned char) *src);
+		}
+	}
+	*p = '\0';
+
+	return p - dst;
+}
+
+/* "<key> <trackno> <value>", unless the value normalizes to nothing */
+static int canon_field(Sink *sink, const char *key, int trackno,
+                       char *value, size_t (*norm)(char *, const char *))
+{
+	char *buf = NULL;
+	size_t len;
+
+	if (NULL == value) {
+		return 0;
+	}
+	if (NULL == (buf = malloc(strlen(value) + 2))) {
+		fprintf(stderr, "unable to allocate memory\n");
+		return -1;
+	}
+
+	if (0 < (len = norm(buf, value))) {
+		buf[len++] = '\n';
+		canon_line(sink, "%s %d ", key, trackno);
+		canon_put(sink, buf, len);
+	}
+	free(buf);
+
+	return 0;
+}
+
+/* the text fields written to a disc, in PTI order */
+static int canon_cdtext(Sink *sink, Cdtext *cdtext, int trackno)
+{
+	int pti;
+
+	for (pti = PTI_TITLE; pti <= PTI_MESSAGE; pti++) {
+		if (0 != canon_field(sink, cdtext_get_key(pti, 0 != trackno),
+		                     trackno, cdtext_get(pti, cdtext),
+		                     canon_text)) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static const char *canon_mode(int mode)
+{
+	switch (mode) {
+	case MODE_AUDIO:
+		return "audio";
+	case MODE_MODE1:
+	case MODE_MODE1_RAW:
+		return "mode1";
+	default:
+		return "mode2";
+	}
+}
+
+/*
+ * the length of each track from its index 01 to the next track's, or to
+ * its end for the last, or -1 if unknown
+ * a track starts at its pregap, and index[1] counts from there; a pregap
+ * at the end of the file of the track before is in that track's length,
+ * so it lands on the same disc positions as an INDEX 00 in the same file
+ */
+static void canon_lengths(Cd *cd, long *length)
+{
+	Track *track = NULL;
+	long start = 0;		/* of the track, known if prev is */
+	long prev = -1;		/* index 01 of the previous track, or -1 */
+	long here;
+	int ntrack = cd_get_ntrack(cd);
+	int i;
+
+	for (i = 1; i <= ntrack; i++) {
+		track = cd_get_track(cd, i);
+		here = start + ((2 > track_get_nindex(track)) ? 0
+		                : track_get_index(track, 1));
+		if (1 < i) {
+			length[i - 2] = (0 > prev) ? -1 : here - prev;
+		}
+
+		if (NULL != track_get_filename(track)
+		    && 0 == track_get_length(track)) {
+			/* runs to the end of its file, so the next one is adrift */
+			prev = -1;
+			start = 0;
+		} else {
+			prev = here;
+			start += track_get_zero_pre(track) + track_get_length(track)
+			         + track_get_zero_post(track);
+		}
+	}
+
+	if (0 < ntrack) {
+		length[ntrack - 1] = (0 > prev) ? -1 : start - prev;
+	}
+}
+
+static int canon_emit(Sink *sink, Cd *cd, int flags)
+{
+	static const struct {
+		int flag;
+		char *name;
+	} flagnames[] = {
+		{FLAG_PRE_EMPHASIS, "flag %d pre\n"},
+		{FLAG_COPY_PERMITTED, "flag %d dcp\n"},
+		{FLAG_FOUR_CHANNEL, "flag %d 4ch\n"},
+		{FLAG_SCMS, "flag %d scms\n"}
+	};
+	long length[MAXTRACK];
+	Track *track = NULL;
+	int full = !(flags & CANON_LAYOUT);
+	int i;
+	int j;
+
+	canon_lengths(cd, length);
+
+	canon_line(sink, "canon %d\n", CANON_VERSION);
+	if (full && (0 != canon_field(sink, "catalog", 0, cd_get_catalog(cd),
+	                              canon_code)
+	             || 0 != canon_cdtext(sink, cd_get_cdtext(cd), 0))) {
+		return -1;
+	}
+
+	for (i = 1; i <= cd_get_ntrack(cd); i++) {
+		track = cd_get_track(cd, i);
+		canon_line(sink, "track %d %s ", i,
+		           canon_mode(track_get_mode(track)));
+		if (0 > length[i - 1]) {
+			canon_line(sink, "-\n");
+		} else {
+			canon_line(sink, "%ld\n", length[i - 1]);
+		}
+
+		if (!full) {
+			continue;
+		}
+		for (j = 0; j < (int) (sizeof(flagnames) / sizeof(*flagnames));
+		     j++) {
+			if (track_is_set_flag(track, flagnames[j].flag)) {
+				canon_line(sink, flagnames[j].name, i);
+			}
+		}
+		if (0 != canon_field(sink, "isrc", i, track_get_isrc(track),
+		                     canon_code)
+		    || 0 != canon_cdtext(sink, track_get_cdtext(track), i)) {
+			return -1;
+		}
+	}
+
+	return sink->err;
+}
+
+int canon_print(FILE *fp, Cd *cd, int flags)
+{
+	Sink sink;
+
+	sink.fp = fp;
+	sink.sha = NULL;
+	sink.err = 0;
+
+	return canon_emit(&sink, cd, flags);
+}
+
+int canon_hash(Cd *cd, int flags, unsigned char *hash)
+{
+	unsigned char digest[SHA1_SIZE];
+	Sha1 sha;
+	Sink sink;
+	int ret;
+
+	sink.fp = NULL;
+	sink.sha = &sha;
+	sink.err = 0;
+
+	sha1_init(&sha);
+	ret = canon_emit(&sink, cd, flags);
+	sha1_final(&sha, digest);
+	memcpy(hash, digest, CANON_HASH_SIZE);
+
+	return ret;
+}
@@ -0,0 +1,44 @@
+/*
+ * canon.h -- canonical form and hash of a disc
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#ifndef CANON_H
+#define CANON_H
+
+#include <stdio.h>
+#include "cd.h"
+
+#define CANON_HASH_SIZE	16	/* bytes of a hash (128 bits) */
+
+/* what goes into the canonical form */
+enum CanonFlags {
+	CANON_FULL	= 0x00,	/* layout, flags, catalog, ISRCs and CD-TEXT */
+	CANON_LAYOUT	= 0x01	/* track modes and lengths only */
+};
+
+/*
+ * the canonical form of a disc is a few lines of text that are the same
+ * for two sheets of the same disc however they were written: file names,
+ * REM lines and whitespace are left out, the pregaps are folded into the
+ * lengths of the tracks before them (so it does not matter whether a gap
+ * is a PREGAP, an INDEX 00 in the track's file or at the end of the
+ * previous file, or appended to the previous file with no INDEX 00), and
+ * CD-TEXT is trimmed, its spaces collapsed and its ASCII letters
+ * lowercased.
+ *
+ * a length that is unknown, as it is for the last track of each file of a
+ * cue sheet, is written as "-"; set it with cf_set_lengths() first for the
+ * form of a sheet with a file per track to say much.
+ */
+int canon_print(FILE *fp, Cd *cd, int flags);	/* -1 on a write error */
+
+/*
+ * set hash to the first CANON_HASH_SIZE bytes of the SHA-1 digest of the
+ * canonical form; returns -1 if memory ran out
+ */
+int canon_hash(Cd *cd, int flags, unsigned char *hash);
+
+#endif
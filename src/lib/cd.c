@@ -9,6 +9,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include "cd.h"
+#include "stats.h"
+#include "probes.h"
 
 typedef struct Data Data;
 struct Data {
@@ -22,6 +24,10 @@ struct Track {
 	Data zero_pre;			/* pre-gap generated with zero data */
 	Data file;			/* track data file */
 	Data zero_post;			/* post-gap generated with zero data */
+	int filetype;			/* type of data file */
+	long data_offset;		/* bytes before the data in the file */
+	long pregap_start;		/* index 0 in the file of the track
+					 * before, or -1 */
 	int mode;			/* track mode */
 	int sub_mode;			/* sub-channel mode */
 	int flags;			/* flags */
@@ -36,23 +42,33 @@ struct Track {
 struct Cd {
 	int mode;			/* disc mode */
 	char *catalog;			/* Media Catalog Number (5.22.3) */
+	char *cdtextfile;		/* binary CD-TEXT, as named */
 	Cdtext *cdtext;			/* CD-TEXT */
 	int ntrack;			/* number of tracks in album */
 	Track *track[MAXTRACK];		/* array of tracks */
+	int nextent;			/* layout (see cd_layout()) */
+	CdExtent *extent;
+	int npoint;
+	CdPoint *point;
 };
 
 Cd *cd_init()
 {
 	Cd *cd = NULL;
-	cd = malloc(sizeof(Cd));
+	cd = stats_malloc(sizeof(Cd));
 
 	if(NULL == cd) {
 		fprintf(stderr, "unable to create cd\n");
 	} else {
 		cd->mode = MODE_CD_DA;
 		cd->catalog = NULL;
+		cd->cdtextfile = NULL;
 		cd->cdtext = cdtext_init();
 		cd->ntrack = 0;
+		cd->nextent = 0;
+		cd->extent = NULL;
+		cd->npoint = 0;
+		cd->point = NULL;
 	}
 
 	return cd;
@@ -61,7 +77,7 @@ Cd *cd_init()
 Track *track_init()
 {
 	Track *track = NULL;
-	track = malloc(sizeof(Track));
+	track = stats_malloc(sizeof(Track));
 
 	if (NULL == track) {
 		fprintf(stderr, "unable to create track\n");
@@ -81,6 +97,9 @@ Track *track_init()
 		track->zero_post.start = 0;
 		track->zero_post.length = 0;
 
+		track->filetype = FILE_UNKNOWN;
+		track->data_offset = 0;
+		track->pregap_start = -1;
 		track->mode = MODE_AUDIO;
 		track->sub_mode = SUB_MODE_RW;
 		track->flags = FLAG_NONE;
@@ -92,6 +111,33 @@ Track *track_init()
 	return track;
 }
 
+void track_delete(Track *track)
+{
+	if (NULL != track) {
+		free(track->file.name);
+		free(track->isrc);
+		cdtext_delete(track->cdtext);
+		free(track);
+	}
+}
+
+void cd_delete(Cd *cd)
+{
+	int i;
+
+	if (NULL != cd) {
+		for (i = 0; i < cd->ntrack; i++) {
+			track_delete(cd->track[i]);
+		}
+		free(cd->catalog);
+		free(cd->cdtextfile);
+		cdtext_delete(cd->cdtext);
+		free(cd->extent);
+		free(cd->point);
+		free(cd);
+	}
+}
+
 /*
  * cd structure functions
  */
@@ -107,11 +153,14 @@ int cd_get_mode(Cd *cd)
 
 void cd_set_catalog(Cd *cd, char *catalog)
 {
+	int phase = stats_phase(PHASE_BUILD);
+
 	if (cd->catalog) {
 		free(cd->catalog);
 	}
 
-	cd->catalog = strdup(catalog);
+	cd->catalog = stats_strdup(catalog);
+	stats_phase(phase);
 }
 
 char *cd_get_catalog(Cd *cd)
@@ -119,6 +168,20 @@ char *cd_get_catalog(Cd *cd)
 	return cd->catalog;
 }
 
+void cd_set_cdtextfile(Cd *cd, char *cdtextfile)
+{
+	int phase = stats_phase(PHASE_BUILD);
+
+	free(cd->cdtextfile);
+	cd->cdtextfile = stats_strdup(cdtextfile);
+	stats_phase(phase);
+}
+
+char *cd_get_cdtextfile(Cd *cd)
+{
+	return cd->cdtextfile;
+}
+
 Cdtext *cd_get_cdtext(Cd *cd)
 {
 	return cd->cdtext;
@@ -126,14 +189,17 @@ Cdtext *cd_get_cdtext(Cd *cd)
 
 Track *cd_add_track(Cd *cd)
 {
-	if (MAXTRACK > cd->ntrack) {
-		cd->ntrack++;
-	} else {
-		fprintf(stderr, "too many tracks\n");
+	int phase;
+
+	if (MAXTRACK == cd->ntrack) {
+		fprintf(stderr, "more than %d tracks\n", MAXTRACK);
+		return NULL;
 	}
 
-	/* this will reinit last track if there were too many */
-	cd->track[cd->ntrack - 1] = track_init();
+	phase = stats_phase(PHASE_BUILD);
+	cd->track[cd->ntrack++] = track_init();
+	stats_phase(phase);
+	PROBE2(track__add, cd, cd->ntrack);
 
 	return cd->track[cd->ntrack - 1];
 }
@@ -153,17 +219,344 @@ Track *cd_get_track(Cd *cd, int i)
 	return NULL;
 }
 
+/* append an extent of length frames, unless it is empty */
+static void cd_layout_add(Cd *cd, long *frame, int trackno, char *filename,
+                          long offset, long block, long length)
+{
+	CdExtent *e = &cd->extent[cd->nextent];
+
+	if (0 < length) {
+		e->frame = *frame;
+		e->length = length;
+		e->trackno = trackno;
+		e->filename = filename;
+		e->offset = offset;
+		e->block = block;
+		cd->nextent++;
+		*frame += length;
+	}
+}
+
+/* append a point; -1 if it is before the last one */
+static int cd_layout_point(Cd *cd, long frame, int trackno, int index)
+{
+	CdPoint *p = &cd->point[cd->npoint];
+
+	if (0 < cd->npoint && frame < p[-1].frame) {
+		fprintf(stderr, "index %02d of track %d is out of order\n", index,
+		        trackno);
+		return -1;
+	}
+
+	p->frame = frame;
+	p->trackno = trackno;
+	p->index = index;
+	cd->npoint++;
+
+	return 0;
+}
+
+/*
+ * append the points of a track starting at frame; origin is where the
+ * file of the track before would start on the disc
+ */
+static int cd_layout_points(Cd *cd, Track *track, int trackno, long frame,
+                            long origin)
+{
+	int i;
+
+	/* a track with no index 01, as a cue track with no INDEX, has none */
+	if (2 > track->nindex) {
+		return cd_layout_point(cd, frame, trackno, 1);
+	}
+
+	/* an INDEX 00 at the end of the file of the track before */
+	if (0 <= track->pregap_start
+	    && 0 != cd_layout_point(cd, origin + track->pregap_start,
+	                            trackno, 0)) {
+		return -1;
+	}
+
+	/* a PREGAP of silence with no INDEX 00 is index 0 all the same */
+	if (0 < track->index[0] && 0 != cd_layout_point(cd, frame, trackno, 0)) {
+		return -1;
+	}
+
+	for (i = 0; i < track->nindex; i++) {
+		/* of several indexes at one frame, only the last is kept */
+		if (i + 1 < track->nindex
+		    && track->index[i] == track->index[i + 1]) {
+			continue;
+		}
+		if (0 != cd_layout_point(cd, frame + track->index[i], trackno,
+		                         i)) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+int cd_layout(Cd *cd)
+{
+	Track *track = NULL;
+	long frame = 0;
+	long origin = 0;	/* of the file of the track before */
+	int npoint = 0;
+	int i;
+
+	for (i = 0; i < cd->ntrack; i++) {
+		npoint += cd->track[i]->nindex + 2;
+	}
+
+	free(cd->extent);
+	free(cd->point);
+	cd->nextent = 0;
+	cd->npoint = 0;
+	cd->extent = stats_malloc((3 * cd->ntrack + 1) * sizeof(CdExtent));
+	cd->point = stats_malloc((npoint + 1) * sizeof(CdPoint));
+	if (NULL == cd->extent || NULL == cd->point) {
+		fprintf(stderr, "unable to create layout\n");
+		return -1;
+	}
+
+	/* the pregap silence, file data and postgap silence of each track */
+	for (i = 0; i < cd->ntrack; i++) {
+		track = cd->track[i];
+		if (0 != cd_layout_points(cd, track, i + 1, frame, origin)) {
+			return -1;
+		}
+		cd_layout_add(cd, &frame, i + 1, NULL, -1, 0,
+		              track->zero_pre.length);
+		if (NULL != track->file.name && 0 == track->file.length) {
+			return -1;
+		}
+		origin = frame - track->file.start;
+		cd_layout_add(cd, &frame, i + 1, track->file.name,
+		              track->data_offset + track->file.start
+		              * track_get_block_size(track),
+		              track_get_block_size(track), track->file.length);
+		cd_layout_add(cd, &frame, i + 1, NULL, -1, 0,
+		              track->zero_post.length);
+	}
+
+	return 0;
+}
+
+int cd_get_nextent(Cd *cd)
+{
+	return cd->nextent;
+}
+
+CdExtent *cd_get_extent(Cd *cd, int i)
+{
+	return (0 <= i && i < cd->nextent) ? &cd->extent[i] : NULL;
+}
+
+int cd_frame_to_source(Cd *cd, long frame, long *offset)
+{
+	CdExtent *e = NULL;
+	int lo = 0;
+	int hi = cd->nextent;
+	int mid;
+
+	/* the last extent starting at or before frame */
+	while (1 < hi - lo) {
+		mid = (lo + hi) / 2;
+		if (cd->extent[mid].frame <= frame) {
+			lo = mid;
+		} else {
+			hi = mid;
+		}
+	}
+
+	if (0 == cd->nextent || frame < cd->extent[lo].frame
+	    || frame >= cd->extent[lo].frame + cd->extent[lo].length) {
+		return -1;
+	}
+
+	e = &cd->extent[lo];
+	*offset = (NULL == e->filename) ? -1
+	          : e->offset + (frame - e->frame) * e->block;
+
+	return lo;
+}
+
+int cd_locate(Cd *cd, long frame, int *trackno, int *index)
+{
+	int lo = -1;
+	int hi = cd->npoint;
+	int mid;
+
+	/* the last point at or before frame */
+	while (1 < hi - lo) {
+		mid = (lo + hi) / 2;
+		if (cd->point[mid].frame <= frame) {
+			lo = mid;
+		} else {
+			hi = mid;
+		}
+	}
+
+	*trackno = (0 <= lo) ? cd->point[lo].trackno : 0;
+	*index = (0 <= lo) ? cd->point[lo].index : 0;
+
+	return lo;
+}
+
+int cd_get_npoint(Cd *cd)
+{
+	return cd->npoint;
+}
+
+CdPoint *cd_get_point(Cd *cd, int i)
+{
+	return (0 <= i && i < cd->npoint) ? &cd->point[i] : NULL;
+}
+
+void cd_iter_init(CdIter *it, Cd *cd, long frame)
+{
+	it->cd = cd;
+	it->frame = frame;
+	it->point = cd_locate(cd, frame, &it->trackno, &it->index);
+}
+
+int cd_iter_advance(CdIter *it, long n)
+{
+	CdPoint *point = it->cd->point;
+	int i = it->point;
+
+	it->frame += n;
+	if (0 > n) {
+		/* seeking back */
+		it->point = cd_locate(it->cd, it->frame, &it->trackno,
+		                      &it->index);
+		return i != it->point;
+	}
+
+	while (i + 1 < it->cd->npoint && point[i + 1].frame <= it->frame) {
+		i++;
+	}
+	if (i == it->point) {
+		return 0;
+	}
+
+	it->point = i;
+	it->trackno = point[i].trackno;
+	it->index = point[i].index;
+
+	return 1;
+}
+
+/* a NULL string is the same as an empty one */
+static int cd_str_differ(char *a, char *b)
+{
+	return 0 != strcmp((NULL != a) ? a : "", (NULL != b) ? b : "");
+}
+
+/* 1 << pti for each field that differs */
+static long cd_cdtext_diff(Cdtext *a, Cdtext *b)
+{
+	long bits = 0;
+	int pti;
+
+	for (pti = 0; pti < PTI_END; pti++) {
+		if (cd_str_differ(cdtext_get(pti, a), cdtext_get(pti, b))) {
+			bits |= 1L << pti;
+		}
+	}
+
+	return bits;
+}
+
+static int cd_track_diff(Track *a, Track *b, CdDiff *diff, int i)
+{
+	int changed = 0;
+	int j;
+
+	if (cd_str_differ(a->file.name, b->file.name)) {
+		changed |= DIFF_FILE;
+	}
+
+	if (a->filetype != b->filetype
+	    || a->mode != b->mode || a->sub_mode != b->sub_mode
+	    || a->file.start != b->file.start
+	    || a->file.length != b->file.length
+	    || a->zero_pre.length != b->zero_pre.length
+	    || a->zero_post.length != b->zero_post.length
+	    || a->pregap_start != b->pregap_start
+	    || a->nindex != b->nindex) {
+		changed |= DIFF_LAYOUT;
+	}
+	for (j = 0; j < a->nindex && j < b->nindex; j++) {
+		if (a->index[j] != b->index[j]) {
+			changed |= DIFF_LAYOUT;
+		}
+	}
+
+	if (0 != (diff->flags[i] = a->flags ^ b->flags)) {
+		changed |= DIFF_FLAGS;
+	}
+	if (cd_str_differ(a->isrc, b->isrc)) {
+		changed |= DIFF_ISRC;
+	}
+	if (0 != (diff->cdtext[i] = cd_cdtext_diff(a->cdtext, b->cdtext))) {
+		changed |= DIFF_CDTEXT;
+	}
+
+	return changed;
+}
+
+int cd_diff(Cd *a, Cd *b, CdDiff *diff)
+{
+	int count = 0;
+	int i;
+
+	memset(diff, 0, sizeof(CdDiff));
+	diff->ntrack = (a->ntrack > b->ntrack) ? a->ntrack : b->ntrack;
+
+	if (a->mode != b->mode) {
+		diff->changed[0] |= DIFF_LAYOUT;
+	}
+	if (cd_str_differ(a->catalog, b->catalog)) {
+		diff->changed[0] |= DIFF_ISRC;
+	}
+	if (0 != (diff->cdtext[0] = cd_cdtext_diff(a->cdtext, b->cdtext))) {
+		diff->changed[0] |= DIFF_CDTEXT;
+	}
+
+	for (i = 1; i <= diff->ntrack; i++) {
+		if (i > a->ntrack) {
+			diff->changed[i] = DIFF_ADDED;
+		} else if (i > b->ntrack) {
+			diff->changed[i] = DIFF_REMOVED;
+		} else {
+			diff->changed[i] = cd_track_diff(a->track[i - 1],
+			                                 b->track[i - 1], diff, i);
+		}
+	}
+
+	for (i = 0; i <= diff->ntrack; i++) {
+		count += (0 != diff->changed[i]);
+	}
+
+	return count;
+}
+
 /*
  * track structure functions
  */
 
 void track_set_filename(Track *track, char *filename)
 {
+	int phase = stats_phase(PHASE_BUILD);
+
 	if (track->file.name) {
 		free(track->file.name);
 	}
 
-	track->file.name = strdup(filename);
+	track->file.name = stats_strdup(filename);
+	stats_phase(phase);
 }
 
 char *track_get_filename(Track *track)
@@ -171,6 +564,26 @@ char *track_get_filename(Track *track)
 	return track->file.name;
 }
 
+void track_set_filetype(Track *track, int filetype)
+{
+	track->filetype = filetype;
+}
+
+int track_get_filetype(Track *track)
+{
+	return track->filetype;
+}
+
+void track_set_data_offset(Track *track, long offset)
+{
+	track->data_offset = offset;
+}
+
+long track_get_data_offset(Track *track)
+{
+	return track->data_offset;
+}
+
 void track_set_start(Track *track, long start)
 {
 	track->file.start = start;
@@ -201,6 +614,23 @@ int track_get_mode(Track *track)
 	return track->mode;
 }
 
+long track_get_block_size(Track *track)
+{
+	switch (track->mode) {
+	case MODE_MODE1:
+	case MODE_MODE2_FORM1:
+		return 2048;
+	case MODE_MODE2:
+		return 2336;
+	case MODE_MODE2_FORM2:
+		return 2324;
+	case MODE_MODE2_FORM_MIX:
+		return 2332;
+	}
+
+	return 2352;
+}
+
 void track_set_sub_mode(Track *track, int sub_mode)
 {
 	track->sub_mode = sub_mode;
@@ -236,6 +666,16 @@ long track_get_zero_pre(Track *track)
 	return track->zero_pre.length;
 }
 
+void track_set_pregap_start(Track *track, long start)
+{
+	track->pregap_start = start;
+}
+
+long track_get_pregap_start(Track *track)
+{
+	return track->pregap_start;
+}
+
 void track_set_zero_post(Track *track, long length)
 {
 	track->zero_post.length = length;
@@ -247,11 +687,14 @@ long track_get_zero_post(Track *track)
 }
 void track_set_isrc(Track *track, char *isrc)
 {
+	int phase = stats_phase(PHASE_BUILD);
+
 	if (track->isrc) {
 		free(track->isrc);
 	}
 
-	track->isrc = strdup(isrc);
+	track->isrc = stats_strdup(isrc);
+	stats_phase(phase);
 }
 
 char *track_get_isrc(Track *track)
@@ -266,6 +709,8 @@ Cdtext *track_get_cdtext(Track *track)
 
 void track_add_index(Track *track, long index)
 {
+	int phase = stats_phase(PHASE_BUILD);
+
 	if (MAXINDEX > track->nindex) {
 		track->nindex++;
 	} else {
@@ -274,6 +719,7 @@ void track_add_index(Track *track, long index)
 
 	/* this will overwrite last index if there were too many */
 	track->index[track->nindex - 1] = index;
+	stats_phase(phase);
 }
 
 int track_get_nindex(Track *track)
@@ -299,9 +745,11 @@ void cd_track_dump(Track *track)
 
 	printf("zero_pre: %ld\n", track->zero_pre.length);
 	printf("filename: %s\n", track->file.name);
+	printf("filetype: %d\n", track->filetype);
 	printf("start: %ld\n", track->file.start);
 	printf("length: %ld\n", track->file.length);
 	printf("zero_post: %ld\n", track->zero_post.length);
+	printf("pregap_start: %ld\n", track->pregap_start);
 	printf("mode: %d\n", track->mode);
 	printf("sub_mode: %d\n", track->sub_mode);
 	printf("flags: 0x%x\n", track->flags);
@@ -325,6 +773,7 @@ void cd_dump(Cd *cd)
 	printf("Disc Info\n");
 	printf("mode: %d\n", cd->mode);
 	printf("catalog: %s\n", cd->catalog);
+	printf("cdtextfile: %s\n", cd->cdtextfile);
 	if (NULL != cd->cdtext) {
 		printf("cdtext:\n");
 		cdtext_dump(cd->cdtext, 0);
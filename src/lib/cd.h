@@ -65,6 +65,30 @@ enum TrackFlag {
 	FLAG_ANY		= 0xff	/* any flags set */
 };
 
+/*
+ * data file types
+ * the FILE types of a cue sheet
+ */
+enum FileType {
+	FILE_UNKNOWN,		/* not given (toc audio files) */
+	FILE_BINARY,		/* raw, little-endian samples */
+	FILE_MOTOROLA,		/* raw, big-endian samples */
+	FILE_AIFF,
+	FILE_WAVE,
+	FILE_MP3
+};
+
+/* what cd_diff() found changed */
+enum Diff {
+	DIFF_ADDED	= 0x01,	/* track only in the second Cd */
+	DIFF_REMOVED	= 0x02,	/* track only in the first Cd */
+	DIFF_FILE	= 0x04,	/* data file name */
+	DIFF_LAYOUT	= 0x08,	/* file type, mode, start, length, gaps, indexes */
+	DIFF_FLAGS	= 0x10,
+	DIFF_ISRC	= 0x20,	/* ISRC, or catalog number of the disc */
+	DIFF_CDTEXT	= 0x40
+};
+
 enum DataType {
 	DATA_AUDIO,
 	DATA_DATA,
@@ -76,9 +100,50 @@ enum DataType {
 typedef struct Cd Cd;
 typedef struct Track Track;
 
+/* a run of disc frames that come from one place (see cd_layout()) */
+typedef struct CdExtent CdExtent;
+struct CdExtent {
+	long frame;		/* first disc frame */
+	long length;		/* frames */
+	int trackno;
+	char *filename;		/* NULL for generated silence */
+	long offset;		/* byte offset of the first frame in the file */
+	long block;		/* bytes per frame in the file */
+};
+
+/* where a track or index starts on the disc (see cd_layout()) */
+typedef struct CdPoint CdPoint;
+struct CdPoint {
+	long frame;
+	int trackno;
+	int index;
+};
+
+/* a playback position; see cd_iter_init() */
+typedef struct CdIter CdIter;
+struct CdIter {
+	Cd *cd;
+	long frame;		/* current disc frame */
+	int point;		/* current point, -1 before the first */
+	int trackno;		/* 0 before the first track */
+	int index;
+};
+
+/* the differences between two Cds: entry 0 is the disc, then each track */
+typedef struct CdDiff CdDiff;
+struct CdDiff {
+	int ntrack;			/* of the Cd with more */
+	int changed[MAXTRACK + 1];	/* enum Diff bits */
+	int flags[MAXTRACK + 1];	/* enum TrackFlag bits that differ */
+	long cdtext[MAXTRACK + 1];	/* 1 << pti for each field that differs */
+};
+
 /* return pointer to CD structure */
 Cd *cd_init();
 
+/* release CD structure and all of its tracks */
+void cd_delete(Cd *cd);
+
 /* dump all info from CD structure
  * in human readable format (for debugging)
  */
@@ -94,6 +159,10 @@ int cd_get_mode(Cd *cd);
 void cd_set_catalog(Cd *cd, char *catalog);
 char *cd_get_catalog(Cd *cd);
 
+/* name of a file of binary CD-TEXT packs (see cdt.h) */
+void cd_set_cdtextfile(Cd *cd, char *cdtextfile);
+char *cd_get_cdtextfile(Cd *cd);
+
 /*
  * return pointer to cd's Cdtext
  */
@@ -101,7 +170,7 @@ Cdtext *cd_get_cdtext(Cd *cd);
 
 /*
  * add a new track to cd, increment number of tracks
- * and return pointer to new track
+ * and return pointer to new track, or NULL if cd already has MAXTRACK
  */
 Track *cd_add_track(Cd *cd);
 
@@ -112,6 +181,50 @@ int cd_get_ntrack(Cd *cd);
 
 Track *cd_get_track(Cd *cd, int i);
 
+/*
+ * lay out the tracks of cd as one run of frames, from the pregap of
+ * track 1, in a table of extents of silence and file data, and a sorted
+ * table of the points where each track and index starts
+ * call again after changing the tracks.  returns -1 if the length of a
+ * track is unknown, or with a message if an index is out of order, such as
+ * one before the start of its track; the tracks up to it are laid out
+ */
+int cd_layout(Cd *cd);
+int cd_get_nextent(Cd *cd);
+CdExtent *cd_get_extent(Cd *cd, int i);
+
+/*
+ * find where disc frame comes from, by binary search of the layout
+ * returns the index of its extent and sets *offset to the byte offset of
+ * the frame in the file (-1 for silence), or returns -1 off the disc
+ */
+int cd_frame_to_source(Cd *cd, long frame, long *offset);
+
+/*
+ * find the track and index that disc frame is in, by binary search of
+ * the layout; a frame past the end is in the last index of the last track
+ * returns the number of the point in the table, or -1 (with *trackno and
+ * *index 0) before the first point
+ */
+int cd_locate(Cd *cd, long frame, int *trackno, int *index);
+int cd_get_npoint(Cd *cd);
+CdPoint *cd_get_point(Cd *cd, int i);
+
+/*
+ * step through the disc during playback
+ * cd_iter_init() locates frame once; cd_iter_advance() moves n frames on
+ * in O(1) for small n, and returns 1 if the track or index changed
+ */
+void cd_iter_init(CdIter *it, Cd *cd, long frame);
+int cd_iter_advance(CdIter *it, long n);
+
+/*
+ * compare a and b field by field, track by track
+ * a missing string and an empty one are the same
+ * returns the number of entries (disc and tracks) that changed
+ */
+int cd_diff(Cd *a, Cd *b, CdDiff *diff);
+
 /*
  * Track functions
  */
@@ -120,6 +233,14 @@ Track *cd_get_track(Cd *cd, int i);
 void track_set_filename(Track *track, char *filename);
 char *track_get_filename(Track *track);
 
+/* see enum FileType */
+void track_set_filetype(Track *track, int filetype);
+int track_get_filetype(Track *track);
+
+/* bytes before frame 0 of the data file, such as a WAVE header */
+void track_set_data_offset(Track *track, long offset);
+long track_get_data_offset(Track *track);
+
 /* track start is starting position in data file */
 void track_set_start(Track *track, long start);
 long track_get_start(Track *track);
@@ -132,6 +253,9 @@ long track_get_length(Track *track);
 void track_set_mode(Track *track, int mode);
 int track_get_mode(Track *track);
 
+/* bytes per frame in the data file, by track mode */
+long track_get_block_size(Track *track);
+
 /* see enum TrackSubMode */
 void track_set_sub_mode(Track *track, int sub_mode);
 int track_get_sub_mode(Track *track);
@@ -145,6 +269,15 @@ int track_is_set_flag(Track *track, int flag);
 void track_set_zero_pre(Track *track, long length);
 long track_get_zero_pre(Track *track);
 
+/*
+ * where index 0 starts in the file of the track before, when a cue sheet
+ * has the pregap at the end of that file and index 1 in a file of the
+ * track's own; -1 if not.  the track before then runs to the end of its
+ * file, pregap and all
+ */
+void track_set_pregap_start(Track *track, long start);
+long track_get_pregap_start(Track *track);
+
 /* zero data postgap */
 void track_set_zero_post(Track *track, long length);
 long track_get_zero_post(Track *track);
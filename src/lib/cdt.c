@@ -0,0 +1,742 @@
+/*
+ * cdt.c -- binary CD-TEXT packs, as in a CDTEXTFILE
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_ICONV
+#include <iconv.h>
+#endif
+#include "cdt.h"
+#include "charset.h"
+#include "crc.h"
+
+#define CDT_TEXT	12	/* bytes of text in a pack */
+#define CDT_MAXTEXT	(CDT_MAXPACK * CDT_TEXT)
+#define CDT_SIZE_PACKS	3	/* of PTI_SIZE_INFO */
+#define CDT_SIZE_BYTES	(CDT_SIZE_PACKS * CDT_TEXT)
+#define CDT_HEADER	4	/* of a file: length, and two zero bytes */
+#define CDT_GENRE_NONE	0x0001	/* genre code "not defined" */
+
+/* the pack type of a PTI */
+#define CDT_TYPE(pti)	(0x80 + (pti))
+
+/* the PTIs of text, in the order of their packs */
+static const int cdt_text_ptis[] = {
+	PTI_TITLE, PTI_PERFORMER, PTI_SONGWRITER, PTI_COMPOSER, PTI_ARRANGER,
+	PTI_MESSAGE, PTI_DISC_ID, PTI_GENRE, PTI_UPC_ISRC, PTI_END
+};
+
+/* the packs of a block as they are encoded */
+typedef struct CdtEncoder CdtEncoder;
+struct CdtEncoder {
+	int block;
+	int dbcc;		/* double byte character code */
+	int npack;
+	int count[PTI_END];	/* packs of each PTI */
+	unsigned char *size;	/* where the PTI_SIZE_INFO packs go */
+};
+
+static void cdt_set_crc(unsigned char *pack)
+{
+	uint16_t crc = ~crc16_update(0, pack, CDT_PACK_SIZE - 2);
+
+	pack[16] = crc >> 8;
+	pack[17] = crc & 0xFF;
+}
+
+static int cdt_crc_ok(const unsigned char *pack)
+{
+	uint16_t crc = ~crc16_update(0, pack, CDT_PACK_SIZE - 2);
+
+	return pack[16] == (crc >> 8) && pack[17] == (crc & 0xFF);
+}
+
+/* PTIs that are given for the disc but not for each track */
+static int cdt_disc_only(int pti)
+{
+	return PTI_DISC_ID == pti || PTI_GENRE == pti;
+}
+
+/*
+ * the text of a PTI for the disc and each track, each string ended by a
+ * zero character; start is set to where each string starts
+ * returns its length, 0 if no string is set, or -1 if there is too much
+ */
+static long cdt_stream(CdtBlock *block, int pti, int nstring,
+                       unsigned char *text, long *start)
+{
+	const char *s = NULL;
+	const char *prev = NULL;
+	int width = (CDT_MS_JIS == block->charset) ? 2 : 1;
+	long len = 0;
+	long n;
+	int any = 0;
+	int trackno;
+	int i;
+
+	for (i = 0; i < nstring; i++) {
+		trackno = (0 == i) ? 0 : block->first + i - 1;
+		s = (NULL != block->cdtext[trackno])
+		    ? cdtext_get(pti, block->cdtext[trackno]) : NULL;
+		if (NULL == s) {
+			s = "";
+		}
+		start[i] = len;
+
+		if (PTI_GENRE == pti) {
+			text[len++] = CDT_GENRE_NONE >> 8;
+			text[len++] = CDT_GENRE_NONE & 0xFF;
+		}
+
+		/* a tab is the same text as the track before */
+		n = strlen(s);
+		if (1 < i && '\0' != *s && 0 == strcmp(s, prev)) {
+			n = width;
+			memcpy(text + len, "\t\t", n);
+		} else if (CDT_MAXTEXT >= len + n) {
+			memcpy(text + len, s, n);
+		}
+		prev = s;
+		any |= (0 != n);
+
+		/* double byte text ends on an even byte */
+		len += n + (n % width);
+		if (CDT_MAXTEXT < len + width) {
+			fprintf(stderr, "too much CD-TEXT for a block\n");
+			return -1;
+		}
+		memset(text + len - (n % width), 0, (n % width) + width);
+		len += width;
+	}
+
+	return any ? len : 0;
+}
+
+/* the packs of a PTI's text */
+static int cdt_text_packs(CdtEncoder *e, unsigned char **out,
+                          CdtBlock *block, int pti, unsigned char *text,
+                          long len, long *start, int nstring)
+{
+	unsigned char *p = NULL;
+	int width = e->dbcc ? 2 : 1;
+	long chars;
+	long pos;
+	int n;
+	int i = 0;
+
+	for (pos = 0; pos < len; pos += CDT_TEXT) {
+		if (CDT_MAXPACK - CDT_SIZE_PACKS <= e->npack) {
+			fprintf(stderr, "too much CD-TEXT for a block\n");
+			return -1;
+		}
+		while (i + 1 < nstring && start[i + 1] <= pos) {
+			i++;
+		}
+
+		/* the characters of the string in the packs before */
+		if (15 < (chars = (pos - start[i]) / width)) {
+			chars = 15;
+		}
+
+		p = *out;
+		p[0] = CDT_TYPE(pti);
+		p[1] = (0 == i) ? 0 : block->first + i - 1;
+		p[2] = e->npack;
+		p[3] = e->dbcc << 7 | e->block << 4 | chars;
+		n = (CDT_TEXT < len - pos) ? CDT_TEXT : len - pos;
+		memcpy(p + 4, text + pos, n);
+		memset(p + 4 + n, 0, CDT_TEXT - n);
+		cdt_set_crc(p);
+
+		*out += CDT_PACK_SIZE;
+		e->npack++;
+		e->count[pti]++;
+	}
+
+	return 0;
+}
+
+/* the PTI_SIZE_INFO packs of a block, once the packs of all are known */
+static void cdt_size_packs(CdtEncoder *e, CdtEncoder *all, CdtBlock *block,
+                           int nblock)
+{
+	unsigned char info[CDT_SIZE_BYTES];
+	unsigned char *p = NULL;
+	int i;
+
+	memset(info, 0, sizeof(info));
+	info[0] = block[e->block].charset;
+	info[1] = block[e->block].first;
+	info[2] = block[e->block].last;
+	for (i = 0; i < PTI_END; i++) {
+		info[4 + i] = e->count[i];
+	}
+	for (i = 0; i < nblock; i++) {
+		info[20 + i] = all[i].npack - 1;
+		info[28 + i] = block[i].language;
+	}
+
+	for (i = 0; i < CDT_SIZE_PACKS; i++) {
+		p = e->size + i * CDT_PACK_SIZE;
+		p[0] = CDT_TYPE(PTI_SIZE_INFO);
+		p[1] = i;
+		p[2] = e->npack - CDT_SIZE_PACKS + i;
+		p[3] = e->dbcc << 7 | e->block << 4;
+		memcpy(p + 4, info + i * CDT_TEXT, CDT_TEXT);
+		cdt_set_crc(p);
+	}
+}
+
+long cdt_encode(CdtBlock *block, int nblock, unsigned char **packs)
+{
+	CdtEncoder e[CDT_MAXBLOCK];
+	long start[MAXTRACK + 1];
+	unsigned char *text = NULL;
+	unsigned char *out = NULL;
+	long len;
+	int nstring;
+	int ret = 0;
+	int b;
+	int i;
+
+	if (0 >= nblock || CDT_MAXBLOCK < nblock) {
+		fprintf(stderr, "CD-TEXT has 1 to %d blocks\n", CDT_MAXBLOCK);
+		return -1;
+	}
+
+	*packs = malloc(nblock * CDT_MAXPACK * CDT_PACK_SIZE);
+	text = malloc(CDT_MAXTEXT + 2 * CDT_TEXT);
+	if (NULL == *packs || NULL == text) {
+		fprintf(stderr, "unable to allocate memory\n");
+		free(*packs);
+		free(text);
+		return -1;
+	}
+	out = *packs;
+
+	memset(e, 0, sizeof(e));
+	for (b = 0; b < nblock && 0 == ret; b++) {
+		e[b].block = b;
+		e[b].dbcc = (CDT_MS_JIS == block[b].charset);
+		if (1 > block[b].first || block[b].first > block[b].last
+		    || MAXTRACK < block[b].last) {
+			fprintf(stderr, "CD-TEXT block %d: bad tracks\n", b);
+			ret = -1;
+		}
+
+		for (i = 0; 0 == ret && PTI_END != cdt_text_ptis[i]; i++) {
+			nstring = cdt_disc_only(cdt_text_ptis[i])
+			          ? 1 : 2 + block[b].last - block[b].first;
+			len = cdt_stream(&block[b], cdt_text_ptis[i], nstring,
+			                 text, start);
+			if (0 > len || 0 != cdt_text_packs(&e[b], &out,
+			                                     &block[b],
+			                                     cdt_text_ptis[i],
+			                                     text, len, start,
+			                                     nstring)) {
+				ret = -1;
+			}
+		}
+
+		/* room for the size, filled in below */
+		e[b].size = out;
+		e[b].npack += CDT_SIZE_PACKS;
+		e[b].count[PTI_SIZE_INFO] = CDT_SIZE_PACKS;
+		out += CDT_SIZE_PACKS * CDT_PACK_SIZE;
+	}
+	free(text);
+
+	if (0 != ret) {
+		free(*packs);
+		*packs = NULL;
+		return -1;
+	}
+
+	for (b = 0; b < nblock; b++) {
+		cdt_size_packs(&e[b], e, block, nblock);
+	}
+
+	return out - *packs;
+}
+
+/* set the strings of a PTI from the text of its packs */
+static int cdt_set_text(CdtBlock *block, int pti, int trackno, int dbcc,
+                        unsigned char *text, long len)
+{
+	char s[CDT_MAXTEXT + 1];
+	int width = dbcc ? 2 : 1;
+	long prev = -1;		/* where the last string started */
+	long pos = 0;
+	long next;
+	long end;
+
+	/* the genre code is not kept */
+	if (PTI_GENRE == pti) {
+		pos = 2;
+	}
+
+	for (; pos < len && MAXTRACK >= trackno; trackno++) {
+		for (end = pos; end + width <= len && ('\0' != text[end]
+		     || (2 == width && '\0' != text[end + 1])); end += width) {
+			;
+		}
+		if (end + width > len) {
+			break;		/* not ended: padding */
+		}
+		next = end + width;
+
+		if ((1 == width && 1 == end - pos && '\t' == text[pos])
+		    || (2 == width && 2 == end - pos && '\t' == text[pos]
+		        && '\t' == text[pos + 1])) {
+			if (0 > prev) {
+				return -1;
+			}
+			pos = prev;
+			for (end = pos; '\0' != text[end]; end++) {
+				;
+			}
+		}
+		memcpy(s, text + pos, end - pos);
+		s[end - pos] = '\0';
+
+		if ('\0' != s[0]) {
+			if (NULL == block->cdtext[trackno]
+			    && NULL == (block->cdtext[trackno] = cdtext_init())) {
+				return -1;
+			}
+			cdtext_set(pti, s, block->cdtext[trackno]);
+			if (0 < trackno && (0 == block->first
+			                    || trackno < block->first)) {
+				block->first = trackno;
+			}
+			if (trackno > block->last) {
+				block->last = trackno;
+			}
+		}
+
+		prev = pos;
+		pos = next;
+	}
+
+	return 0;
+}
+
+int cdt_decode(const unsigned char *packs, size_t size, CdtBlock *block)
+{
+	unsigned char text[CDT_MAXTEXT];
+	unsigned char info[CDT_MAXBLOCK][CDT_SIZE_BYTES];
+	int have_info[CDT_MAXBLOCK];
+	const unsigned char *p = NULL;
+	long len = 0;
+	int type = -1;		/* of the run of packs */
+	int b = -1;
+	int trackno = 0;
+	int dbcc = 0;
+	int nblock = 0;
+	int ret = 0;
+	size_t i;
+
+	memset(block, 0, CDT_MAXBLOCK * sizeof(CdtBlock));
+	memset(have_info, 0, sizeof(have_info));
+
+	if (0 != size % CDT_PACK_SIZE) {
+		fprintf(stderr, "CD-TEXT is not a whole number of packs\n");
+		return -1;
+	}
+
+	for (i = 0; i <= size && 0 == ret; i += CDT_PACK_SIZE) {
+		p = packs + i;
+
+		/* the end of a run of packs of one type */
+		if (0 <= type && (i == size || p[0] != CDT_TYPE(type)
+		                  || (p[3] >> 4 & 7) != b)) {
+			if (PTI_SIZE_INFO != type
+			    && 0 != cdt_set_text(&block[b], type, trackno, dbcc,
+			                         text, len)) {
+				fprintf(stderr, "unable to decode CD-TEXT\n");
+				ret = -1;
+			}
+			type = -1;
+		}
+		if (i == size || 0 != ret) {
+			break;
+		}
+
+		if (!cdt_crc_ok(p)) {
+			fprintf(stderr, "CD-TEXT pack %ld: CRC error\n",
+			        (long) (i / CDT_PACK_SIZE));
+			ret = -1;
+		} else if (CDT_TYPE(0) > p[0] || CDT_TYPE(PTI_SIZE_INFO) < p[0]) {
+			fprintf(stderr, "CD-TEXT pack %ld: unknown type %#x\n",
+			        (long) (i / CDT_PACK_SIZE), p[0]);
+			ret = -1;
+		} else if (0 > type) {
+			type = p[0] - CDT_TYPE(0);
+			b = p[3] >> 4 & 7;
+			dbcc = p[3] >> 7;
+			trackno = p[1] & 0x7F;
+			len = 0;
+			if (b >= nblock) {
+				nblock = b + 1;
+			}
+			if (dbcc) {
+				block[b].charset = CDT_MS_JIS;
+			}
+		}
+		if (0 != ret) {
+			break;
+		}
+
+		if (PTI_SIZE_INFO == type) {
+			if (CDT_SIZE_PACKS > p[1]) {
+				memcpy(info[b] + p[1] * CDT_TEXT, p + 4, CDT_TEXT);
+				have_info[b] |= 1 << p[1];
+			}
+		} else if (CDT_MAXTEXT >= len + CDT_TEXT) {
+			memcpy(text + len, p + 4, CDT_TEXT);
+			len += CDT_TEXT;
+		}
+	}
+
+	if (0 != ret) {
+		cdt_free(block, CDT_MAXBLOCK);
+		return -1;
+	}
+
+	/* the size information says what the text does not */
+	for (b = 0; b < nblock; b++) {
+		if ((1 << CDT_SIZE_PACKS) - 1 == have_info[b]) {
+			block[b].charset = info[b][0];
+			block[b].first = info[b][1];
+			block[b].last = info[b][2];
+			block[b].language = info[b][28 + b];
+		}
+	}
+
+	return nblock;
+}
+
+void cdt_free(CdtBlock *block, int nblock)
+{
+	int b;
+	int i;
+
+	for (b = 0; b < nblock; b++) {
+		for (i = 0; i <= MAXTRACK; i++) {
+			cdtext_delete(block[b].cdtext[i]);
+			block[b].cdtext[i] = NULL;
+		}
+	}
+}
+
+/* UTF-8 to ISO 8859-1, or ASCII if max is 0x7F */
+static void cdt_latin1(const char *s, char *out, size_t size,
+                       unsigned long max)
+{
+	const unsigned char *p = (const unsigned char *) s;
+	unsigned long c;
+	size_t n = 0;
+	int k;
+
+	while ('\0' != *p && n + 1 < size) {
+		if (0x80 > *p) {
+			c = *p++;
+		} else {
+			k = (0xC0 == (*p & 0xE0)) ? 1 : (0xE0 == (*p & 0xF0)) ? 2
+			    : (0xF0 == (*p & 0xF8)) ? 3 : 0;
+			c = *p++ & (0x3F >> k);
+			for (; 0 < k && 0x80 == (*p & 0xC0); k--) {
+				c = c << 6 | (*p++ & 0x3F);
+			}
+			if (0 != k || 0x80 > c) {
+				c = '?';	/* not UTF-8 */
+			}
+		}
+		out[n++] = (max >= c) ? (char) c : '?';
+	}
+	out[n] = '\0';
+}
+
+#ifdef HAVE_ICONV
+/* UTF-8 to Shift JIS */
+static void cdt_sjis(iconv_t ic, const char *s, char *out, size_t size)
+{
+	char *ip = (char *) s;
+	char *op = out;
+	size_t ileft = strlen(s);
+	size_t oleft = size - 1;
+
+	while (0 < ileft && (size_t) -1 == iconv(ic, &ip, &ileft, &op, &oleft)
+	       && E2BIG != errno && 0 < oleft) {
+		/* a character Shift JIS has not */
+		*op++ = '?';
+		oleft--;
+		for (ip++, ileft--; 0 < ileft && 0x80 == (*ip & 0xC0);
+		     ip++, ileft--) {
+			;
+		}
+	}
+	iconv(ic, NULL, NULL, NULL, NULL);
+	*op = '\0';
+}
+#endif
+
+int cdt_from_cd(CdtBlock *block, Cd *cd, int language, int charset)
+{
+	char out[CDT_MAXTEXT + 1];
+	Cdtext *cdtext = NULL;
+	char *code = NULL;
+	char *value = NULL;
+	int jis = 0;		/* can convert to MS-JIS */
+	int ret = 0;
+	int pti;
+	int i;
+#ifdef HAVE_ICONV
+	iconv_t ic = (iconv_t) -1;
+
+	if (CDT_MS_JIS == charset
+	    && (iconv_t) -1 == (ic = iconv_open("CP932", "UTF-8"))) {
+		ic = iconv_open("SHIFT_JIS", "UTF-8");
+	}
+	jis = ((iconv_t) -1 != ic);
+#endif
+
+	if (CDT_MS_JIS == charset && !jis) {
+		fprintf(stderr, "unable to convert CD-TEXT to MS-JIS\n");
+		return -1;
+	}
+
+	memset(block, 0, sizeof(CdtBlock));
+	block->language = language;
+	block->charset = charset;
+	block->first = 1;
+	block->last = cd_get_ntrack(cd);
+
+	for (i = 0; i <= cd_get_ntrack(cd) && 0 == ret; i++) {
+		if (0 == i) {
+			cdtext = cd_get_cdtext(cd);
+			code = cd_get_catalog(cd);
+		} else {
+			cdtext = track_get_cdtext(cd_get_track(cd, i));
+			code = track_get_isrc(cd_get_track(cd, i));
+		}
+		if (0 == cdtext_is_empty(cdtext) && NULL == code) {
+			continue;
+		}
+		if (NULL == (block->cdtext[i] = cdtext_init())) {
+			ret = -1;
+			break;
+		}
+
+		for (pti = 0; PTI_END != pti; pti++) {
+			value = cdtext_get(pti, cdtext);
+			if (PTI_UPC_ISRC == pti && NULL == value) {
+				value = code;
+			}
+			if (NULL == value) {
+				continue;
+			}
+#ifdef HAVE_ICONV
+			if (CDT_MS_JIS == charset) {
+				cdt_sjis(ic, value, out, sizeof(out));
+			}
+#endif
+			if (CDT_MS_JIS != charset) {
+				cdt_latin1(value, out, sizeof(out),
+				           (CDT_ASCII == charset) ? 0x7F : 0xFF);
+			}
+			cdtext_set(pti, out, block->cdtext[i]);
+		}
+	}
+
+#ifdef HAVE_ICONV
+	if ((iconv_t) -1 != ic) {
+		iconv_close(ic);
+	}
+#endif
+	if (0 != ret) {
+		cdt_free(block, 1);
+	}
+
+	return ret;
+}
+
+/* text of a block to UTF-8 */
+static int cdt_utf8(Converter *cv, const char *s, char *out, size_t size)
+{
+	const char *part = NULL;
+	size_t len;
+	size_t n = 0;
+
+	if (NULL == (part = converter_feed(cv, s, strlen(s), &len))) {
+		return -1;
+	}
+	len = (size - 1 < len) ? size - 1 : len;
+	memcpy(out, part, len);
+	n = len;
+
+	if (NULL == (part = converter_finish(cv, &len))) {
+		return -1;
+	}
+	len = (size - 1 - n < len) ? size - 1 - n : len;
+	memcpy(out + n, part, len);
+	out[n + len] = '\0';
+
+	return 0;
+}
+
+int cdt_to_cd(CdtBlock *block, Cd *cd)
+{
+	char out[4 * CDT_MAXTEXT + 1];
+	Converter *cv = NULL;
+	Cdtext *cdtext = NULL;
+	char *value = NULL;
+	int trackno;
+	int pti;
+	int i;
+
+	for (i = 0; i <= MAXTRACK; i++) {
+		trackno = (0 == i) ? 0 : i - block->first + 1;
+		if (NULL == block->cdtext[i] || 0 > trackno
+		    || cd_get_ntrack(cd) < trackno) {
+			continue;
+		}
+		cdtext = (0 == trackno) ? cd_get_cdtext(cd)
+		         : track_get_cdtext(cd_get_track(cd, trackno));
+
+		for (pti = 0; PTI_END != pti; pti++) {
+			value = cdtext_get(pti, block->cdtext[i]);
+			if (NULL == value || NULL != cdtext_get(pti, cdtext)) {
+				continue;
+			}
+			cv = converter_new((CDT_MS_JIS == block->charset)
+			                   ? CHARSET_SHIFT_JIS : CHARSET_CP1252);
+			if (NULL == cv
+			    || 0 != cdt_utf8(cv, value, out, sizeof(out))) {
+				converter_delete(cv);
+				return -1;
+			}
+			converter_delete(cv);
+			cdtext_set(pti, out, cdtext);
+		}
+	}
+
+	return 0;
+}
+
+long cdt_read_packs(char *name, unsigned char **packs)
+{
+	size_t max = CDT_HEADER + CDT_MAXBLOCK * CDT_MAXPACK * CDT_PACK_SIZE + 1;
+	size_t size;
+	size_t skip = 0;
+	FILE *fp = NULL;
+	int ret = 0;
+
+	if (NULL == (fp = fopen(name, "rb"))) {
+		fprintf(stderr, "%s: error opening file\n", name);
+		return -1;
+	}
+	if (NULL == (*packs = malloc(max + 1))) {
+		fprintf(stderr, "unable to allocate memory\n");
+		fclose(fp);
+		return -1;
+	}
+	size = fread(*packs, 1, max + 1, fp);
+	if (ferror(fp)) {
+		fprintf(stderr, "%s: error reading file\n", name);
+		ret = -1;
+	}
+	fclose(fp);
+
+	if (CDT_HEADER == size % CDT_PACK_SIZE
+	    || CDT_HEADER + 1 == size % CDT_PACK_SIZE) {
+		skip = CDT_HEADER;
+	}
+	if (1 == (size - skip) % CDT_PACK_SIZE && '\0' == (*packs)[size - 1]) {
+		size--;
+	}
+	size -= skip;
+	if (0 == ret && (max < size || 0 == size || 0 != size % CDT_PACK_SIZE)) {
+		fprintf(stderr, "%s: not a CD-TEXT file\n", name);
+		ret = -1;
+	}
+
+	if (0 != ret) {
+		free(*packs);
+		*packs = NULL;
+		return -1;
+	}
+	memmove(*packs, *packs + skip, size);
+
+	return size;
+}
+
+int cdt_read(char *name, Cd *cd)
+{
+	CdtBlock block[CDT_MAXBLOCK];
+	unsigned char *packs = NULL;
+	long size;
+	int nblock;
+	int ret = 0;
+
+	if (0 > (size = cdt_read_packs(name, &packs))) {
+		return -1;
+	}
+	if (0 > (nblock = cdt_decode(packs, size, block))) {
+		fprintf(stderr, "%s: bad CD-TEXT\n", name);
+		ret = -1;
+	} else {
+		ret = cdt_to_cd(&block[0], cd);
+		cdt_free(block, nblock);
+	}
+	free(packs);
+
+	return ret;
+}
+
+int cdt_write(char *name, CdtBlock *block, int nblock)
+{
+	unsigned char header[CDT_HEADER];
+	unsigned char *packs = NULL;
+	FILE *fp = NULL;
+	long size;
+	int ret = 0;
+
+	if (0 > (size = cdt_encode(block, nblock, &packs))) {
+		return -1;
+	}
+
+	/* the length counts the two zero bytes */
+	header[0] = (size + 2) >> 8;
+	header[1] = (size + 2) & 0xFF;
+	header[2] = 0;
+	header[3] = 0;
+
+	if (NULL == (fp = fopen(name, "wb"))) {
+		fprintf(stderr, "%s: error opening file\n", name);
+		free(packs);
+		return -1;
+	}
+	if (CDT_HEADER != fwrite(header, 1, CDT_HEADER, fp)
+	    || (size_t) size != fwrite(packs, 1, size, fp)) {
+		fprintf(stderr, "%s: error writing file\n", name);
+		ret = -1;
+	}
+	if (0 != fclose(fp)) {
+		fprintf(stderr, "%s: error writing file\n", name);
+		ret = -1;
+	}
+	free(packs);
+
+	return ret;
+}
@@ -0,0 +1,87 @@
+/*
+ * cdt.h -- binary CD-TEXT packs, as in a CDTEXTFILE
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+/* references: MMC-3 draft revision 10g, annex J */
+
+#ifndef CDT_H
+#define CDT_H
+
+#include "cd.h"
+#include "cdtext.h"
+
+#define CDT_PACK_SIZE	18	/* bytes of a pack: 4 header, 12 text, 2 CRC */
+#define CDT_MAXBLOCK	8	/* language blocks on a disc */
+#define CDT_MAXPACK	256	/* packs in a block */
+
+/* character codes of a block */
+enum CdtCharset {
+	CDT_ISO8859_1	= 0x00,
+	CDT_ASCII	= 0x01,	/* ISO 646 */
+	CDT_MS_JIS	= 0x80	/* double byte (Shift JIS) */
+};
+
+/*
+ * a language block: the CD-TEXT of a disc (cdtext[0]) and of tracks first
+ * to last, in the block's character code.  The text of the PTIs from
+ * PTI_TITLE to PTI_MESSAGE, PTI_DISC_ID and PTI_UPC_ISRC is kept, and of
+ * PTI_GENRE the text but not the genre code.  The other PTIs are binary,
+ * and PTI_SIZE_INFO is made anew by cdt_encode().
+ */
+typedef struct CdtBlock CdtBlock;
+struct CdtBlock {
+	int language;		/* language code, as 0x09 for English */
+	int charset;		/* enum CdtCharset */
+	int first;		/* first track */
+	int last;		/* last track */
+	Cdtext *cdtext[MAXTRACK + 1];	/* NULL for none */
+};
+
+/*
+ * encode nblock blocks as packs, with their CRCs, into a new buffer (free
+ * it); returns its size, or -1 if a block has too much text
+ */
+long cdt_encode(CdtBlock *block, int nblock, unsigned char **packs);
+
+/*
+ * decode packs into new Cdtexts in block (free them with cdt_free())
+ * returns the number of blocks, or -1 if a CRC is wrong or the packs are
+ * malformed
+ */
+int cdt_decode(const unsigned char *packs, size_t size, CdtBlock *block);
+
+void cdt_free(CdtBlock *block, int nblock);
+
+/*
+ * make a block of the CD-TEXT of cd, converting the text from UTF-8 to
+ * charset; a character that charset has not is written as ?
+ * returns -1 if memory ran out or charset can not be converted to
+ */
+int cdt_from_cd(CdtBlock *block, Cd *cd, int language, int charset);
+
+/*
+ * set the CD-TEXT of cd that is not set from a block, converting the text
+ * to UTF-8; returns -1 if memory ran out
+ */
+int cdt_to_cd(CdtBlock *block, Cd *cd);
+
+/*
+ * read the packs of a CDTEXTFILE, as CDRWIN and cdrecord write it: after
+ * an optional 4-byte header, and maybe followed by a zero byte.  They are
+ * put in a new buffer (free it); returns their size, or -1 on error
+ */
+long cdt_read_packs(char *name, unsigned char **packs);
+
+/*
+ * read a CDTEXTFILE and merge its first block into cd, as by cdt_to_cd()
+ * returns -1 if the file can not be read or decoded
+ */
+int cdt_read(char *name, Cd *cd);
+
+/* write the packs of nblock blocks, with the 4-byte header; -1 on error */
+int cdt_write(char *name, CdtBlock *block, int nblock);
+
+#endif
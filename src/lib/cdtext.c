@@ -9,6 +9,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "cdtext.h"
+#include "stats.h"
 
 struct Cdtext {
 	int pti;
@@ -40,7 +41,7 @@ Cdtext *cdtext_init()
 		{PTI_END,		FORMAT_CHAR,	NULL}
 	};
 
-	new_cdtext = (Cdtext *) calloc (sizeof (cdtext) / sizeof (Cdtext), sizeof (Cdtext));
+	new_cdtext = (Cdtext *) stats_calloc (sizeof (cdtext) / sizeof (Cdtext), sizeof (Cdtext));
 	if (NULL == new_cdtext) {
 		fprintf (stderr, "problem allocating memory\n");
 	} else {
@@ -77,14 +78,18 @@ int cdtext_is_empty(Cdtext *cdtext)
 /* sets cdtext's pti entry to field */
 void cdtext_set(int pti, char *value, Cdtext *cdtext)
 {
+	int phase = stats_phase(PHASE_BUILD);
+
 	if (NULL != value) {	/* don't pass NULL to strdup */
 		for (; PTI_END != cdtext->pti; cdtext++) {
 			if (pti == cdtext->pti) {
 				free (cdtext->value);
-				cdtext->value = strdup (value);
+				cdtext->value = stats_strdup (value);
 			}
 		}
 	}
+
+	stats_phase(phase);
 }
 
 /* returns value for pti, NULL if pti is not found */
@@ -1,5 +1,5 @@
 /*
- * time.c -- time functions
+ * cdtime.c -- time functions
  *
  * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
  * For license terms, see the file COPYING in this distribution.
@@ -0,0 +1,679 @@
+/*
+ * charset.c -- input character set detection and conversion to UTF-8
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#ifdef HAVE_ICONV
+#include <iconv.h>
+#endif
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "charset.h"
+
+#define SNIFF_SIZE	4096	/* input examined to detect the character set */
+#define HOLD_MAX	8	/* room for a character split between chunks */
+
+#define REPLACEMENT	0xFFFD	/* U+FFFD REPLACEMENT CHARACTER */
+
+struct Converter {
+	int charset;
+	unsigned char *hold;	/* input not converted yet */
+	size_t hlen;
+	size_t hsize;
+	char *out;		/* converted output */
+	size_t olen;
+	size_t osize;
+#ifdef HAVE_ICONV
+	iconv_t cd;		/* opened once per converter */
+#endif
+};
+
+/* CP1252 0x80 - 0x9F (the rest of the high half matches ISO 8859-1) */
+static const unsigned short cp1252[32] = {
+	0x20AC, REPLACEMENT, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+	0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, REPLACEMENT, 0x017D, REPLACEMENT,
+	REPLACEMENT, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+	0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, REPLACEMENT, 0x017E, 0x0178
+};
+
+/* length of the leading run of ASCII bytes */
+static size_t ascii_span(const unsigned char *s, size_t len)
+{
+	size_t i = 0;
+
+#ifdef __SSE2__
+	int mask;
+
+	for (; i + 16 <= len; i += 16) {
+		mask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i *) (s + i)));
+		if (0 != mask) {
+			return i + __builtin_ctz(mask);
+		}
+	}
+#endif
+	for (; i < len && 0x80 > s[i]; i++)
+		;
+
+	return i;
+}
+
+/*
+ * length of the UTF-8 sequence at s
+ * returns 0 if it is invalid and -1 if it is cut short by the end of input
+ */
+static int utf8_seq(const unsigned char *s, size_t len)
+{
+	unsigned char lo = 0x80;
+	unsigned char hi = 0xBF;
+	int n;
+	int i;
+
+	if (0x80 > s[0]) {
+		return 1;
+	} else if (0xC2 > s[0]) {
+		return 0;
+	} else if (0xE0 > s[0]) {
+		n = 2;
+	} else if (0xF0 > s[0]) {
+		n = 3;
+		if (0xE0 == s[0]) {
+			lo = 0xA0;	/* overlong */
+		} else if (0xED == s[0]) {
+			hi = 0x9F;	/* surrogate */
+		}
+	} else if (0xF5 > s[0]) {
+		n = 4;
+		if (0xF0 == s[0]) {
+			lo = 0x90;	/* overlong */
+		} else if (0xF4 == s[0]) {
+			hi = 0x8F;	/* above U+10FFFF */
+		}
+	} else {
+		return 0;
+	}
+
+	for (i = 1; i < n; i++) {
+		if ((size_t) i >= len) {
+			return -1;
+		}
+		if (lo > s[i] || hi < s[i]) {
+			return 0;
+		}
+		lo = 0x80;
+		hi = 0xBF;
+	}
+
+	return n;
+}
+
+/* length of the leading run of valid UTF-8 */
+static size_t utf8_span(const unsigned char *s, size_t len)
+{
+	size_t i = 0;
+	int n;
+
+	while (i < len) {
+		i += ascii_span(s + i, len - i);
+		if (i == len || 0 >= (n = utf8_seq(s + i, len - i))) {
+			break;
+		}
+		i += n;
+	}
+
+	return i;
+}
+
+/*
+ * how much the input looks like Shift-JIS: double byte characters next to
+ * other non-ASCII characters, as in Japanese words, or with a trail byte
+ * of 0x80 or more, which CP1252 text would hardly have after a letter
+ * returns -1 unless the input is ASCII and valid Shift-JIS
+ */
+static int sjis_score(const unsigned char *s, size_t len)
+{
+	size_t i = 0;
+	int after = 0;		/* the character before is not ASCII */
+	int score = 0;
+
+	while (i < len) {
+		if (0x80 > s[i]) {
+			i++;
+			after = 0;
+		} else if (0xA1 <= s[i] && 0xDF >= s[i]) {
+			i++;	/* half width katakana */
+			after = 1;
+		} else if (((0x81 <= s[i] && 0x9F >= s[i])
+		            || (0xE0 <= s[i] && 0xFC >= s[i]))
+		           && i + 1 < len
+		           && 0x40 <= s[i + 1] && 0xFC >= s[i + 1]
+		           && 0x7F != s[i + 1]) {
+			score += (after || (i + 2 < len && 0x80 <= s[i + 2]));
+			score += (0x80 <= s[i + 1]);
+			i += 2;
+			after = 1;
+		} else if (i + 1 == len) {
+			break;	/* cut short */
+		} else {
+			return -1;
+		}
+	}
+
+	return score;
+}
+
+static int ascii_letter(unsigned char c)
+{
+	return 'a' <= (c | 0x20) && 'z' >= (c | 0x20);
+}
+
+/*
+ * how much the input looks like CP1252: accented letters, quotes and
+ * dashes next to an ASCII letter, as in a word with an umlaut or a curly
+ * apostrophe
+ */
+static int cp1252_score(const unsigned char *s, size_t len)
+{
+	int score = 0;
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		if (0x80 > s[i]) {
+			continue;
+		}
+		if (((0xC0 <= s[i] && 0xD7 != s[i] && 0xF7 != s[i])
+		     || 0x8A == s[i] || 0x8C == s[i] || 0x8E == s[i]
+		     || 0x9A == s[i] || 0x9C == s[i] || 0x9E == s[i]
+		     || 0x9F == s[i] || 0x85 == s[i]
+		     || (0x91 <= s[i] && 0x97 >= s[i]))
+		    && ((0 < i && ascii_letter(s[i - 1]))
+		        || (i + 1 < len && ascii_letter(s[i + 1])))) {
+			score++;
+		}
+	}
+
+	return score;
+}
+
+int charset_detect(const char *bytes, size_t len, size_t *bom)
+{
+	const unsigned char *s = (const unsigned char *) bytes;
+	size_t even = 0;	/* NULs at even offsets */
+	size_t odd = 0;
+	size_t n;
+	size_t i;
+
+	*bom = 0;
+
+	if (3 <= len && 0xEF == s[0] && 0xBB == s[1] && 0xBF == s[2]) {
+		*bom = 3;
+		return CHARSET_UTF8;
+	} else if (2 <= len && 0xFF == s[0] && 0xFE == s[1]) {
+		*bom = 2;
+		return CHARSET_UTF16LE;
+	} else if (2 <= len && 0xFE == s[0] && 0xFF == s[1]) {
+		*bom = 2;
+		return CHARSET_UTF16BE;
+	}
+
+	/* UTF-16 without a byte order mark: ASCII text has every other byte NUL */
+	n = (SNIFF_SIZE < len) ? SNIFF_SIZE : len;
+	for (i = 0; i + 1 < n; i += 2) {
+		even += (0 == s[i]);
+		odd += (0 == s[i + 1]);
+	}
+	if (odd > n / 4 && odd > even) {
+		return CHARSET_UTF16LE;
+	} else if (even > n / 4) {
+		return CHARSET_UTF16BE;
+	}
+
+	/* most text that reads as Shift-JIS reads as CP1252 too */
+	i = utf8_span(s, n);
+	if (n == i || -1 == utf8_seq(s + i, n - i)) {
+		return CHARSET_UTF8;
+	} else if (sjis_score(s, n) > cp1252_score(s, n)) {
+		return CHARSET_SHIFT_JIS;
+	}
+
+	return CHARSET_CP1252;
+}
+
+const char *charset_name(int charset)
+{
+	switch (charset) {
+	case CHARSET_UTF8:
+		return "UTF-8";
+	case CHARSET_UTF16LE:
+		return "UTF-16LE";
+	case CHARSET_UTF16BE:
+		return "UTF-16BE";
+	case CHARSET_CP1252:
+		return "CP1252";
+	case CHARSET_SHIFT_JIS:
+		return "Shift-JIS";
+	}
+
+	return "unknown";
+}
+
+static void converter_detect(Converter *cv);
+
+Converter *converter_new(int charset)
+{
+	Converter *cv = NULL;
+
+	if (NULL == (cv = calloc(1, sizeof(Converter)))) {
+		fprintf(stderr, "unable to create converter\n");
+		return NULL;
+	}
+
+	cv->charset = charset;
+#ifdef HAVE_ICONV
+	cv->cd = (iconv_t) -1;
+#endif
+	if (CHARSET_UNKNOWN != charset) {
+		converter_detect(cv);
+	}
+
+	return cv;
+}
+
+void converter_delete(Converter *cv)
+{
+	if (NULL != cv) {
+#ifdef HAVE_ICONV
+		if ((iconv_t) -1 != cv->cd) {
+			iconv_close(cv->cd);
+		}
+#endif
+		free(cv->hold);
+		free(cv->out);
+		free(cv);
+	}
+}
+
+int converter_charset(Converter *cv)
+{
+	return cv->charset;
+}
+
+/* make room for n more bytes of output */
+static int converter_reserve(Converter *cv, size_t n)
+{
+	char *out = NULL;
+	size_t size;
+
+	if (cv->olen + n > cv->osize) {
+		size = (0 == cv->osize) ? 4096 : cv->osize;
+		while (size < cv->olen + n) {
+			size *= 2;
+		}
+		if (NULL == (out = realloc(cv->out, size))) {
+			fprintf(stderr, "unable to allocate memory\n");
+			return -1;
+		}
+		cv->out = out;
+		cv->osize = size;
+	}
+
+	return 0;
+}
+
+/* append bytes to the held over input */
+static int converter_hold(Converter *cv, const unsigned char *bytes, size_t len)
+{
+	unsigned char *hold = NULL;
+	size_t size;
+
+	if (cv->hlen + len > cv->hsize) {
+		size = (0 == cv->hsize) ? SNIFF_SIZE : cv->hsize;
+		while (size < cv->hlen + len) {
+			size *= 2;
+		}
+		if (NULL == (hold = realloc(cv->hold, size))) {
+			fprintf(stderr, "unable to allocate memory\n");
+			return -1;
+		}
+		cv->hold = hold;
+		cv->hsize = size;
+	}
+
+	memcpy(cv->hold + cv->hlen, bytes, len);
+	cv->hlen += len;
+
+	return 0;
+}
+
+/* append c as UTF-8 (room has been reserved) */
+static void put_utf8(Converter *cv, unsigned int c)
+{
+	unsigned char *out = (unsigned char *) cv->out + cv->olen;
+
+	if (0x80 > c) {
+		out[0] = c;
+		cv->olen += 1;
+	} else if (0x800 > c) {
+		out[0] = 0xC0 | (c >> 6);
+		out[1] = 0x80 | (c & 0x3F);
+		cv->olen += 2;
+	} else if (0x10000 > c) {
+		out[0] = 0xE0 | (c >> 12);
+		out[1] = 0x80 | ((c >> 6) & 0x3F);
+		out[2] = 0x80 | (c & 0x3F);
+		cv->olen += 3;
+	} else {
+		out[0] = 0xF0 | (c >> 18);
+		out[1] = 0x80 | ((c >> 12) & 0x3F);
+		out[2] = 0x80 | ((c >> 6) & 0x3F);
+		out[3] = 0x80 | (c & 0x3F);
+		cv->olen += 4;
+	}
+}
+
+static void put_cp1252(Converter *cv, unsigned char c)
+{
+	put_utf8(cv, (0x80 <= c && 0xA0 > c) ? cp1252[c - 0x80] : c);
+}
+
+static size_t decode_utf8(Converter *cv, const unsigned char *in, size_t len,
+                          int final)
+{
+	size_t i = 0;
+	size_t n;
+	int seq;
+
+	while (i < len) {
+		n = utf8_span(in + i, len - i);
+		memcpy(cv->out + cv->olen, in + i, n);
+		cv->olen += n;
+		i += n;
+		if (i == len) {
+			break;
+		}
+
+		seq = utf8_seq(in + i, len - i);
+		if (-1 == seq && !final) {
+			break;	/* completed by the next chunk */
+		}
+		/* not UTF-8 after all; read the byte as CP1252 */
+		put_cp1252(cv, in[i]);
+		i++;
+	}
+
+	return i;
+}
+
+static size_t decode_cp1252(Converter *cv, const unsigned char *in, size_t len)
+{
+	size_t i = 0;
+	size_t n;
+
+	while (i < len) {
+		n = ascii_span(in + i, len - i);
+		memcpy(cv->out + cv->olen, in + i, n);
+		cv->olen += n;
+		i += n;
+		if (i < len) {
+			put_cp1252(cv, in[i]);
+			i++;
+		}
+	}
+
+	return len;
+}
+
+static size_t decode_utf16(Converter *cv, const unsigned char *in, size_t len,
+                           int final)
+{
+	int be = (CHARSET_UTF16BE == cv->charset);
+	size_t i = 0;
+	unsigned int c;
+	unsigned int c2;
+
+	while (i + 1 < len) {
+#ifdef __SSE2__
+		/* eight ASCII characters at a time */
+		if (i + 16 <= len) {
+			__m128i v = _mm_loadu_si128((const __m128i *) (in + i));
+
+			if (be) {
+				v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+			}
+			if (0xFFFF == _mm_movemask_epi8(_mm_cmpeq_epi16(
+				_mm_and_si128(v, _mm_set1_epi16(0xFF80)),
+				_mm_setzero_si128()))) {
+				_mm_storel_epi64((__m128i *) (cv->out + cv->olen),
+				                 _mm_packus_epi16(v, v));
+				cv->olen += 8;
+				i += 16;
+				continue;
+			}
+		}
+#endif
+		c = be ? (in[i] << 8 | in[i + 1]) : (in[i + 1] << 8 | in[i]);
+
+		if (0xD800 <= c && 0xDBFF >= c) {
+			if (i + 3 >= len) {
+				if (!final) {
+					break;	/* completed by the next chunk */
+				}
+				c = REPLACEMENT;
+			} else {
+				c2 = be ? (in[i + 2] << 8 | in[i + 3])
+				        : (in[i + 3] << 8 | in[i + 2]);
+				if (0xDC00 <= c2 && 0xDFFF >= c2) {
+					c = 0x10000 + ((c - 0xD800) << 10)
+					    + (c2 - 0xDC00);
+					i += 2;
+				} else {
+					c = REPLACEMENT;
+				}
+			}
+		} else if (0xDC00 <= c && 0xDFFF >= c) {
+			c = REPLACEMENT;
+		}
+
+		put_utf8(cv, c);
+		i += 2;
+	}
+
+	if (final && i < len) {
+		put_utf8(cv, REPLACEMENT);	/* odd trailing byte */
+		i = len;
+	}
+
+	return i;
+}
+
+#ifdef HAVE_ICONV
+static int decode_iconv(Converter *cv, const unsigned char *in, size_t len,
+                        int final, size_t *used)
+{
+	char *ip = (char *) in;
+	size_t ileft = len;
+	char *op = NULL;
+	size_t oleft;
+	size_t ret;
+
+	while (0 < ileft) {
+		if (0 != converter_reserve(cv, 3 * ileft + HOLD_MAX)) {
+			return -1;
+		}
+		op = cv->out + cv->olen;
+		oleft = cv->osize - cv->olen;
+		ret = iconv(cv->cd, &ip, &ileft, &op, &oleft);
+		cv->olen = op - cv->out;
+
+		if ((size_t) -1 != ret) {
+			break;
+		} else if (E2BIG == errno) {
+			continue;
+		} else if (EINVAL == errno && !final) {
+			break;	/* completed by the next chunk */
+		}
+
+		/* invalid sequence */
+		put_utf8(cv, REPLACEMENT);
+		ip++;
+		ileft--;
+		iconv(cv->cd, NULL, NULL, NULL, NULL);
+	}
+
+	*used = len - ileft;
+
+	return 0;
+}
+#endif
+
+/*
+ * convert in to UTF-8, appending to the output
+ * *used is set to the number of bytes converted; the rest are part of a
+ * character completed by the next chunk
+ */
+static int decode(Converter *cv, const unsigned char *in, size_t len,
+                  int final, size_t *used)
+{
+	if (0 != converter_reserve(cv, 3 * len + HOLD_MAX)) {
+		return -1;
+	}
+
+	switch (cv->charset) {
+	case CHARSET_UTF16LE:
+	case CHARSET_UTF16BE:
+		*used = decode_utf16(cv, in, len, final);
+		break;
+	case CHARSET_CP1252:
+		*used = decode_cp1252(cv, in, len);
+		break;
+#ifdef HAVE_ICONV
+	case CHARSET_SHIFT_JIS:
+		return decode_iconv(cv, in, len, final, used);
+#endif
+	default:
+		*used = decode_utf8(cv, in, len, final);
+		break;
+	}
+
+	return 0;
+}
+
+/* detect the character set from the held over input */
+static void converter_detect(Converter *cv)
+{
+	size_t bom = 0;
+
+	if (CHARSET_UNKNOWN == cv->charset) {
+		cv->charset = charset_detect((char *) cv->hold, cv->hlen, &bom);
+		if (0 != bom) {
+			memmove(cv->hold, cv->hold + bom, cv->hlen - bom);
+			cv->hlen -= bom;
+		}
+	}
+
+#ifdef HAVE_ICONV
+	if (CHARSET_SHIFT_JIS == cv->charset) {
+		if ((iconv_t) -1 == (cv->cd = iconv_open("UTF-8", "CP932"))) {
+			cv->cd = iconv_open("UTF-8", "SHIFT_JIS");
+		}
+	}
+	if (CHARSET_SHIFT_JIS == cv->charset && (iconv_t) -1 == cv->cd) {
+		cv->charset = CHARSET_CP1252;
+	}
+#else
+	if (CHARSET_SHIFT_JIS == cv->charset) {
+		cv->charset = CHARSET_CP1252;
+	}
+#endif
+}
+
+static const char *converter_convert(Converter *cv, const unsigned char *in,
+                                     size_t len, int final, size_t *outlen)
+{
+	unsigned char buf[2 * HOLD_MAX];
+	size_t used;
+	size_t n;
+	size_t held;
+
+	cv->olen = 0;
+	*outlen = 0;
+
+	if (CHARSET_UNKNOWN == cv->charset) {
+		/* wait for enough input to tell */
+		if (0 != converter_hold(cv, in, len)) {
+			return NULL;
+		}
+		if (SNIFF_SIZE > cv->hlen && !final) {
+			return "";
+		}
+		converter_detect(cv);
+		if (0 != decode(cv, cv->hold, cv->hlen, final, &used)) {
+			return NULL;
+		}
+		memmove(cv->hold, cv->hold + used, cv->hlen - used);
+		cv->hlen -= used;
+		*outlen = cv->olen;
+		return cv->out;
+	}
+
+	if (0 == cv->hlen && CHARSET_UTF8 == cv->charset
+	    && len == utf8_span(in, len)) {
+		/* nothing to do */
+		*outlen = len;
+		return (const char *) in;
+	}
+
+	if (0 != cv->hlen) {
+		/* complete the character split by the last chunk */
+		held = cv->hlen;
+		n = (len < HOLD_MAX) ? len : HOLD_MAX;
+		memcpy(buf, cv->hold, held);
+		memcpy(buf + held, in, n);
+		cv->hlen = 0;
+		if (0 != decode(cv, buf, held + n, final && n == len, &used)) {
+			return NULL;
+		}
+		if (used < held) {
+			/* still incomplete; n == len here */
+			if (0 != converter_hold(cv, buf + used, held + n - used)) {
+				return NULL;
+			}
+			*outlen = cv->olen;
+			return cv->out;
+		}
+		in += used - held;
+		len -= used - held;
+	}
+
+	if (0 != decode(cv, in, len, final, &used)) {
+		return NULL;
+	}
+	if (0 != converter_hold(cv, in + used, len - used)) {
+		return NULL;
+	}
+
+	*outlen = cv->olen;
+	return cv->out;
+}
+
+const char *converter_feed(Converter *cv, const char *bytes, size_t len,
+                           size_t *outlen)
+{
+	return converter_convert(cv, (const unsigned char *) bytes, len, 0,
+	                         outlen);
+}
+
+const char *converter_finish(Converter *cv, size_t *outlen)
+{
+	return converter_convert(cv, (const unsigned char *) "", 0, 1, outlen);
+}
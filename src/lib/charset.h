@@ -0,0 +1,48 @@
+/*
+ * charset.h -- input character set detection and conversion to UTF-8
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#ifndef CHARSET_H
+#define CHARSET_H
+
+#include <stddef.h>
+
+enum Charset {
+	CHARSET_UNKNOWN,	/* not detected yet */
+	CHARSET_UTF8,
+	CHARSET_UTF16LE,
+	CHARSET_UTF16BE,
+	CHARSET_CP1252,		/* Windows Latin 1 (superset of ISO 8859-1) */
+	CHARSET_SHIFT_JIS	/* Windows code page 932, converted with iconv(3) */
+};
+
+typedef struct Converter Converter;
+
+/*
+ * detect the character set of the start of an input
+ * input that is valid as both is taken as Shift-JIS only if it looks
+ * more like Japanese than like accented Latin text
+ * *bom is set to the length of the byte order mark, if any
+ */
+int charset_detect(const char *bytes, size_t len, size_t *bom);
+const char *charset_name(int charset);
+
+/*
+ * streaming conversion to UTF-8
+ * the character set is detected from the first few KiB of input unless
+ * given.  Characters split between chunks are held over, and invalid
+ * UTF-8 bytes are read as CP1252.
+ * converter_feed() and converter_finish() return the converted bytes,
+ * which are valid until the next call, or NULL on error.
+ */
+Converter *converter_new(int charset);
+void converter_delete(Converter *cv);
+const char *converter_feed(Converter *cv, const char *bytes, size_t len,
+                           size_t *outlen);
+const char *converter_finish(Converter *cv, size_t *outlen);
+int converter_charset(Converter *cv);
+
+#endif
@@ -0,0 +1,131 @@
+/*
+ * crc.c -- cyclic redundancy checks
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#include <pthread.h>
+#include <string.h>
+#include "crc.h"
+
+#define CRC32_POLY	0xEDB88320	/* reflected 0x04C11DB7 */
+#define CRC16_POLY	0x1021
+
+/*
+ * slice-by-8 tables
+ * crc32_table[k][b] is the CRC of byte b followed by k zero bytes
+ */
+static uint32_t crc32_table[8][256];
+static pthread_once_t crc32_once = PTHREAD_ONCE_INIT;
+
+static void crc32_init()
+{
+	uint32_t c;
+	int i;
+	int j;
+
+	for (i = 0; i < 256; i++) {
+		c = i;
+		for (j = 0; j < 8; j++) {
+			c = (c >> 1) ^ ((c & 1) ? CRC32_POLY : 0);
+		}
+		crc32_table[0][i] = c;
+	}
+
+	for (i = 0; i < 256; i++) {
+		c = crc32_table[0][i];
+		for (j = 1; j < 8; j++) {
+			c = (c >> 8) ^ crc32_table[0][c & 0xFF];
+			crc32_table[j][i] = c;
+		}
+	}
+}
+
+uint32_t crc32_update(uint32_t crc, const void *data, size_t len)
+{
+	const unsigned char *p = data;
+	uint32_t lo;
+	uint32_t hi;
+
+	pthread_once(&crc32_once, crc32_init);
+
+	crc = ~crc;
+
+	/* eight bytes per step */
+	for (; 8 <= len; p += 8, len -= 8) {
+		lo = crc ^ ((uint32_t) p[0] | (uint32_t) p[1] << 8
+		            | (uint32_t) p[2] << 16 | (uint32_t) p[3] << 24);
+		hi = (uint32_t) p[4] | (uint32_t) p[5] << 8
+		     | (uint32_t) p[6] << 16 | (uint32_t) p[7] << 24;
+		crc = crc32_table[7][lo & 0xFF]
+		      ^ crc32_table[6][(lo >> 8) & 0xFF]
+		      ^ crc32_table[5][(lo >> 16) & 0xFF]
+		      ^ crc32_table[4][lo >> 24]
+		      ^ crc32_table[3][hi & 0xFF]
+		      ^ crc32_table[2][(hi >> 8) & 0xFF]
+		      ^ crc32_table[1][(hi >> 16) & 0xFF]
+		      ^ crc32_table[0][hi >> 24];
+	}
+
+	for (; 0 < len; p++, len--) {
+		crc = (crc >> 8) ^ crc32_table[0][(crc ^ *p) & 0xFF];
+	}
+
+	return ~crc;
+}
+
+/*
+ * slice-by-8 tables, most significant bit first
+ * crc16_table[k][b] is the CRC of byte b followed by k zero bytes
+ */
+static uint16_t crc16_table[8][256];
+static pthread_once_t crc16_once = PTHREAD_ONCE_INIT;
+
+static void crc16_init()
+{
+	uint16_t c;
+	int i;
+	int j;
+
+	for (i = 0; i < 256; i++) {
+		c = i << 8;
+		for (j = 0; j < 8; j++) {
+			c = (c << 1) ^ ((c & 0x8000) ? CRC16_POLY : 0);
+		}
+		crc16_table[0][i] = c;
+	}
+
+	for (i = 0; i < 256; i++) {
+		c = crc16_table[0][i];
+		for (j = 1; j < 8; j++) {
+			c = (c << 8) ^ crc16_table[0][c >> 8];
+			crc16_table[j][i] = c;
+		}
+	}
+}
+
+uint16_t crc16_update(uint16_t crc, const void *data, size_t len)
+{
+	const unsigned char *p = data;
+
+	pthread_once(&crc16_once, crc16_init);
+
+	/* eight bytes per step, the CRC folded into the first two */
+	for (; 8 <= len; p += 8, len -= 8) {
+		crc = crc16_table[7][p[0] ^ (crc >> 8)]
+		      ^ crc16_table[6][p[1] ^ (crc & 0xFF)]
+		      ^ crc16_table[5][p[2]]
+		      ^ crc16_table[4][p[3]]
+		      ^ crc16_table[3][p[4]]
+		      ^ crc16_table[2][p[5]]
+		      ^ crc16_table[1][p[6]]
+		      ^ crc16_table[0][p[7]];
+	}
+
+	for (; 0 < len; p++, len--) {
+		crc = (crc << 8) ^ crc16_table[0][(crc >> 8) ^ *p];
+	}
+
+	return crc;
+}
@@ -0,0 +1,27 @@
+/*
+ * crc.h -- cyclic redundancy checks
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#ifndef CRC_H
+#define CRC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * CRC-32 (IEEE 802.3, as used by zip and EAC)
+ * start with crc = 0 and pass the result back in for the next block
+ */
+uint32_t crc32_update(uint32_t crc, const void *data, size_t len);
+
+/*
+ * CRC-16 (CCITT, polynomial 0x1021, as used by the Q sub-channel and
+ * CD-TEXT packs, which store its ones' complement)
+ * start with crc = 0 and pass the result back in for the next block
+ */
+uint16_t crc16_update(uint16_t crc, const void *data, size_t len);
+
+#endif
@@ -5,5 +5,16 @@
  * For license terms, see the file COPYING in this distribution.
  */
 
-Cd *cue_parse(FILE *fp);
+typedef struct CueParser CueParser;
+
+/*
+ * incremental parser
+ * push input that ends at a line boundary, then finish to get the Cd
+ * cue_parser_push() returns non-zero once the parse has failed
+ */
+CueParser *cue_parser_new();
+int cue_parser_push(CueParser *p, char *bytes, size_t len);
+Cd *cue_parser_finish(CueParser *p);
+void cue_parser_delete(CueParser *p);
+
 void cue_print(FILE *fp, Cd *cd);
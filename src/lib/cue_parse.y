@@ -10,25 +10,44 @@
 #include <stdio.h>
 #include <string.h>
 #include "cd.h"
-#include "time.h"
+#include "cdtime.h"
+#include "cue.h"
+#include "stats.h"
+#include "probes.h"
 #include "cue_parse_prefix.h"
 
 #define YYDEBUG 1
 
-extern int yylex();
-void yyerror (char *s);
-
-static Cd *cd = NULL;
-static Track *track = NULL;
-static Track *prev_track = NULL;
-static Cdtext *cdtext = NULL;
-static char *prev_filename = NULL;	/* last file in or before last track */
-static char *cur_filename = NULL;	/* last file in the last track */
-static char *new_filename = NULL;	/* last file in this track */
+/* parser state, one per input (see cue_parser_new()) */
+struct CueParser {
+	void *scanner;			/* reentrant scanner */
+	struct yypstate *ps;		/* push parser */
+	int status;			/* YYPUSH_MORE while parsing */
+	int lineno;			/* line being scanned */
+	Cd *cd;
+	Track *track;
+	Track *prev_track;
+	Cdtext *cdtext;
+	char *prev_filename;		/* last file in or before last track */
+	char *cur_filename;		/* last file in the last track */
+	char *new_filename;		/* last file in this track */
+	int prev_filetype;		/* FileType of each of those */
+	int new_filetype;
+};
+
+void yyerror (CueParser *p, char *s);
 %}
 
 %start cuefile
 
+%define api.pure full
+%define api.push-pull push
+%parse-param {struct CueParser *p}
+
+%code requires {
+struct CueParser;
+}
+
 %union {
 	long ival;
 	char *sval;
@@ -37,16 +56,18 @@ static char *new_filename = NULL;	/* last file in this track */
 %token <ival> NUMBER
 %token <sval> STRING
 
+%destructor { free($$); } <sval>
+
 /* global (header) */
 %token CATALOG
 %token CDTEXTFILE
 
 %token FFILE
-%token BINARY
-%token MOTOROLA
-%token AIFF
-%token WAVE
-%token MP3
+%token <ival> BINARY
+%token <ival> MOTOROLA
+%token <ival> AIFF
+%token <ival> WAVE
+%token <ival> MP3
 
 /* track */
 %token TRACK
@@ -88,6 +109,7 @@ static char *new_filename = NULL;	/* last file in this track */
 %token <ival> ISRC
 %token <ival> SIZE_INFO
 
+%type <ival> file_format
 %type <ival> track_mode
 %type <ival> track_flag
 %type <ival> time
@@ -101,8 +123,8 @@ cuefile
 
 new_cd
 	: /* empty */ {
-		cd = cd_init();
-		cdtext = cd_get_cdtext(cd);
+		p->cd = cd_init();
+		p->cdtext = cd_get_cdtext(p->cd);
 	}
 	;
 
@@ -112,8 +134,11 @@ global_statements
 	;
 
 global_statement
-	: CATALOG STRING '\n' { cd_set_catalog(cd, $2); }
-	| CDTEXTFILE STRING '\n' { /* ignored */ }
+	: CATALOG STRING '\n' { cd_set_catalog(p->cd, $2); free($2); }
+	| CDTEXTFILE STRING '\n' {
+		cd_set_cdtextfile(p->cd, $2);
+		free($2);
+	}
 	| cdtext
 	| track_data
 	| error '\n'
@@ -121,11 +146,12 @@ global_statement
 
 track_data
 	: FFILE STRING file_format '\n' {
-		if (NULL != new_filename) {
-			yyerror("too many files specified\n");
-			free(new_filename);
+		if (NULL != p->new_filename) {
+			yyerror(p, "too many files specified\n");
+			free(p->new_filename);
 		}
-		new_filename = strdup($2);
+		p->new_filename = $2;
+		p->new_filetype = $3;
 	}
 	;
 
@@ -149,29 +175,34 @@ file_format
 new_track
 	: /*empty */ {
 		/* save previous track, to later set length */
-		prev_track = track;
+		p->prev_track = p->track;
 
-		track = cd_add_track(cd);
-		cdtext = track_get_cdtext(track);
+		if (NULL == (p->track = cd_add_track(p->cd))) {
+			YYABORT;
+		}
+		p->cdtext = track_get_cdtext(p->track);
 
-		cur_filename = new_filename;
-		if (NULL != cur_filename) {
-			prev_filename = cur_filename;
+		p->cur_filename = p->new_filename;
+		if (NULL != p->cur_filename) {
+			free(p->prev_filename);
+			p->prev_filename = p->cur_filename;
+			p->prev_filetype = p->new_filetype;
 		}
 
-		if (NULL == prev_filename) {
-			yyerror("no file specified for track");
+		if (NULL == p->prev_filename) {
+			yyerror(p, "no file specified for track");
 		} else {
-			track_set_filename(track, prev_filename);
+			track_set_filename(p->track, p->prev_filename);
+			track_set_filetype(p->track, p->prev_filetype);
 		}
 
-		new_filename = NULL;
+		p->new_filename = NULL;
 	}
 	;
 
 track_def
 	: TRACK NUMBER track_mode '\n' {
-		track_set_mode(track, $3);
+		track_set_mode(p->track, $3);
 	}
 	;
 
@@ -194,37 +225,59 @@ track_statements
 track_statement
 	: cdtext
 	| FLAGS track_flags '\n'
-	| TRACK_ISRC STRING '\n' { track_set_isrc(track, $2); }
-	| PREGAP time '\n' { track_set_zero_pre(track, $2); }
+	| TRACK_ISRC STRING '\n' { track_set_isrc(p->track, $2); free($2); }
+	| PREGAP time '\n' { track_set_zero_pre(p->track, $2); }
 	| INDEX NUMBER time '\n' {
-		int i = track_get_nindex(track);
+		int i = track_get_nindex(p->track);
 		long prev_length;
 
 		if (0 == i) {
 			/* first index */
-			track_set_start(track, $3);
+			track_set_start(p->track, $3);
 
-			if (NULL != prev_track && NULL == cur_filename) {
+			if (NULL != p->prev_track && NULL == p->cur_filename) {
 				/* track shares file with previous track */
-				prev_length = $3 - track_get_start(prev_track);
-				track_set_length(prev_track, prev_length);
+				prev_length = $3 - track_get_start(p->prev_track);
+				track_set_length(p->prev_track, prev_length);
+			}
+		} else if (NULL != p->new_filename) {
+			/*
+			 * a FILE between INDEX 00 and 01: the pregap is at the
+			 * end of the file of the track before, which keeps it
+			 */
+			if (1 != i || NULL == p->prev_track
+			    || NULL != p->cur_filename) {
+				yyerror(p, "track is in more than one file");
+			} else {
+				track_set_pregap_start(p->track,
+				                       track_get_start(p->track));
+				track_set_length(p->prev_track, 0);
+
+				free(p->prev_filename);
+				p->cur_filename = p->new_filename;
+				p->prev_filename = p->cur_filename;
+				p->prev_filetype = p->new_filetype;
+				p->new_filename = NULL;
+				track_set_filename(p->track, p->prev_filename);
+				track_set_filetype(p->track, p->prev_filetype);
+				track_set_start(p->track, 0);
 			}
 		}
 
 		for (; i <= $2; i++) {
-			track_add_index(track, \
-			track_get_zero_pre(track) + $3 \
-			- track_get_start(track));
+			track_add_index(p->track, \
+			track_get_zero_pre(p->track) + $3 \
+			- track_get_start(p->track));
 		}
 	}
-	| POSTGAP time '\n' { track_set_zero_post(track, $2); }
+	| POSTGAP time '\n' { track_set_zero_post(p->track, $2); }
 	| track_data
 	| error '\n'
 	;
 
 track_flags
 	: /* empty */
-	| track_flags track_flag { track_set_flag(track, $2); }
+	| track_flags track_flag { track_set_flag(p->track, $2); }
 	;
 
 track_flag
@@ -235,7 +288,7 @@ track_flag
 	;
 
 cdtext
-	: cdtext_item STRING '\n' { cdtext_set ($1, $2, cdtext); }
+	: cdtext_item STRING '\n' { cdtext_set ($1, $2, p->cdtext); free($2); }
 	;
 
 cdtext_item
@@ -261,24 +314,81 @@ time
 
 %%
 
-/* lexer interface */
-extern int cue_lineno;
-extern int yydebug;
-extern FILE *cue_yyin;
+/* scanner interface */
+extern void *cue_scan_new(int *lineno);
+extern void cue_scan_delete(void *scanner);
+extern int cue_scan_push(void *scanner, char *bytes, size_t len,
+                         yypstate *ps, CueParser *p);
+
+void yyerror (CueParser *p, char *s)
+{
+	PROBE2(parse__error, p->lineno, s);
+	fprintf(stderr, "%d: %s\n", p->lineno, s);
+}
+
+CueParser *cue_parser_new()
+{
+	CueParser *p = NULL;
+
+	if (NULL == (p = calloc(1, sizeof(CueParser)))) {
+		fprintf(stderr, "unable to create parser\n");
+		return NULL;
+	}
+
+	p->status = YYPUSH_MORE;
+	p->lineno = 1;
+	p->ps = yypstate_new();
+	p->scanner = cue_scan_new(&p->lineno);
+
+	if (NULL == p->ps || NULL == p->scanner) {
+		fprintf(stderr, "unable to create parser\n");
+		cue_parser_delete(p);
+		return NULL;
+	}
+
+	return p;
+}
 
-void yyerror (char *s)
+void cue_parser_delete(CueParser *p)
 {
-	fprintf(stderr, "%d: %s\n", cue_lineno, s);
+	if (NULL != p) {
+		if (NULL != p->scanner) {
+			cue_scan_delete(p->scanner);
+		}
+		if (NULL != p->ps) {
+			yypstate_delete(p->ps);
+		}
+		cd_delete(p->cd);
+		free(p->prev_filename);
+		free(p->new_filename);
+		free(p);
+	}
 }
 
-Cd *cue_parse (FILE *fp)
+int cue_parser_push(CueParser *p, char *bytes, size_t len)
 {
-	cue_yyin = fp;
-	yydebug = 0;
+	if (YYPUSH_MORE == p->status) {
+		p->status = cue_scan_push(p->scanner, bytes, len, p->ps, p);
+	}
+
+	return (YYPUSH_MORE == p->status) ? 0 : -1;
+}
+
+Cd *cue_parser_finish(CueParser *p)
+{
+	YYSTYPE lval;
+	Cd *cd = NULL;
+
+	if (YYPUSH_MORE == p->status) {
+		/* end of input */
+		lval.sval = NULL;
+		p->status = yypush_parse(p->ps, 0, &lval, p);
+	}
 
-	if (0 == yyparse()) {
-		return cd;
+	if (0 == p->status) {
+		cd = p->cd;
+		p->cd = NULL;
 	}
 
-	return NULL;
+	return cd;
 }
@@ -12,10 +12,12 @@
 
 #define yymaxdepth	cue_yymaxdepth
 #define yyparse		cue_yyparse
+#define yypush_parse	cue_yypush_parse
+#define yypstate	cue_yypstate
+#define yypstate_new	cue_yypstate_new
+#define yypstate_delete	cue_yypstate_delete
 #define yylex		cue_yylex
 #define yyerror		cue_yyerror
-#define yylval		cue_yylval
-#define yychar		cue_yychar
 #define yydebug		cue_yydebug
 #define yypact		cue_yypact
 #define yyr1		cue_yyr1
@@ -26,12 +28,10 @@
 #define yyact		cue_yyact
 #define yyexca		cue_yyexca
 #define yyerrflag	cue_yyerrflag
-#define yynerrs		cue_yynerrs
 #define yyps		cue_yyps
 #define yypv		cue_yypv
 #define yys		cue_yys
 #define yy_yys		cue_yy_yys
-#define yystate		cue_yystate
 #define yytmp		cue_yytmp
 #define yyv		cue_yyv
 #define yy_yyv		cue_yy_yyv
@@ -8,8 +8,9 @@
 #include <stdio.h>
 #include <string.h>
 #include "cd.h"
-#include "time.h"
+#include "cdtime.h"
 
+void cue_print_file (FILE *fp, Track *track);
 void cue_print_track (FILE *fp, Track *track, int trackno);
 void cue_print_cdtext (Cdtext *cdtext, FILE *fp, int istrack);
 void cue_print_index (long i, FILE *fp);
@@ -23,10 +24,15 @@ void cue_print (FILE *fp, Cd *cd)
 	int i;	/* track */
 	Track *track = NULL;
 
+	filename = "";
+
 	/* print global information */
 	if (NULL != cd_get_catalog(cd)) {
 		fprintf(fp, "CATALOG %s\n", cd_get_catalog(cd));
 	}
+	if (NULL != cd_get_cdtextfile(cd)) {
+		fprintf(fp, "CDTEXTFILE \"%s\"\n", cd_get_cdtextfile(cd));
+	}
 
 	cue_print_cdtext(cdtext, fp, 0);
 
@@ -38,11 +44,9 @@ void cue_print (FILE *fp, Cd *cd)
 	}
 }
 
-void cue_print_track (FILE *fp, Track *track, int trackno)
+/* print the FILE line of a track, if its file is not the last one */
+void cue_print_file (FILE *fp, Track *track)
 {
-	Cdtext *cdtext = track_get_cdtext(track);
-	int i;	/* index */
-
 	if (NULL != track_get_filename(track)) {
 		/*
 		 * always print filename for track 1, afterwards only
@@ -52,14 +56,44 @@ void cue_print_track (FILE *fp, Track *track, int trackno)
 			filename = track_get_filename(track);
 			fprintf(fp, "FILE \"%s\" ", filename);
 
-			/* NOTE: what to do with other formats (MP3, etc)? */
-			if (MODE_AUDIO == track_get_mode(track)) {
-				fprintf(fp, "WAVE\n");
-			} else {
+			switch (track_get_filetype(track)) {
+			case FILE_BINARY:
 				fprintf(fp, "BINARY\n");
+				break;
+			case FILE_MOTOROLA:
+				fprintf(fp, "MOTOROLA\n");
+				break;
+			case FILE_AIFF:
+				fprintf(fp, "AIFF\n");
+				break;
+			case FILE_WAVE:
+				fprintf(fp, "WAVE\n");
+				break;
+			case FILE_MP3:
+				fprintf(fp, "MP3\n");
+				break;
+			default:
+				/* toc files do not say */
+				if (MODE_AUDIO == track_get_mode(track)) {
+					fprintf(fp, "WAVE\n");
+				} else {
+					fprintf(fp, "BINARY\n");
+				}
+				break;
 			}
 		}
 	}
+}
+
+void cue_print_track (FILE *fp, Track *track, int trackno)
+{
+	Cdtext *cdtext = track_get_cdtext(track);
+	int i;	/* index */
+
+	/* a pregap at the end of the last file comes before the FILE line */
+	if (0 > track_get_pregap_start(track)) {
+		cue_print_file(fp, track);
+	}
 
 	fprintf(fp, "TRACK %02d ", trackno);
 	switch (track_get_mode(track)) {
@@ -116,8 +150,15 @@ void cue_print_track (FILE *fp, Track *track, int trackno)
 		fprintf (fp, "PREGAP %s\n", time_frame_to_mmssff(track_get_zero_pre(track)));
 	}
 
-	/* don't print index 0 if index 1 = 0 */
-	if (track_get_index(track, 1) == 0) {
+	if (0 <= track_get_pregap_start(track)) {
+		fprintf(fp, "INDEX 00 ");
+		cue_print_index(track_get_pregap_start(track), fp);
+		cue_print_file(fp, track);
+	}
+
+	/* don't print index 0 if index 1 = 0, or if it is printed */
+	if (track_get_index(track, 1) == 0
+	    || 0 <= track_get_pregap_start(track)) {
 		i = 1;
 	} else {
 		i = 0;
@@ -5,50 +5,786 @@
  * For license terms, see the file COPYING in this distribution.
  */
 
+#include <ctype.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include "cuefile.h"
+#include "charset.h"
+#include "ape.h"
+#include "cdt.h"
 #include "cue.h"
+#include "flac.h"
+#include "probe.h"
 #include "toc.h"
+#include "stats.h"
+#include "probes.h"
+
+#define CHUNK_SIZE 65536
+#define PROBE_THREADS 8		/* files probed at once */
+#define MAXFORMAT 16
+
+struct CfParser {
+	const CfFormat *fmt;
+	void *parser;
+	Converter *cv;		/* input to UTF-8 */
+	char *buf;		/* partial line held over from the last feed */
+	size_t len;
+	size_t size;
+};
+
+/* the push parsers, as format handlers */
+static void *cf_cue_new(void)
+{
+	return cue_parser_new();
+}
+
+static int cf_cue_push(void *parser, char *bytes, size_t len)
+{
+	return cue_parser_push(parser, bytes, len);
+}
+
+static Cd *cf_cue_finish(void *parser)
+{
+	return cue_parser_finish(parser);
+}
+
+static void cf_cue_delete(void *parser)
+{
+	cue_parser_delete(parser);
+}
+
+static void *cf_toc_new(void)
+{
+	return toc_parser_new();
+}
+
+static int cf_toc_push(void *parser, char *bytes, size_t len)
+{
+	return toc_parser_push(parser, bytes, len);
+}
+
+static Cd *cf_toc_finish(void *parser)
+{
+	return toc_parser_finish(parser);
+}
+
+static void cf_toc_delete(void *parser)
+{
+	toc_parser_delete(parser);
+}
+
+/* keywords that start a line of only one of the formats */
+static const char *cue_words[] = {"REM", "PERFORMER", "SONGWRITER", "FLAGS",
+                                  "CDTEXTFILE", "PREGAP", "POSTGAP", NULL};
+static const char *toc_words[] = {"CD_DA", "CD_ROM", "CD_ROM_XA", "CD_I",
+                                  "CD_TEXT", "LANGUAGE_MAP", "LANGUAGE",
+                                  "AUDIOFILE", "DATAFILE", "SILENCE", "ZERO",
+                                  "START", "END", "NO", "COPY",
+                                  "PRE_EMPHASIS", "TWO_CHANNEL_AUDIO",
+                                  "FOUR_CHANNEL_AUDIO", "{", "}", NULL};
+
+static int cf_is_word(const char *word, const char **words)
+{
+	for (; NULL != *words; words++) {
+		if (0 == strcasecmp(word, *words)) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * count the lines of the first bytes of a sheet that only a CUE or only a
+ * TOC file has; NULs are dropped, so UTF-16 reads as ASCII
+ */
+static void cf_sniff_text(const unsigned char *head, size_t len, int *cue,
+                          int *toc)
+{
+	char text[SNIFF_SIZE + 1];
+	char first[16];
+	char second[16];
+	char *line = NULL;
+	char *end = NULL;
+	char *quote = NULL;
+	size_t n = 0;
+	size_t i;
+
+	for (i = 0; i < len && n < SNIFF_SIZE; i++) {
+		if ('\0' != head[i]) {
+			text[n++] = head[i];
+		}
+	}
+	text[n] = '\0';
+
+	*cue = 0;
+	*toc = 0;
+	for (line = text; NULL != (end = strchr(line, '\n')); line = end + 1) {
+		*end = '\0';
+		second[0] = '\0';
+		if (1 > sscanf(line, "%15s %15s", first, second)) {
+			continue;
+		}
+
+		if (0 == strncmp("//", first, 2) || cf_is_word(first, toc_words)) {
+			(*toc)++;
+		} else if (cf_is_word(first, cue_words)) {
+			(*cue)++;
+		} else if (0 == strcasecmp("TRACK", first)) {
+			/* TRACK 01 AUDIO, or TRACK AUDIO */
+			if (isdigit((unsigned char) second[0])) {
+				(*cue)++;
+			} else {
+				(*toc)++;
+			}
+		} else if (0 == strcasecmp("INDEX", first)) {
+			/* INDEX 01 00:00:00, or INDEX 00:02:00 */
+			if (NULL == strchr(second, ':')) {
+				(*cue)++;
+			} else {
+				(*toc)++;
+			}
+		} else if (0 == strcasecmp("CATALOG", first)) {
+			if ('"' == second[0]) {
+				(*toc)++;
+			} else {
+				(*cue)++;
+			}
+		} else if (0 == strcasecmp("FILE", first)
+		           && NULL != (quote = strrchr(line, '"'))) {
+			/* FILE "name" WAVE, or FILE "name" 0 */
+			while (isspace((unsigned char) *++quote))
+				;
+			if (isdigit((unsigned char) *quote)) {
+				(*toc)++;
+			} else if (isalpha((unsigned char) *quote)) {
+				(*cue)++;
+			}
+		}
+	}
+}
+
+static int cf_sniff_cue(const unsigned char *head, size_t len)
+{
+	int cue;
+	int toc;
+
+	cf_sniff_text(head, len, &cue, &toc);
+
+	return (cue > toc) ? 50 : 0;
+}
+
+static int cf_sniff_toc(const unsigned char *head, size_t len)
+{
+	int cue;
+	int toc;
+
+	cf_sniff_text(head, len, &cue, &toc);
+
+	return (toc > cue) ? 50 : 0;
+}
+
+static const char *cue_suffixes[] = {".cue", NULL};
+static const char *toc_suffixes[] = {".toc", NULL};
+static const char *flac_suffixes[] = {".flac", NULL};
+static const char *ape_suffixes[] = {".ape", ".wv", NULL};
+
+static const CfFormat cue_format = {"cue", cue_suffixes, cf_sniff_cue,
+	cf_cue_new, cf_cue_push, cf_cue_finish, cf_cue_delete, cue_print,
+	NULL, NULL};
+static const CfFormat toc_format = {"toc", toc_suffixes, cf_sniff_toc,
+	cf_toc_new, cf_toc_push, cf_toc_finish, cf_toc_delete, toc_print,
+	NULL, NULL};
+static const CfFormat flac_format = {"flac", flac_suffixes, flac_sniff,
+	NULL, NULL, NULL, NULL, NULL, flac_read, flac_write};
+static const CfFormat ape_format = {"ape", ape_suffixes, ape_sniff,
+	NULL, NULL, NULL, NULL, NULL, ape_read, NULL};
+
+/* indexed by enum Format, then the registered formats */
+static const CfFormat *formats[MAXFORMAT] = {&cue_format, &toc_format,
+                                             &flac_format, &ape_format};
+static int nformat = 4;
+
+int cf_register_format(const CfFormat *format)
+{
+	if (MAXFORMAT == nformat) {
+		fprintf(stderr, "too many formats\n");
+		return UNKNOWN;
+	}
+	formats[nformat] = format;
+
+	return nformat++;
+}
+
+const CfFormat *cf_get_format(int format)
+{
+	return (0 <= format && format < nformat) ? formats[format] : NULL;
+}
+
+int cf_format_from_name(char *name)
+{
+	int i;
+
+	for (i = 0; i < nformat; i++) {
+		if (0 == strcmp(formats[i]->name, name)) {
+			return i;
+		}
+	}
+
+	return UNKNOWN;
+}
+
+int cf_format_from_suffix(char *name)
+{
+	const char **suffix = NULL;
+	char *dot = strrchr(name, '.');
+	int i;
+
+	for (i = 0; NULL != dot && i < nformat; i++) {
+		for (suffix = formats[i]->suffixes; NULL != *suffix; suffix++) {
+			if (0 == strcasecmp(*suffix, dot)) {
+				return i;
+			}
+		}
+	}
+
+	return UNKNOWN;
+}
+
+int cf_format_sniff(const unsigned char *head, size_t len)
+{
+	int format = UNKNOWN;
+	int best = 0;
+	int score;
+	int i;
+
+	for (i = 0; i < nformat; i++) {
+		if (NULL != formats[i]->sniff
+		    && best < (score = formats[i]->sniff(head, len))) {
+			best = score;
+			format = i;
+		}
+	}
+
+	return format;
+}
+
+CfParser *cf_parser_new(int format)
+{
+	CfParser *ctx = NULL;
+	const CfFormat *fmt = cf_get_format(format);
+
+	if (NULL == fmt || NULL == fmt->parser_new) {
+		fprintf(stderr, "unknown input format\n");
+		return NULL;
+	}
+
+	if (NULL == (ctx = calloc(1, sizeof(CfParser)))) {
+		fprintf(stderr, "unable to create parser\n");
+		return NULL;
+	}
+
+	ctx->fmt = fmt;
+	if (NULL == (ctx->parser = fmt->parser_new())
+	    || NULL == (ctx->cv = converter_new(CHARSET_UNKNOWN))) {
+		cf_parser_delete(ctx);
+		return NULL;
+	}
+
+	return ctx;
+}
+
+void cf_parser_delete(CfParser *ctx)
+{
+	if (NULL != ctx) {
+		converter_delete(ctx->cv);
+		if (NULL != ctx->parser) {
+			ctx->fmt->parser_delete(ctx->parser);
+		}
+		free(ctx->buf);
+		free(ctx);
+	}
+}
+
+static int cf_parser_push(CfParser *ctx, char *bytes, size_t len)
+{
+	if (0 == len) {
+		return 0;
+	}
+
+	return ctx->fmt->parser_push(ctx->parser, bytes, len);
+}
+
+/* append bytes to the held over partial line */
+static int cf_parser_hold(CfParser *ctx, const char *bytes, size_t len)
+{
+	char *buf = NULL;
+	size_t size;
+
+	if (ctx->len + len > ctx->size) {
+		size = (0 == ctx->size) ? 256 : ctx->size;
+		while (size < ctx->len + len) {
+			size *= 2;
+		}
+		if (NULL == (buf = realloc(ctx->buf, size))) {
+			fprintf(stderr, "unable to allocate memory\n");
+			return -1;
+		}
+		ctx->buf = buf;
+		ctx->size = size;
+	}
+
+	memcpy(ctx->buf + ctx->len, bytes, len);
+	ctx->len += len;
+
+	return 0;
+}
+
+/*
+ * the scanners match whole tokens, so only complete lines are pushed;
+ * a trailing partial line is held until the next feed or finish
+ */
+static int cf_parser_lines(CfParser *ctx, const char *bytes, size_t len)
+{
+	const char *first = NULL;
+	const char *last = NULL;
+	size_t n;
+
+	if (NULL == (first = memchr(bytes, '\n', len))) {
+		return cf_parser_hold(ctx, bytes, len);
+	}
+
+	/* complete the held over line */
+	n = first - bytes + 1;
+	if (0 != ctx->len) {
+		if (0 != cf_parser_hold(ctx, bytes, n)) {
+			return -1;
+		}
+		if (0 != cf_parser_push(ctx, ctx->buf, ctx->len)) {
+			return -1;
+		}
+		ctx->len = 0;
+		bytes += n;
+		len -= n;
+	}
+
+	/* push the remaining complete lines directly */
+	for (last = bytes + len; last > bytes && '\n' != last[-1]; last--)
+		;
+	n = last - bytes;
+	if (0 != cf_parser_push(ctx, (char *) bytes, n)) {
+		return -1;
+	}
+
+	return cf_parser_hold(ctx, bytes + n, len - n);
+}
+
+int cf_parser_feed(CfParser *ctx, const char *bytes, size_t len)
+{
+	if (NULL == (bytes = converter_feed(ctx->cv, bytes, len, &len))) {
+		return -1;
+	}
+
+	return cf_parser_lines(ctx, bytes, len);
+}
+
+int cf_parser_charset(CfParser *ctx)
+{
+	return converter_charset(ctx->cv);
+}
+
+Cd *cf_parser_finish(CfParser *ctx)
+{
+	const char *bytes = NULL;
+	size_t len;
+	Cd *cd = NULL;
+
+	if (NULL != (bytes = converter_finish(ctx->cv, &len))
+	    && 0 == cf_parser_lines(ctx, bytes, len)
+	    && 0 == cf_parser_push(ctx, ctx->buf, ctx->len)) {
+		cd = ctx->fmt->parser_finish(ctx->parser);
+	}
+
+	cf_parser_delete(ctx);
+
+	return cd;
+}
+
+Cd *cf_parse_memory(const char *bytes, size_t len, int format)
+{
+	CfParser *ctx = NULL;
+
+	if (NULL == (ctx = cf_parser_new(format))) {
+		return NULL;
+	}
+	if (0 != cf_parser_feed(ctx, bytes, len)) {
+		cf_parser_delete(ctx);
+		return NULL;
+	}
+
+	return cf_parser_finish(ctx);
+}
+
+/* parse with a format that reads its own file */
+static Cd *cf_read(char *name, const CfFormat *fmt)
+{
+	Cd *cd = NULL;
+	int phase = stats_phase(PHASE_IO);
+
+	cd = fmt->read(name);
+	stats_phase(phase);
+	PROBE3(parse__done, name, 0L, NULL != cd);
+
+	return cd;
+}
+
+/* merge the CD-TEXT of a sheet's CDTEXTFILE; a bad one is only warned of */
+static void cf_read_cdtextfile(Cd *cd, char *sheet)
+{
+	char path[4096];
+
+	cf_data_path(path, sizeof(path), sheet, cd_get_cdtextfile(cd));
+	if (0 != cdt_read(path, cd)) {
+		fprintf(stderr, "%s: CDTEXTFILE ignored\n", sheet);
+	}
+}
 
 Cd *cf_parse(char *name, int *format)
 {
+	const CfFormat *fmt = NULL;
 	FILE *fp = NULL;
+	CfParser *ctx = NULL;
 	Cd *cd = NULL;
+	char *buf = NULL;
+	size_t len;
+	long bytes = 0;
+	int suffix = cf_format_from_suffix(name);
+	int phase;
+	int ret = 0;
 
-	if (UNKNOWN == *format) {
-		if (UNKNOWN == (*format = cf_format_from_suffix(name))) {
-			fprintf(stderr, "%s: unknown file suffix\n", name);
-			return NULL;
-		}
+	/* a file a format reads itself is not sniffed if its suffix says so */
+	if (UNKNOWN == *format && UNKNOWN != suffix
+	    && NULL != formats[suffix]->read) {
+		*format = suffix;
+	}
+	if (UNKNOWN != *format && NULL == (fmt = cf_get_format(*format))) {
+		fprintf(stderr, "%s: unknown format\n", name);
+		return NULL;
 	}
 
+	PROBE1(parse__start, name);
+
+	if (NULL != fmt && NULL != fmt->read) {
+		return cf_read(name, fmt);
+	}
+
+	phase = stats_phase(PHASE_IO);
 	if (0 == strcmp("-", name)) {
 		fp = stdin;
 	} else if (NULL == (fp = fopen(name, "r"))) {
 		fprintf(stderr, "%s: error opening file\n", name);
+		stats_phase(phase);
+		PROBE3(parse__done, name, 0L, 0);
 		return NULL;
 	}
 
-	switch (*format) {
-	case CUE:
-		cd = cue_parse(fp);
-		break;
-	case TOC:
-		cd = toc_parse(fp);
-		break;
+	if (NULL == (buf = malloc(CHUNK_SIZE))) {
+		fprintf(stderr, "unable to allocate memory\n");
+		ret = -1;
+	}
+
+	/* the first read is small, and tells the format if need be */
+	len = (0 == ret) ? fread(buf, 1, SNIFF_SIZE, fp) : 0;
+	if (0 == ret && NULL == fmt) {
+		if (UNKNOWN == (*format = cf_format_sniff((unsigned char *) buf,
+		                                          len))) {
+			*format = suffix;
+		}
+		if (NULL == (fmt = cf_get_format(*format))) {
+			fprintf(stderr, "%s: unknown format\n", name);
+			ret = -1;
+		}
+	}
+
+	/* a misnamed file of a format that reads it itself */
+	if (0 == ret && NULL != fmt->read) {
+		if (stdin != fp) {
+			fclose(fp);
+		}
+		free(buf);
+		stats_phase(phase);
+		return cf_read(name, fmt);
+	}
+
+	if (0 == ret && NULL == (ctx = cf_parser_new(*format))) {
+		ret = -1;
+	}
+
+	while (0 == ret && 0 < len) {
+		stats_count(STATS_BYTES_READ, len);
+		bytes += len;
+		stats_phase(PHASE_PARSE);
+		ret = cf_parser_feed(ctx, buf, len);
+		stats_phase(PHASE_IO);
+		len = fread(buf, 1, CHUNK_SIZE, fp);
+	}
+
+	if (ferror(fp)) {
+		fprintf(stderr, "%s: error reading file\n", name);
+		ret = -1;
 	}
 
 	if(stdin != fp) {
 		fclose(fp);
 	}
+	free(buf);
+
+	stats_phase(PHASE_PARSE);
+	if (0 == ret) {
+		cd = cf_parser_finish(ctx);
+	} else {
+		cf_parser_delete(ctx);
+	}
+	stats_phase(PHASE_IO);
+	if (NULL != cd && NULL != cd_get_cdtextfile(cd)) {
+		cf_read_cdtextfile(cd, name);
+	}
+	stats_phase(phase);
+
+	PROBE3(parse__done, name, bytes, NULL != cd);
 
 	return cd;
 }
 
+void cf_data_path(char *path, size_t size, char *sheet, char *file)
+{
+	char *slash = strrchr(sheet, '/');
+
+	if ('/' == file[0] || NULL == slash || 0 == strcmp("-", sheet)) {
+		snprintf(path, size, "%s", file);
+	} else {
+		snprintf(path, size, "%.*s/%s", (int) (slash - sheet), sheet,
+		         file);
+	}
+}
+
+/* one data file to probe */
+typedef struct ProbeJob ProbeJob;
+struct ProbeJob {
+	char *file;		/* as named in the sheet */
+	char path[4096];
+	int filetype;		/* as given in the sheet */
+	Probe probe;
+	int ret;
+};
+
+/* state shared by the probe threads */
+typedef struct ProbeWork ProbeWork;
+struct ProbeWork {
+	pthread_mutex_t lock;
+	int next;
+	int njob;
+	ProbeJob job[MAXTRACK];
+};
+
+static void *cf_probe_worker(void *arg)
+{
+	ProbeWork *work = arg;
+	ProbeJob *job = NULL;
+
+	for (;;) {
+		pthread_mutex_lock(&work->lock);
+		job = (work->next < work->njob) ? &work->job[work->next++] : NULL;
+		pthread_mutex_unlock(&work->lock);
+
+		if (NULL == job) {
+			return NULL;
+		}
+		job->ret = probe_file(job->path, job->filetype, &job->probe);
+	}
+}
+
+int cf_set_lengths(Cd *cd, char *sheet)
+{
+	ProbeWork *work = NULL;
+	ProbeJob *job = NULL;
+	Track *track = NULL;
+	pthread_t thread[PROBE_THREADS];
+	char *file = NULL;
+	long length;
+	int nthread = 0;
+	int ret = 0;
+	int i;
+	int j;
+
+	if (NULL == (work = calloc(1, sizeof(ProbeWork)))) {
+		fprintf(stderr, "unable to allocate memory\n");
+		return -1;
+	}
+
+	/* each file once */
+	for (i = 1; i <= cd_get_ntrack(cd); i++) {
+		track = cd_get_track(cd, i);
+		if (NULL == (file = track_get_filename(track))) {
+			continue;
+		}
+		for (j = 0; j < work->njob; j++) {
+			if (0 == strcmp(file, work->job[j].file)) {
+				break;
+			}
+		}
+		if (j == work->njob) {
+			job = &work->job[work->njob++];
+			job->file = file;
+			job->filetype = track_get_filetype(track);
+			cf_data_path(job->path, sizeof(job->path), sheet, file);
+		}
+	}
+
+	/* probe them concurrently; this thread works too */
+	pthread_mutex_init(&work->lock, NULL);
+	for (; nthread < PROBE_THREADS && nthread < work->njob - 1; nthread++) {
+		if (0 != pthread_create(&thread[nthread], NULL, cf_probe_worker,
+		                        work)) {
+			break;
+		}
+	}
+	cf_probe_worker(work);
+	while (0 < nthread) {
+		pthread_join(thread[--nthread], NULL);
+	}
+	pthread_mutex_destroy(&work->lock);
+
+	for (j = 0; j < work->njob; j++) {
+		if (0 != work->job[j].ret) {
+			fprintf(stderr, "%s: unable to probe file\n",
+			        work->job[j].path);
+			ret = -1;
+		}
+	}
+
+	for (i = 1; i <= cd_get_ntrack(cd); i++) {
+		track = cd_get_track(cd, i);
+		if (NULL == (file = track_get_filename(track))) {
+			continue;
+		}
+		for (j = 0; 0 != strcmp(file, work->job[j].file); j++) {
+			;
+		}
+		job = &work->job[j];
+		if (0 != job->ret) {
+			continue;
+		}
+
+		if (FILE_UNKNOWN == track_get_filetype(track)) {
+			track_set_filetype(track, job->probe.filetype);
+		}
+		track_set_data_offset(track, job->probe.offset);
+
+		if (0 != track_get_length(track)) {
+			continue;
+		}
+		if (FILE_BINARY == job->probe.filetype
+		    || FILE_MOTOROLA == job->probe.filetype) {
+			length = job->probe.size / track_get_block_size(track);
+		} else {
+			length = job->probe.frames;
+		}
+		length -= track_get_start(track);
+		if (0 < length) {
+			track_set_length(track, length);
+		}
+	}
+
+	free(work);
+
+	if (0 != cd_layout(cd)) {
+		ret = -1;
+	}
+
+	return ret;
+}
+
+int cf_read_list(char *list, int (*fn)(void *arg, char *name), void *arg)
+{
+	FILE *fp = NULL;
+	char *line = NULL;
+	size_t size = 0;
+	ssize_t len;
+	int ret = 0;
+	int r;
+
+	if (0 == strcmp("-", list)) {
+		fp = stdin;
+	} else if (NULL == (fp = fopen(list, "r"))) {
+		fprintf(stderr, "%s: error opening file\n", list);
+		return -1;
+	}
+
+	while (0 <= ret && -1 != (len = getline(&line, &size, fp))) {
+		if (0 < len && '\n' == line[len - 1]) {
+			line[--len] = '\0';
+		}
+		if (0 < len && 0 != (r = fn(arg, line))) {
+			ret = r;
+		}
+	}
+	free(line);
+
+	if (stdin != fp) {
+		fclose(fp);
+	}
+
+	return ret;
+}
+
+int cf_list_add(void *arg, char *name)
+{
+	CfList *list = arg;
+	char **p = NULL;
+
+	if (list->n == list->size) {
+		list->size = (0 == list->size) ? 1024 : 2 * list->size;
+		if (NULL == (p = realloc(list->name,
+		                         list->size * sizeof(char *)))) {
+			fprintf(stderr, "unable to allocate memory\n");
+			return -1;
+		}
+		list->name = p;
+	}
+	if (NULL == (list->name[list->n] = strdup(name))) {
+		fprintf(stderr, "unable to allocate memory\n");
+		return -1;
+	}
+	list->n++;
+
+	return 0;
+}
+
+void cf_list_free(CfList *list)
+{
+	long i;
+
+	for (i = 0; i < list->n; i++) {
+		free(list->name[i]);
+	}
+	free(list->name);
+	list->name = NULL;
+	list->n = 0;
+	list->size = 0;
+}
+
 int cf_print(char *name, int *format, Cd *cd)
 {
+	const CfFormat *fmt = NULL;
 	FILE *fp = NULL;
+	FILE *mp = NULL;	/* output is formatted in memory first */
+	char *buf = NULL;
+	size_t size = 0;
+	int phase;
+	int ret = 0;
 
 	if (UNKNOWN == *format) {
 		if (UNKNOWN == (*format = cf_format_from_suffix(name))) {
@@ -57,39 +793,59 @@ int cf_print(char *name, int *format, Cd *cd)
 		}
 	}
 
+	if (NULL == (fmt = cf_get_format(*format))
+	    || (NULL == fmt->print && NULL == fmt->write)) {
+		fprintf(stderr, "%s: format can not be written\n", name);
+		return -1;
+	}
+
+	PROBE2(print__start, name, *format);
+
+	phase = stats_phase(PHASE_IO);
+	if (NULL != fmt->write) {
+		/* the format writes the file itself */
+		ret = fmt->write(name, cd);
+		stats_phase(phase);
+		PROBE2(print__done, name, (0 == ret) ? 0L : -1L);
+		return ret;
+	}
+
 	if (0 == strcmp("-", name)) {
 		fp = stdout;
 	} else if (NULL == (fp = fopen(name, "w"))) {
 		fprintf(stderr, "%s: error opening file\n", name);
+		stats_phase(phase);
+		PROBE2(print__done, name, -1L);
 		return -1;
 	}
 
-	switch (*format) {
-	case CUE:
-		cue_print(fp, cd);
-		break;
-	case TOC:
-		toc_print(fp, cd);
-		break;
+	stats_phase(PHASE_PRINT);
+	if (NULL == (mp = open_memstream(&buf, &size))) {
+		/* print directly */
+		mp = fp;
+	}
+
+	fmt->print(mp, cd);
+
+	stats_phase(PHASE_IO);
+	if (fp != mp) {
+		fclose(mp);
+		if (size != fwrite(buf, 1, size, fp)) {
+			fprintf(stderr, "%s: error writing file\n", name);
+			ret = -1;
+		}
+		stats_count(STATS_BYTES_WRITTEN, size);
+		free(buf);
 	}
 
 	if(stdout != fp) {
 		fclose(fp);
+	} else {
+		fflush(fp);
 	}
+	stats_phase(phase);
 
-	return 0;
-}
+	PROBE2(print__done, name, (long) size);
 
-int cf_format_from_suffix(char *name)
-{
-	char *suffix;
-	if (0 != (suffix = strrchr(name, '.'))) {
-		if (0 == strcasecmp(".cue", suffix)) {
-			return CUE;
-		} else if (0 == strcasecmp(".toc", suffix)) {
-			return TOC;
-		}
-	}
-
-	return UNKNOWN;
+	return ret;
 }
@@ -7,10 +7,113 @@
 
 #include "cd.h"
 
-enum Format {CUE, TOC, UNKNOWN};
+#include <stdio.h>
+
+/*
+ * the built-in formats, numbered as they are registered
+ * FLAC is a cue sheet embedded in a FLAC file (see flac.h), and APE one in
+ * the APEv2 tag of a Monkey's Audio or WavPack file (see ape.h), which can
+ * only be read
+ */
+enum Format {UNKNOWN = -1, CUE, TOC, FLAC, APE};
+
+#define SNIFF_SIZE	512	/* bytes of input a format is told from */
 
 typedef struct Cue Cue;
+typedef struct CfParser CfParser;
+
+/*
+ * handlers of a format
+ * a text format has a push parser, which cf_parser_*() drive, and a
+ * printer.  A format in a binary file reads and writes the file itself.
+ * Handlers a format does not have are NULL.
+ */
+typedef struct CfFormat CfFormat;
+struct CfFormat {
+	char *name;			/* as given to -i and -o */
+	const char **suffixes;		/* such as ".cue", NULL terminated */
+	/* how sure, from 0 to 100, that the first bytes are this format */
+	int (*sniff)(const unsigned char *head, size_t len);
+	void *(*parser_new)(void);
+	int (*parser_push)(void *parser, char *bytes, size_t len);
+	Cd *(*parser_finish)(void *parser);
+	void (*parser_delete)(void *parser);
+	void (*print)(FILE *fp, Cd *cd);
+	Cd *(*read)(char *name);
+	int (*write)(char *name, Cd *cd);
+};
+
+/*
+ * add a format, before any parsing starts
+ * returns its number, or UNKNOWN if the table is full
+ */
+int cf_register_format(const CfFormat *format);
+const CfFormat *cf_get_format(int format);
+
+/* number of a format by name or file suffix, or UNKNOWN */
+int cf_format_from_name(char *name);
+int cf_format_from_suffix(char *fname);
 
+/* the format the first bytes of a file look most like, or UNKNOWN */
+int cf_format_sniff(const unsigned char *head, size_t len);
+
+/*
+ * parse a file, or stdin if fname is "-"
+ * if *format is UNKNOWN, it is told from the first SNIFF_SIZE bytes, or
+ * failing that from the suffix, and set
+ */
 Cd *cf_parse(char *fname, int *format);
+
+/*
+ * incremental parsing
+ * input may be fed in chunks of any size; a quoted string must not span
+ * lines.  cf_parser_feed() returns -1 once a parse error has been seen.
+ * cf_parser_finish() returns the Cd (NULL on error) and frees the parser
+ *
+ * input in UTF-16, CP1252 or Shift-JIS is detected and converted, so
+ * strings in the Cd are always UTF-8.  cf_parser_charset() returns the
+ * detected enum Charset (see charset.h).
+ */
+CfParser *cf_parser_new(int format);
+int cf_parser_feed(CfParser *ctx, const char *bytes, size_t len);
+int cf_parser_charset(CfParser *ctx);
+Cd *cf_parser_finish(CfParser *ctx);
+void cf_parser_delete(CfParser *ctx);
+
+/* parse a whole sheet of a text format in memory, such as one from a tag */
+Cd *cf_parse_memory(const char *bytes, size_t len, int format);
+
+/*
+ * fill in the length of each track that runs to the end of its file, and
+ * the type of each file the sheet does not give, from the file headers.
+ * file names are relative to the directory of sheet, and the files are
+ * probed concurrently.  The disc is then laid out (see cd_layout()).
+ * returns -1 if a file could not be probed or a length is still unknown
+ */
+int cf_set_lengths(Cd *cd, char *sheet);
+
+/* path of a data file named in sheet */
+void cf_data_path(char *path, size_t size, char *sheet, char *file);
+
+/* names of files, as read by cf_read_list() */
+typedef struct CfList CfList;
+struct CfList {
+	char **name;
+	long n;
+	long size;		/* allocated */
+};
+
+/*
+ * call fn(arg, name) for the name of each file in list, one per line
+ * (- for standard input), skipping empty lines; reading stops if fn
+ * returns a negative value.  returns -1 if list can not be opened, else
+ * the last nonzero value fn returned, or 0
+ */
+int cf_read_list(char *list, int (*fn)(void *arg, char *name), void *arg);
+
+/* add a copy of name to the CfList arg, as fn of cf_read_list() */
+int cf_list_add(void *arg, char *name);
+void cf_list_free(CfList *list);
+
+/* if *format is UNKNOWN, it is set from the suffix */
 int cf_print(char *fname, int *format, Cd *cue);
-int cf_format_from_suffix(char *fname);
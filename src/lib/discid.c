@@ -0,0 +1,159 @@
+/*
+ * discid.c -- CDDB, MusicBrainz and AccurateRip disc IDs
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "cd.h"
+#include "discid.h"
+#include "sha1.h"
+
+static int track_is_data(Track *track)
+{
+	return MODE_AUDIO != track_get_mode(track)
+	       || track_is_set_flag(track, FLAG_DATA);
+}
+
+int discid_toc(Cd *cd, DiscToc *toc)
+{
+	Track *track = NULL;
+	long pos = 0;		/* start of the current track */
+	long length;
+	int i;
+
+	memset(toc, 0, sizeof(DiscToc));
+	toc->ntrack = cd_get_ntrack(cd);
+
+	for (i = 0; i < toc->ntrack; i++) {
+		track = cd_get_track(cd, i + 1);
+		toc->data[i] = track_is_data(track);
+
+		if (0 < i && toc->data[i] && !toc->data[0] && !toc->data[i - 1]) {
+			/* CD-Extra: data session after the audio session */
+			toc->naudio = i;
+			toc->audio_leadout = pos;
+			pos += SESSION_GAP;
+		}
+
+		toc->offset[i] = pos + track_get_index(track,
+		                 (1 < track_get_nindex(track)) ? 1 : 0);
+
+		length = track_get_length(track);
+		if (0 == length) {
+			/* last track of its file; the rest of the file is unknown */
+			fprintf(stderr, "length of track %d unknown\n", i + 1);
+			return -1;
+		}
+		pos += track_get_zero_pre(track) + length
+		       + track_get_zero_post(track);
+	}
+
+	toc->leadout = pos;
+	if (0 == toc->naudio) {
+		toc->naudio = toc->ntrack;
+		toc->audio_leadout = pos;
+	}
+
+	return 0;
+}
+
+/* sum of the decimal digits of n */
+static int digit_sum(long n)
+{
+	int sum = 0;
+
+	for (; 0 < n; n /= 10) {
+		sum += n % 10;
+	}
+
+	return sum;
+}
+
+unsigned long discid_cddb(DiscToc *toc)
+{
+	long n = 0;
+	long t;
+	int i;
+
+	for (i = 0; i < toc->ntrack; i++) {
+		n += digit_sum((toc->offset[i] + LEADIN_FRAMES) / 75);
+	}
+
+	t = (toc->leadout + LEADIN_FRAMES) / 75
+	    - (toc->offset[0] + LEADIN_FRAMES) / 75;
+
+	return ((n % 255) << 24 | t << 8 | toc->ntrack) & 0xFFFFFFFFUL;
+}
+
+/* base64 with the URL and file name safe alphabet MusicBrainz uses */
+static void base64(const unsigned char *in, int len, char *out)
+{
+	static const char alphabet[] =
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789._";
+	unsigned long v;
+	int i;
+
+	for (i = 0; i < len; i += 3) {
+		v = (unsigned long) in[i] << 16;
+		if (i + 1 < len) {
+			v |= in[i + 1] << 8;
+		}
+		if (i + 2 < len) {
+			v |= in[i + 2];
+		}
+		*out++ = alphabet[(v >> 18) & 0x3F];
+		*out++ = alphabet[(v >> 12) & 0x3F];
+		*out++ = (i + 1 < len) ? alphabet[(v >> 6) & 0x3F] : '-';
+		*out++ = (i + 2 < len) ? alphabet[v & 0x3F] : '-';
+	}
+	*out = '\0';
+}
+
+void discid_musicbrainz(DiscToc *toc, char *id)
+{
+	Sha1 ctx;
+	unsigned char digest[SHA1_SIZE];
+	char buf[9];
+	int i;
+
+	/* first and last track of the audio session, then 100 offsets */
+	sha1_init(&ctx);
+	snprintf(buf, sizeof(buf), "%02X", 1);
+	sha1_update(&ctx, buf, 2);
+	snprintf(buf, sizeof(buf), "%02X", toc->naudio);
+	sha1_update(&ctx, buf, 2);
+	snprintf(buf, sizeof(buf), "%08lX", toc->audio_leadout + LEADIN_FRAMES);
+	sha1_update(&ctx, buf, 8);
+	for (i = 0; i < MAXTRACK; i++) {
+		snprintf(buf, sizeof(buf), "%08lX", (i < toc->naudio)
+		         ? toc->offset[i] + LEADIN_FRAMES : 0);
+		sha1_update(&ctx, buf, 8);
+	}
+	sha1_final(&ctx, digest);
+
+	base64(digest, SHA1_SIZE, id);
+}
+
+void discid_accuraterip(DiscToc *toc, unsigned long *id1, unsigned long *id2)
+{
+	int i;
+
+	*id1 = 0;
+	*id2 = 0;
+
+	/* audio tracks only; a leading data track keeps its number */
+	for (i = 0; i < toc->naudio; i++) {
+		if (!toc->data[i]) {
+			*id1 += toc->offset[i];
+			*id2 += ((0 < toc->offset[i]) ? toc->offset[i] : 1) * (i + 1);
+		}
+	}
+	*id1 += toc->audio_leadout;
+	*id2 += toc->audio_leadout * (toc->naudio + 1);
+
+	*id1 &= 0xFFFFFFFFUL;
+	*id2 &= 0xFFFFFFFFUL;
+}
@@ -0,0 +1,47 @@
+/*
+ * discid.h -- CDDB, MusicBrainz and AccurateRip disc IDs
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#ifndef DISCID_H
+#define DISCID_H
+
+#include "cd.h"
+
+#define LEADIN_FRAMES	150	/* LBA 0 is MSF 00:02:00 */
+#define SESSION_GAP	11400	/* lead-out + lead-in between CD-Extra sessions */
+
+#define MUSICBRAINZ_ID_LEN	28	/* characters in a MusicBrainz disc ID */
+
+/* table of contents as found on the disc, in LBA */
+typedef struct DiscToc DiscToc;
+struct DiscToc {
+	int ntrack;			/* number of tracks */
+	long offset[MAXTRACK];		/* start of index 01 of each track */
+	int data[MAXTRACK];		/* non-zero for data tracks */
+	long leadout;			/* start of the lead-out */
+	int naudio;			/* tracks in the audio session */
+	long audio_leadout;		/* end of the audio session (CD-Extra) */
+};
+
+/*
+ * lay out the tracks of cd as a pressed disc
+ * a data track following the audio tracks is taken to be a CD-Extra
+ * data session and moved SESSION_GAP frames out.
+ * returns -1 if the length of a track is unknown, as it is for the last
+ * track of each file in a cue sheet; set it with track_set_length() first
+ */
+int discid_toc(Cd *cd, DiscToc *toc);
+
+/* freedb/CDDB disc ID */
+unsigned long discid_cddb(DiscToc *toc);
+
+/* MusicBrainz disc ID; id must hold MUSICBRAINZ_ID_LEN + 1 characters */
+void discid_musicbrainz(DiscToc *toc, char *id);
+
+/* AccurateRip disc IDs 1 and 2 (ID 3 is the CDDB ID) */
+void discid_accuraterip(DiscToc *toc, unsigned long *id1, unsigned long *id2);
+
+#endif
@@ -0,0 +1,765 @@
+/*
+ * flac.c -- cue sheets embedded in FLAC files
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "cuefile.h"
+#include "cue.h"
+#include "flac.h"
+#include "stats.h"
+
+#define BLOCK_STREAMINFO	0
+#define BLOCK_PADDING		1
+#define BLOCK_VORBIS_COMMENT	4
+#define BLOCK_CUESHEET		5
+
+#define MAX_BLOCK		0xffffff	/* bytes in a block body */
+#define CUESHEET_SIZE		396	/* catalog, lead-in, flags, tracks */
+#define CUESHEET_TRACK		36	/* a track, before its index points */
+#define CUESHEET_INDEX		12
+#define LEAD_IN			88200	/* samples before track 1 on a CD */
+#define LEAD_OUT_CD		170	/* track number of the lead-out */
+#define LEAD_OUT		255
+#define NEW_PADDING		4096	/* left when the file is rewritten */
+#define COPY_SIZE		65536
+
+/* a metadata block */
+typedef struct Block Block;
+struct Block {
+	int type;
+	long pos;		/* of the body in the file */
+	long length;
+	unsigned char *data;	/* body, once read or replaced */
+};
+
+/* the metadata of a FLAC file */
+typedef struct Flac Flac;
+struct Flac {
+	FILE *fp;
+	Block *block;
+	int nblock;
+	long audio;		/* where the frames start */
+	long rate;
+	uint64_t samples;	/* in the stream, 0 if unknown */
+};
+
+static unsigned long get_be32(const unsigned char *p)
+{
+	return (unsigned long) p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+}
+
+static uint64_t get_be64(const unsigned char *p)
+{
+	return (uint64_t) get_be32(p) << 32 | get_be32(p + 4);
+}
+
+static unsigned long get_le32(const unsigned char *p)
+{
+	return p[0] | p[1] << 8 | p[2] << 16 | (unsigned long) p[3] << 24;
+}
+
+static void put_be64(unsigned char *p, uint64_t n)
+{
+	int i;
+
+	for (i = 7; i >= 0; i--, n >>= 8) {
+		p[i] = n & 0xff;
+	}
+}
+
+static void put_le32(unsigned char *p, unsigned long n)
+{
+	p[0] = n & 0xff;
+	p[1] = (n >> 8) & 0xff;
+	p[2] = (n >> 16) & 0xff;
+	p[3] = (n >> 24) & 0xff;
+}
+
+static long samples_to_frames(uint64_t samples, long rate)
+{
+	return samples * 75 / rate;
+}
+
+static uint64_t frames_to_samples(long frames, long rate)
+{
+	return (uint64_t) frames * rate / 75;
+}
+
+static void flac_close(Flac *flac)
+{
+	int i;
+
+	for (i = 0; i < flac->nblock; i++) {
+		free(flac->block[i].data);
+	}
+	free(flac->block);
+	if (NULL != flac->fp) {
+		fclose(flac->fp);
+	}
+}
+
+/* read the body of a block, once */
+static unsigned char *flac_block_read(Flac *flac, Block *block)
+{
+	if (NULL != block->data) {
+		return block->data;
+	}
+
+	/* one more byte, so that an empty block is not a NULL body */
+	if (NULL == (block->data = malloc(block->length + 1))) {
+		fprintf(stderr, "unable to allocate memory\n");
+		return NULL;
+	}
+	if (0 != fseek(flac->fp, block->pos, SEEK_SET)
+	    || (size_t) block->length != fread(block->data, 1, block->length,
+	                                       flac->fp)) {
+		free(block->data);
+		block->data = NULL;
+		return NULL;
+	}
+	stats_count(STATS_BYTES_READ, block->length);
+
+	return block->data;
+}
+
+/* append a block; returns NULL if out of memory */
+static Block *flac_block_add(Flac *flac)
+{
+	Block *block = NULL;
+
+	/* the table grows by powers of two */
+	if (0 == (flac->nblock & (flac->nblock - 1))) {
+		block = realloc(flac->block, (flac->nblock ? 2 * flac->nblock : 8)
+		                             * sizeof(Block));
+		if (NULL == block) {
+			fprintf(stderr, "unable to allocate memory\n");
+			return NULL;
+		}
+		flac->block = block;
+	}
+
+	block = &flac->block[flac->nblock++];
+	memset(block, 0, sizeof(Block));
+
+	return block;
+}
+
+/*
+ * open a FLAC file and find its metadata blocks, skipping from header to
+ * header; only STREAMINFO is read.  flac_close() must be called either way
+ */
+static int flac_open(Flac *flac, char *name, char *mode)
+{
+	unsigned char hdr[4];
+	unsigned char *p = NULL;
+	Block *block = NULL;
+	int last = 0;
+
+	memset(flac, 0, sizeof(Flac));
+	if (NULL == (flac->fp = fopen(name, mode))) {
+		fprintf(stderr, "%s: error opening file\n", name);
+		return -1;
+	}
+	if (4 != fread(hdr, 1, 4, flac->fp) || 0 != memcmp(hdr, "fLaC", 4)) {
+		fprintf(stderr, "%s: not a FLAC file\n", name);
+		return -1;
+	}
+
+	while (!last) {
+		if (4 != fread(hdr, 1, 4, flac->fp)) {
+			fprintf(stderr, "%s: error reading metadata\n", name);
+			return -1;
+		}
+		stats_count(STATS_BYTES_READ, 4);
+		if (NULL == (block = flac_block_add(flac))) {
+			return -1;
+		}
+		block->type = hdr[0] & 0x7f;
+		block->length = hdr[1] << 16 | hdr[2] << 8 | hdr[3];
+		block->pos = ftell(flac->fp);
+		last = hdr[0] & 0x80;
+		if (0 != fseek(flac->fp, block->length, SEEK_CUR)) {
+			fprintf(stderr, "%s: error reading metadata\n", name);
+			return -1;
+		}
+	}
+	flac->audio = ftell(flac->fp);
+
+	block = &flac->block[0];
+	if (BLOCK_STREAMINFO != block->type || 18 > block->length
+	    || NULL == (p = flac_block_read(flac, block))) {
+		fprintf(stderr, "%s: no STREAMINFO block\n", name);
+		return -1;
+	}
+	flac->rate = p[10] << 12 | p[11] << 4 | p[12] >> 4;
+	flac->samples = (uint64_t) (p[13] & 0x0f) << 32 | get_be32(p + 14);
+	if (0 == flac->rate) {
+		fprintf(stderr, "%s: bad STREAMINFO block\n", name);
+		return -1;
+	}
+
+	return 0;
+}
+
+/* offset of the CUESHEET entry in a VORBIS_COMMENT body, or -1 */
+static long comment_find(const unsigned char *p, long length)
+{
+	unsigned long count;
+	unsigned long n;
+	long pos;
+
+	if (8 > length || get_le32(p) > (unsigned long) length - 8) {
+		return -1;
+	}
+	pos = 4 + get_le32(p);	/* past the vendor string */
+	count = get_le32(p + pos);
+	pos += 4;
+
+	for (; 0 < count && pos + 4 <= length; count--) {
+		n = get_le32(p + pos);
+		if (n > (unsigned long) (length - pos - 4)) {
+			return -1;
+		}
+		if (9 <= n && 0 == strncasecmp((char *) p + pos + 4,
+		                               "CUESHEET=", 9)) {
+			return pos;
+		}
+		pos += 4 + n;
+	}
+
+	return -1;
+}
+
+/* add the index points of a CUESHEET track, as the cue parser adds INDEXes */
+static void flac_decode_indexes(Track *track, const unsigned char *t,
+                                long rate)
+{
+	const unsigned char *x = NULL;
+	uint64_t offset = get_be64(t);
+	long frame;
+	int nindex = t[35];
+	int i = 0;
+	int j;
+
+	/* a track with no index points starts at its offset, as index 01 */
+	if (0 == nindex) {
+		track_set_start(track, samples_to_frames(offset, rate));
+		track_add_index(track, 0);
+		track_add_index(track, 0);
+		return;
+	}
+
+	for (j = 0; j < nindex; j++) {
+		x = t + CUESHEET_TRACK + j * CUESHEET_INDEX;
+		frame = samples_to_frames(offset + get_be64(x), rate);
+		if (0 == j) {
+			track_set_start(track, frame);
+		}
+		for (; i <= x[8]; i++) {
+			track_add_index(track, frame - track_get_start(track));
+		}
+	}
+}
+
+/* the tracks of a CUESHEET block, all in the FLAC file name */
+static Cd *flac_decode(Flac *flac, const unsigned char *p, long length,
+                       char *name)
+{
+	Cd *cd = NULL;
+	Track *track = NULL;
+	Track *prev = NULL;
+	const unsigned char *t = NULL;
+	char *file = strrchr(name, '/');
+	char catalog[129];
+	char isrc[13];
+	long pos = CUESHEET_SIZE;
+	int ntrack;
+	int i;
+
+	file = (NULL == file) ? name : file + 1;
+	if (CUESHEET_SIZE > length) {
+		fprintf(stderr, "%s: bad CUESHEET block\n", name);
+		return NULL;
+	}
+
+	cd = cd_init();
+	if (0 != p[0]) {
+		memcpy(catalog, p, 128);
+		catalog[128] = '\0';
+		cd_set_catalog(cd, catalog);
+	}
+
+	ntrack = p[395];
+	for (i = 0; i < ntrack; i++) {
+		t = p + pos;
+		if (pos + CUESHEET_TRACK > length || pos + CUESHEET_TRACK
+		    + t[35] * CUESHEET_INDEX > length) {
+			fprintf(stderr, "%s: bad CUESHEET block\n", name);
+			cd_delete(cd);
+			return NULL;
+		}
+		pos += CUESHEET_TRACK + t[35] * CUESHEET_INDEX;
+
+		/* the lead-out ends the last track */
+		if (LEAD_OUT_CD == t[8] || LEAD_OUT == t[8]) {
+			break;
+		}
+		if (MAXTRACK == cd_get_ntrack(cd)) {
+			fprintf(stderr, "%s: more than %d tracks\n", name,
+			        MAXTRACK);
+			cd_delete(cd);
+			return NULL;
+		}
+
+		prev = track;
+		track = cd_add_track(cd);
+		track_set_filename(track, file);
+		track_set_filetype(track, FILE_WAVE);
+		track_set_mode(track, (t[21] & 0x80) ? MODE_MODE1_RAW
+		                                     : MODE_AUDIO);
+		if (t[21] & 0x40) {
+			track_set_flag(track, FLAG_PRE_EMPHASIS);
+		}
+		if (0 != t[9]) {
+			memcpy(isrc, t + 9, 12);
+			isrc[12] = '\0';
+			track_set_isrc(track, isrc);
+		}
+
+		flac_decode_indexes(track, t, flac->rate);
+		if (NULL != prev) {
+			track_set_length(prev, track_get_start(track)
+			                       - track_get_start(prev));
+		}
+	}
+
+	if (NULL != track && i < ntrack) {
+		track_set_length(track, samples_to_frames(get_be64(t), flac->rate)
+		                        - track_get_start(track));
+	}
+
+	return cd;
+}
+
+int flac_sniff(const unsigned char *head, size_t len)
+{
+	return (4 <= len && 0 == memcmp(head, "fLaC", 4)) ? 100 : 0;
+}
+
+Cd *flac_read(char *name)
+{
+	Flac flac;
+	Block *block = NULL;
+	unsigned char *p = NULL;
+	Cd *cd = NULL;
+	long pos;
+	int found = 0;
+	int i;
+
+	if (0 == strcmp("-", name)) {
+		fprintf(stderr, "FLAC can not be read from standard input\n");
+		return NULL;
+	}
+
+	if (0 == flac_open(&flac, name, "rb")) {
+		/* a CUESHEET comment, which may have CD-TEXT, comes first */
+		for (i = 0; i < flac.nblock && NULL == cd; i++) {
+			block = &flac.block[i];
+			if (BLOCK_VORBIS_COMMENT == block->type
+			    && NULL != (p = flac_block_read(&flac, block))
+			    && -1 != (pos = comment_find(p, block->length))) {
+				found = 1;
+				cd = cf_parse_memory((char *) p + pos + 4 + 9,
+				                     get_le32(p + pos) - 9, CUE);
+			}
+		}
+		for (i = 0; i < flac.nblock && NULL == cd; i++) {
+			block = &flac.block[i];
+			if (BLOCK_CUESHEET == block->type
+			    && NULL != (p = flac_block_read(&flac, block))) {
+				found = 1;
+				cd = flac_decode(&flac, p, block->length, name);
+			}
+		}
+		if (!found) {
+			fprintf(stderr, "%s: no cue sheet found\n", name);
+		}
+	}
+	flac_close(&flac);
+
+	return cd;
+}
+
+/* number of the first index point of a track */
+static int flac_first_index(Track *track)
+{
+	/* index 00 is only kept if the track has a pregap in the file */
+	if (2 > track_get_nindex(track)
+	    || track_get_index(track, 0) == track_get_index(track, 1)) {
+		return 1;
+	}
+
+	return 0;
+}
+
+/* a CUESHEET block body for cd; returns NULL on error */
+static unsigned char *flac_encode(Flac *flac, Cd *cd, long *length)
+{
+	Track *track = NULL;
+	unsigned char *p = NULL;
+	unsigned char *t = NULL;
+	unsigned char *x = NULL;
+	char *file = NULL;
+	uint64_t leadout = flac->samples;
+	int is_cd = (44100 == flac->rate);
+	int ntrack = cd_get_ntrack(cd);
+	int npoint = 0;
+	int first;
+	int i;
+	int j;
+
+	if (0 == ntrack) {
+		fprintf(stderr, "no tracks to write\n");
+		return NULL;
+	}
+	for (i = 1; i <= ntrack; i++) {
+		track = cd_get_track(cd, i);
+		if (NULL == file) {
+			file = track_get_filename(track);
+		} else if (NULL != track_get_filename(track)
+		           && 0 != strcmp(file, track_get_filename(track))) {
+			fprintf(stderr, "tracks are in more than one file\n");
+			return NULL;
+		}
+		if (2 > track_get_nindex(track)) {
+			npoint++;
+		} else {
+			npoint += track_get_nindex(track) - flac_first_index(track);
+		}
+	}
+
+	/* a stream of unknown length ends with the last track */
+	if (0 == leadout) {
+		leadout = frames_to_samples(track_get_start(track)
+		                            + track_get_length(track), flac->rate);
+	}
+
+	*length = CUESHEET_SIZE + (ntrack + 1) * CUESHEET_TRACK
+	          + npoint * CUESHEET_INDEX;
+	if (NULL == (p = calloc(1, *length))) {
+		fprintf(stderr, "unable to allocate memory\n");
+		return NULL;
+	}
+
+	if (NULL != cd_get_catalog(cd)) {
+		strncpy((char *) p, cd_get_catalog(cd), 128);
+	}
+	if (is_cd) {
+		put_be64(p + 128, LEAD_IN);
+		p[136] = 0x80;
+	}
+	p[395] = ntrack + 1;
+
+	t = p + CUESHEET_SIZE;
+	for (i = 1; i <= ntrack; i++) {
+		track = cd_get_track(cd, i);
+		first = flac_first_index(track);
+
+		put_be64(t, frames_to_samples(track_get_start(track), flac->rate));
+		t[8] = i;
+		if (NULL != track_get_isrc(track)) {
+			strncpy((char *) t + 9, track_get_isrc(track), 12);
+		}
+		if (MODE_AUDIO != track_get_mode(track)) {
+			t[21] |= 0x80;
+		}
+		if (track_is_set_flag(track, FLAG_PRE_EMPHASIS)) {
+			t[21] |= 0x40;
+		}
+
+		if (2 > track_get_nindex(track)) {
+			/* index 01 at the start of the track */
+			t[35] = 1;
+			t[CUESHEET_TRACK + 8] = 1;
+		} else {
+			t[35] = track_get_nindex(track) - first;
+			for (j = first; j < track_get_nindex(track); j++) {
+				x = t + CUESHEET_TRACK + (j - first) * CUESHEET_INDEX;
+				put_be64(x, frames_to_samples(
+				         track_get_index(track, j)
+				         - track_get_index(track, first), flac->rate));
+				x[8] = j;
+			}
+		}
+		t += CUESHEET_TRACK + t[35] * CUESHEET_INDEX;
+	}
+
+	put_be64(t, leadout);
+	t[8] = is_cd ? LEAD_OUT_CD : LEAD_OUT;
+
+	return p;
+}
+
+/*
+ * a copy of a VORBIS_COMMENT body with the CUESHEET entry at pos replaced
+ * by the cue sheet of cd
+ */
+static unsigned char *comment_replace(const unsigned char *p, long length,
+                                      long pos, Cd *cd, long *newlength)
+{
+	FILE *mp = NULL;
+	unsigned char *q = NULL;
+	char *text = NULL;
+	size_t size = 0;
+	long old = 4 + get_le32(p + pos);
+
+	if (NULL == (mp = open_memstream(&text, &size))) {
+		fprintf(stderr, "unable to allocate memory\n");
+		return NULL;
+	}
+	fprintf(mp, "CUESHEET=");
+	cue_print(mp, cd);
+	fclose(mp);
+
+	*newlength = length - old + 4 + size;
+	if (MAX_BLOCK < *newlength) {
+		fprintf(stderr, "cue sheet too long for a comment\n");
+	} else if (NULL == (q = malloc(*newlength))) {
+		fprintf(stderr, "unable to allocate memory\n");
+	} else {
+		memcpy(q, p, pos);
+		put_le32(q + pos, size);
+		memcpy(q + pos + 4, text, size);
+		memcpy(q + pos + 4 + size, p + pos + old, length - pos - old);
+	}
+	free(text);
+
+	return q;
+}
+
+/*
+ * put in the new CUESHEET block, which the Flac then owns, and comment,
+ * reading every other block
+ */
+static int flac_replace(Flac *flac, Cd *cd, unsigned char *cuesheet,
+                        long length)
+{
+	Block *block = NULL;
+	unsigned char *p = NULL;
+	long pos;
+	int i;
+
+	/* in place of the first CUESHEET block, or after STREAMINFO */
+	for (i = 0; i < flac->nblock; i++) {
+		if (BLOCK_CUESHEET == flac->block[i].type) {
+			break;
+		}
+	}
+	if (i == flac->nblock) {
+		if (NULL == flac_block_add(flac)) {
+			free(cuesheet);
+			return -1;
+		}
+		memmove(&flac->block[2], &flac->block[1],
+		        (flac->nblock - 2) * sizeof(Block));
+		i = 1;
+		flac->block[i].type = BLOCK_CUESHEET;
+		flac->block[i].pos = -1;
+	}
+	flac->block[i].data = cuesheet;
+	flac->block[i].length = length;
+
+	for (i = 0; i < flac->nblock; i++) {
+		block = &flac->block[i];
+		if (BLOCK_PADDING == block->type || cuesheet == block->data) {
+			continue;
+		}
+		if (BLOCK_CUESHEET == block->type) {
+			/* only one is allowed; the rest are dropped */
+			block->type = BLOCK_PADDING;
+			continue;
+		}
+
+		if (NULL == (p = flac_block_read(flac, block))) {
+			fprintf(stderr, "error reading metadata\n");
+			return -1;
+		}
+		if (BLOCK_VORBIS_COMMENT == block->type
+		    && -1 != (pos = comment_find(p, block->length))) {
+			if (NULL == (p = comment_replace(p, block->length, pos, cd,
+			                                 &block->length))) {
+				return -1;
+			}
+			free(block->data);
+			block->data = p;
+		}
+	}
+
+	return 0;
+}
+
+static int flac_put_block(FILE *fp, int type, int last,
+                          const unsigned char *data, long length)
+{
+	unsigned char hdr[4];
+
+	hdr[0] = type | (last ? 0x80 : 0);
+	hdr[1] = (length >> 16) & 0xff;
+	hdr[2] = (length >> 8) & 0xff;
+	hdr[3] = length & 0xff;
+
+	if (4 != fwrite(hdr, 1, 4, fp)
+	    || (size_t) length != fwrite(data, 1, length, fp)) {
+		return -1;
+	}
+	stats_count(STATS_BYTES_WRITTEN, 4 + length);
+
+	return 0;
+}
+
+/* write the metadata blocks, then padding bytes of padding if not -1 */
+static int flac_put_metadata(Flac *flac, FILE *fp, long padding)
+{
+	unsigned char *zero = NULL;
+	int last = flac->nblock - 1;
+	int ret = 0;
+	int i;
+
+	while (0 < last && BLOCK_PADDING == flac->block[last].type) {
+		last--;
+	}
+
+	for (i = 0; i <= last && 0 == ret; i++) {
+		if (BLOCK_PADDING != flac->block[i].type) {
+			ret = flac_put_block(fp, flac->block[i].type,
+			                     -1 == padding && i == last,
+			                     flac->block[i].data,
+			                     flac->block[i].length);
+		}
+	}
+
+	if (0 == ret && -1 != padding) {
+		if (NULL == (zero = calloc(1, padding + 1))) {
+			fprintf(stderr, "unable to allocate memory\n");
+			return -1;
+		}
+		ret = flac_put_block(fp, BLOCK_PADDING, 1, zero, padding);
+		free(zero);
+	}
+
+	return ret;
+}
+
+/* write the file anew beside the old one, then rename it over the old */
+static int flac_rewrite(Flac *flac, char *name)
+{
+	FILE *fp = NULL;
+	struct stat st;
+	char *tmp = NULL;
+	char *buf = NULL;
+	size_t len;
+	int fd;
+	int ret = 0;
+
+	if (NULL == (tmp = malloc(strlen(name) + 8))
+	    || NULL == (buf = malloc(COPY_SIZE))) {
+		fprintf(stderr, "unable to allocate memory\n");
+		free(tmp);
+		return -1;
+	}
+	sprintf(tmp, "%s.XXXXXX", name);
+	if (-1 == (fd = mkstemp(tmp)) || NULL == (fp = fdopen(fd, "wb"))) {
+		fprintf(stderr, "%s: error opening file\n", tmp);
+		free(tmp);
+		free(buf);
+		return -1;
+	}
+	if (0 == fstat(fileno(flac->fp), &st)) {
+		fchmod(fd, st.st_mode & 07777);
+	}
+
+	if (4 != fwrite("fLaC", 1, 4, fp)
+	    || 0 != flac_put_metadata(flac, fp, NEW_PADDING)
+	    || 0 != fseek(flac->fp, flac->audio, SEEK_SET)) {
+		ret = -1;
+	}
+	while (0 == ret && 0 < (len = fread(buf, 1, COPY_SIZE, flac->fp))) {
+		stats_count(STATS_BYTES_READ, len);
+		if (len != fwrite(buf, 1, len, fp)) {
+			ret = -1;
+		}
+		stats_count(STATS_BYTES_WRITTEN, len);
+	}
+	if (ferror(flac->fp) || 0 != fclose(fp)) {
+		ret = -1;
+	}
+
+	if (0 == ret && 0 != rename(tmp, name)) {
+		ret = -1;
+	}
+	if (0 != ret) {
+		fprintf(stderr, "%s: error writing file\n", name);
+		unlink(tmp);
+	}
+	free(tmp);
+	free(buf);
+
+	return ret;
+}
+
+int flac_write(char *name, Cd *cd)
+{
+	Flac flac;
+	unsigned char *cuesheet = NULL;
+	long length;
+	long size = 4;		/* of "fLaC" and the blocks, but no padding */
+	int ret = -1;
+	int i;
+
+	if (0 == strcmp("-", name)) {
+		fprintf(stderr, "FLAC can not be written to standard output\n");
+		return -1;
+	}
+
+	if (0 != flac_open(&flac, name, "r+b")
+	    || NULL == (cuesheet = flac_encode(&flac, cd, &length))) {
+		flac_close(&flac);
+		return -1;
+	}
+	if (0 != flac_replace(&flac, cd, cuesheet, length)) {
+		flac_close(&flac);
+		return -1;
+	}
+
+	for (i = 0; i < flac.nblock; i++) {
+		if (BLOCK_PADDING != flac.block[i].type) {
+			size += 4 + flac.block[i].length;
+		}
+	}
+
+	/* in place if the padding takes up the difference, as is usual */
+	if (size == flac.audio || size + 4 <= flac.audio) {
+		if (0 != fseek(flac.fp, 4, SEEK_SET)
+		    || 0 != flac_put_metadata(&flac, flac.fp, (size == flac.audio)
+		                              ? -1 : flac.audio - size - 4)
+		    || 0 != fflush(flac.fp)) {
+			fprintf(stderr, "%s: error writing file\n", name);
+		} else {
+			ret = 0;
+		}
+	} else {
+		ret = flac_rewrite(&flac, name);
+	}
+	flac_close(&flac);
+
+	return ret;
+}
@@ -0,0 +1,34 @@
+/*
+ * flac.h -- cue sheets embedded in FLAC files
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#ifndef FLAC_H
+#define FLAC_H
+
+#include <stddef.h>
+#include "cd.h"
+
+/* 100 if the first bytes of a file are a FLAC stream marker, else 0 */
+int flac_sniff(const unsigned char *head, size_t len);
+
+/*
+ * read the cue sheet of a FLAC file from its metadata blocks, without
+ * reading any audio frames.  A CUESHEET Vorbis comment is preferred, as
+ * it may carry CD-TEXT; otherwise the CUESHEET block is read, and its
+ * tracks are in the FLAC file itself.
+ * returns NULL if the file is not FLAC or has no cue sheet
+ */
+Cd *flac_read(char *name);
+
+/*
+ * store cd as the CUESHEET block of an existing FLAC file, and as its
+ * CUESHEET Vorbis comment if it has one.  The metadata is rewritten in
+ * place if there is padding enough, and the whole file otherwise.
+ * returns -1 if the tracks are not all in one file or on error
+ */
+int flac_write(char *name, Cd *cd);
+
+#endif
@@ -0,0 +1,395 @@
+/*
+ * lint.c -- check a disc against the Red Book
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "cuefile.h"
+#include "cdtime.h"
+#include "lint.h"
+#include "probe.h"
+
+#define CD_FRAME_BYTES	2352	/* bytes of CD-DA in a frame */
+
+/* a data file of the sheet, probed once */
+typedef struct LintFile LintFile;
+struct LintFile {
+	char *name;
+	int ret;		/* of probe_file() */
+	Probe probe;
+};
+
+/* where the problems go */
+typedef struct Lint Lint;
+struct Lint {
+	LintReport report;
+	void *arg;
+	int count;
+};
+
+static void lint_report(Lint *lint, int severity, const char *check,
+                        int trackno, const char *fmt, ...)
+{
+	LintIssue issue;
+	va_list ap;
+
+	issue.severity = severity;
+	issue.check = check;
+	issue.trackno = trackno;
+	va_start(ap, fmt);
+	vsnprintf(issue.text, sizeof(issue.text), fmt, ap);
+	va_end(ap);
+
+	lint->report(lint->arg, &issue);
+	lint->count++;
+}
+
+/* mm:ss:ff, as time_frame_to_mmssff() but into buf, for the threads */
+static char *lint_msf(char *buf, long frame)
+{
+	int m, s, f;
+
+	time_frame_to_msf(frame, &m, &s, &f);
+	sprintf(buf, "%02d:%02d:%02d", m, s, f);
+
+	return buf;
+}
+
+/* the mode as written on the disc: audio, mode 1 or mode 2 */
+static int lint_disc_mode(Track *track)
+{
+	switch (track_get_mode(track)) {
+	case MODE_AUDIO:
+		return 0;
+	case MODE_MODE1:
+	case MODE_MODE1_RAW:
+		return 1;
+	default:
+		return 2;
+	}
+}
+
+/* a track's length is unknown if it runs to the end of a file not probed */
+static int lint_known(Track *track)
+{
+	return 0 != track_get_length(track)
+	       || NULL == track_get_filename(track);
+}
+
+/* the frames of a track, gaps and all */
+static long lint_track_frames(Track *track)
+{
+	return track_get_zero_pre(track) + track_get_length(track)
+	       + track_get_zero_post(track);
+}
+
+/* CCOOOYYSSSSS: country, owner, year and serial number */
+static int lint_isrc_ok(const char *isrc)
+{
+	int i;
+
+	if (12 != strlen(isrc)) {
+		return 0;
+	}
+	for (i = 0; i < 12; i++) {
+		if (2 > i && !isupper((unsigned char) isrc[i])) {
+			return 0;
+		}
+		if (2 <= i && 5 > i && !isupper((unsigned char) isrc[i])
+		    && !isdigit((unsigned char) isrc[i])) {
+			return 0;
+		}
+		if (5 <= i && !isdigit((unsigned char) isrc[i])) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+/* thirteen digits, an EAN/UPC */
+static int lint_catalog_ok(const char *catalog)
+{
+	int i;
+
+	for (i = 0; isdigit((unsigned char) catalog[i]); i++) {
+		;
+	}
+
+	return 13 == i && '\0' == catalog[i];
+}
+
+static void lint_codes(Lint *lint, Cd *cd)
+{
+	char *code = NULL;
+	int i;
+
+	if (NULL != (code = cd_get_catalog(cd)) && !lint_catalog_ok(code)) {
+		lint_report(lint, LINT_ERROR, "catalog", 0,
+		            "catalog number `%s' is not 13 digits", code);
+	}
+	for (i = 1; i <= cd_get_ntrack(cd); i++) {
+		code = track_get_isrc(cd_get_track(cd, i));
+		if (NULL != code && !lint_isrc_ok(code)) {
+			lint_report(lint, LINT_ERROR, "isrc", i, "ISRC `%s' is"
+			            " not of the form CCOOOYYSSSSS", code);
+		}
+	}
+}
+
+/* where index i is in the track's file, as the sheet gives it */
+static long lint_index_time(Track *track, int i)
+{
+	return track_get_index(track, i) - track_get_zero_pre(track)
+	       + track_get_start(track);
+}
+
+static void lint_indexes(Lint *lint, Track *track, int trackno)
+{
+	char a[16], b[16];
+	long frames = lint_track_frames(track);
+	int i;
+
+	if (0 > track_get_length(track)) {
+		lint_report(lint, LINT_ERROR, "index-order", trackno,
+		            "track starts before track %d in the same file",
+		            trackno - 1);
+		return;
+	}
+
+	for (i = 1; i < track_get_nindex(track); i++) {
+		if (track_get_index(track, i) < track_get_index(track, i - 1)) {
+			lint_report(lint, LINT_ERROR, "index-order", trackno,
+			            "index %02d (%s) is before index %02d (%s)",
+			            i, lint_msf(a, lint_index_time(track, i)),
+			            i - 1,
+			            lint_msf(b, lint_index_time(track, i - 1)));
+		}
+	}
+
+	i = track_get_nindex(track) - 1;
+	if (lint_known(track) && 0 < i && track_get_index(track, i) >= frames) {
+		lint_report(lint, LINT_ERROR, "index-order", trackno,
+		            "index %02d (%s) is past the end of the track (%s)",
+		            i, lint_msf(a, track_get_index(track, i)),
+		            lint_msf(b, frames));
+	}
+}
+
+/*
+ * the frames of the pregap of a track at the end of the file of the track
+ * before, prev, or -1 if not known
+ */
+static long lint_pregap_before(Lint *lint, Track *prev, Track *track,
+                               int trackno)
+{
+	char a[16];
+	long start = track_get_pregap_start(track);
+	long before;
+
+	if (0 > start) {
+		return 0;
+	}
+	if (0 == track_get_length(prev)) {
+		return -1;
+	}
+
+	before = track_get_start(prev) + track_get_length(prev) - start;
+	if (0 > before || track_get_length(prev) < before) {
+		lint_report(lint, LINT_ERROR, "index-order", trackno,
+		            "index 00 (%s) is outside track %d, in the same"
+		            " file", lint_msf(a, start), trackno - 1);
+		return -1;
+	}
+
+	return before;
+}
+
+static void lint_lengths(Lint *lint, Cd *cd)
+{
+	Track *track = NULL;
+	Track *prev = NULL;
+	char a[16];
+	long pregap;
+	long before;		/* of the pregap, in the file of prev */
+	long total = 0;
+	int known = 1;
+	int i;
+
+	for (i = 1; i <= cd_get_ntrack(cd); i++) {
+		track = cd_get_track(cd, i);
+		lint_indexes(lint, track, i);
+
+		pregap = (0 < track_get_index(track, 1))
+		         ? track_get_index(track, 1) : 0;
+		before = (NULL != prev) ? lint_pregap_before(lint, prev, track,
+		                                             i) : 0;
+		if (NULL != prev && lint_disc_mode(prev) != lint_disc_mode(track)
+		    && 0 <= before && LINT_MIN_PREGAP > pregap + before) {
+			lint_report(lint, LINT_ERROR, "pregap", i, "pregap of"
+			            " %s before a change of mode is under 2"
+			            " seconds", lint_msf(a, pregap + before));
+		}
+		prev = track;
+
+		if (!lint_known(track)) {
+			known = 0;
+			continue;
+		}
+		total += lint_track_frames(track);
+		if (0 <= track_get_length(track)
+		    && LINT_MIN_TRACK > lint_track_frames(track) - pregap) {
+			lint_report(lint, LINT_ERROR, "track-length", i,
+			            "track is %s long, under 4 seconds",
+			            lint_msf(a, lint_track_frames(track) - pregap));
+		}
+	}
+
+	if (known && LINT_MAX_DISC < total) {
+		lint_report(lint, LINT_ERROR, "disc-length", 0, "disc is %s"
+		            " long, over 79:59:74", lint_msf(a, total));
+	}
+}
+
+/* the LintFile of each track, probed on first use */
+static void lint_probe(Lint *lint, Cd *cd, char *sheet, LintFile *file,
+                       LintFile **of)
+{
+	char path[4096];
+	char *name = NULL;
+	int nfile = 0;
+	int i;
+	int j;
+
+	for (i = 1; i <= cd_get_ntrack(cd); i++) {
+		of[i] = NULL;
+		if (NULL == (name = track_get_filename(cd_get_track(cd, i)))) {
+			continue;
+		}
+		for (j = 0; j < nfile && 0 != strcmp(name, file[j].name); j++) {
+			;
+		}
+		if (j == nfile) {
+			file[j].name = name;
+			cf_data_path(path, sizeof(path), sheet, name);
+			file[j].ret = probe_file(path,
+			                         track_get_filetype(cd_get_track(cd, i)),
+			                         &file[j].probe);
+			if (0 != file[j].ret) {
+				lint_report(lint, LINT_ERROR, "file", i,
+				            "unable to read `%s'", path);
+			}
+			nfile++;
+		}
+		of[i] = &file[j];
+	}
+}
+
+/*
+ * set the unknown lengths from the files, and check that each file holds
+ * whole sectors and all of its tracks
+ */
+static void lint_files(Lint *lint, Cd *cd, char *sheet)
+{
+	LintFile file[MAXTRACK];
+	LintFile *of[MAXTRACK + 1];
+	Track *track = NULL;
+	Probe *probe = NULL;
+	long block;
+	long frames;		/* in the file */
+	long end;
+	int raw;
+	int i;
+
+	lint_probe(lint, cd, sheet, file, of);
+
+	for (i = 1; i <= cd_get_ntrack(cd); i++) {
+		track = cd_get_track(cd, i);
+		if (NULL == of[i] || 0 != of[i]->ret) {
+			continue;
+		}
+		probe = &of[i]->probe;
+		raw = FILE_BINARY == probe->filetype
+		      || FILE_MOTOROLA == probe->filetype;
+
+		/* an encoding probe_file() does not know, as FLAC */
+		if (raw && (FILE_WAVE == track_get_filetype(track)
+		            || FILE_AIFF == track_get_filetype(track))) {
+			continue;
+		}
+
+		if (FILE_UNKNOWN == track_get_filetype(track)) {
+			track_set_filetype(track, probe->filetype);
+		}
+		track_set_data_offset(track, probe->offset);
+
+		block = raw ? track_get_block_size(track) : CD_FRAME_BYTES;
+		frames = raw ? probe->size / block : probe->frames;
+
+		if (!raw && MODE_AUDIO != track_get_mode(track)) {
+			lint_report(lint, LINT_ERROR, "file-size", i, "data track"
+			            " in audio file `%s'", of[i]->name);
+		}
+
+		if (0 == track_get_length(track)) {
+			if (0 < frames - track_get_start(track)) {
+				track_set_length(track,
+				                 frames - track_get_start(track));
+			}
+		} else if (frames < (end = track_get_start(track)
+		                      + track_get_length(track))) {
+			lint_report(lint, LINT_ERROR, "file-size", i, "track"
+			            " ends %ld frames after the end of `%s'",
+			            end - frames, of[i]->name);
+		}
+
+		/* the last track of the file takes the rest of it */
+		if (i < cd_get_ntrack(cd) && of[i + 1] == of[i]) {
+			continue;
+		}
+		if (0 == track_get_length(track)) {
+			lint_report(lint, LINT_ERROR, "file-size", i, "track"
+			            " starts after the end of `%s'", of[i]->name);
+		} else if (raw && 0 != probe->size % block) {
+			lint_report(lint, LINT_ERROR, "file-size", i, "`%s' is"
+			            " not a whole number of %ld-byte sectors"
+			            " (%ld bytes over)", of[i]->name, block,
+			            probe->size % block);
+		} else if (!raw && FILE_MP3 != probe->filetype
+		           && 44100 == probe->rate && 2 == probe->channels
+		           && 16 == probe->bits
+		           && 0 != probe->size % CD_FRAME_BYTES) {
+			lint_report(lint, LINT_WARNING, "file-size", i, "`%s' is"
+			            " not a whole number of frames and will be"
+			            " padded (%ld bytes over)", of[i]->name,
+			            probe->size % CD_FRAME_BYTES);
+		}
+	}
+}
+
+int lint_cd(Cd *cd, char *sheet, int flags, LintReport report, void *arg)
+{
+	Lint lint;
+
+	lint.report = report;
+	lint.arg = arg;
+	lint.count = 0;
+
+	lint_codes(&lint, cd);
+	if (LINT_FILES & flags) {
+		lint_files(&lint, cd, sheet);
+	}
+	lint_lengths(&lint, cd);
+
+	return lint.count;
+}
+
+const char *lint_severity_name(int severity)
+{
+	return (LINT_ERROR == severity) ? "error" : "warning";
+}
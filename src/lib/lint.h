@@ -0,0 +1,63 @@
+/*
+ * lint.h -- check a disc against the Red Book
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#ifndef LINT_H
+#define LINT_H
+
+#include "cd.h"
+
+#define LINT_MIN_TRACK	300	/* frames in the shortest track (4 s) */
+#define LINT_MIN_PREGAP	150	/* frames of pregap where the mode changes */
+#define LINT_MAX_DISC	359999	/* frames on the longest disc (79:59:74) */
+
+enum LintSeverity {
+	LINT_ERROR,		/* will not burn, or not as meant */
+	LINT_WARNING		/* will burn, but probably not as meant */
+};
+
+/* what lint_cd() checks */
+enum LintFlags {
+	LINT_SHEET	= 0x00,	/* the sheet alone */
+	LINT_FILES	= 0x01	/* and the data files it names */
+};
+
+/* a problem found */
+typedef struct LintIssue LintIssue;
+struct LintIssue {
+	int severity;		/* enum LintSeverity */
+	const char *check;	/* name of the check, as "isrc" */
+	int trackno;		/* 0 for the disc */
+	char text[160];
+};
+
+typedef void (*LintReport)(void *arg, const LintIssue *issue);
+
+/*
+ * check a disc and call report for each problem found:
+ *   track-length	a track plays for less than 4 seconds
+ *   pregap		a track of another mode than the one before it has
+ *			less than 2 seconds of pregap
+ *   disc-length	the tracks play for more than 79:59:74
+ *   index-order	an index is not after the one before it, or not
+ *			inside its track
+ *   isrc, catalog	a code is not of the form of an ISRC or an MCN
+ *   file		with LINT_FILES, a data file can not be read
+ *   file-size		with LINT_FILES, a data file does not hold a whole
+ *			number of sectors of its tracks' mode, or ends
+ *			before its tracks do
+ *
+ * with LINT_FILES the unknown lengths are set from the files (see
+ * cf_set_lengths()), which are found relative to sheet; otherwise
+ * tracks of unknown length are not checked for length.
+ * returns the number of problems
+ */
+int lint_cd(Cd *cd, char *sheet, int flags, LintReport report,
+            void *arg);
+
+const char *lint_severity_name(int severity);
+
+#endif
@@ -0,0 +1,162 @@
+/*
+ * pool.c -- run a job per file on threads, taking the results in order
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include "pool.h"
+#include "stats.h"
+
+/* a result, once its job is done */
+typedef struct PoolSlot PoolSlot;
+struct PoolSlot {
+	void *result;
+	int done;
+};
+
+/*
+ * state shared by the pool threads and the taker
+ * jobs are run in any order but taken in order, at most POOL_QUEUE ahead
+ */
+typedef struct Pool Pool;
+struct Pool {
+	pthread_mutex_t lock;
+	pthread_cond_t done;
+	pthread_cond_t taken;
+	long n;
+	long next;		/* next job to run */
+	long ntaken;
+	int stop;
+	PoolJob job;
+	void *arg;
+	PoolSlot slot[POOL_QUEUE];
+};
+
+static void *pool_worker(void *arg)
+{
+	Pool *pool = arg;
+	PoolSlot *slot = NULL;
+	void *result = NULL;
+	long i;
+
+	for (;;) {
+		pthread_mutex_lock(&pool->lock);
+		while (!pool->stop && pool->next < pool->n
+		       && pool->next >= pool->ntaken + POOL_QUEUE) {
+			pthread_cond_wait(&pool->taken, &pool->lock);
+		}
+		if (pool->stop || pool->next >= pool->n) {
+			pthread_mutex_unlock(&pool->lock);
+			return NULL;
+		}
+		i = pool->next++;
+		pthread_mutex_unlock(&pool->lock);
+
+		result = pool->job(pool->arg, i);
+
+		pthread_mutex_lock(&pool->lock);
+		slot = &pool->slot[i % POOL_QUEUE];
+		slot->result = result;
+		slot->done = 1;
+		pthread_cond_broadcast(&pool->done);
+		pthread_mutex_unlock(&pool->lock);
+	}
+}
+
+/* take the results in order as the pool threads finish them */
+static int pool_take(Pool *pool, PoolTake take)
+{
+	PoolSlot slot;
+	int ret = 0;
+	long i;
+
+	for (i = 0; i < pool->n && 0 == ret; i++) {
+		pthread_mutex_lock(&pool->lock);
+		while (!pool->slot[i % POOL_QUEUE].done) {
+			pthread_cond_wait(&pool->done, &pool->lock);
+		}
+		slot = pool->slot[i % POOL_QUEUE];
+		pool->slot[i % POOL_QUEUE].done = 0;
+		pool->ntaken++;
+		pthread_cond_broadcast(&pool->taken);
+		pthread_mutex_unlock(&pool->lock);
+
+		ret = take(pool->arg, i, slot.result);
+	}
+
+	return ret;
+}
+
+/* run and take each job in turn on this thread */
+static int pool_serial(long n, PoolJob job, PoolTake take, void *arg)
+{
+	int ret = 0;
+	long i;
+
+	for (i = 0; i < n && 0 == ret; i++) {
+		ret = take(arg, i, job(arg, i));
+	}
+
+	return (0 == ret) ? 0 : -1;
+}
+
+int pool_run(long n, int njobs, PoolJob job, PoolTake take, PoolDrop drop,
+             void *arg)
+{
+	pthread_t thread[POOL_MAXJOBS];
+	Pool *pool = NULL;
+	int nthread = 0;
+	int ret;
+	int i;
+
+	if (0 >= njobs || 1 >= n
+	    || NULL == (pool = stats_calloc(1, sizeof(Pool)))) {
+		return pool_serial(n, job, take, arg);
+	}
+	if (POOL_MAXJOBS < njobs) {
+		njobs = POOL_MAXJOBS;
+	}
+
+	pool->n = n;
+	pool->job = job;
+	pool->arg = arg;
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->done, NULL);
+	pthread_cond_init(&pool->taken, NULL);
+
+	for (; nthread < njobs; nthread++) {
+		if (0 != pthread_create(&thread[nthread], NULL, pool_worker,
+		                        pool)) {
+			break;
+		}
+	}
+	if (0 == nthread) {
+		ret = pool_serial(n, job, take, arg);
+	} else {
+		ret = pool_take(pool, take);
+	}
+
+	/* once take stops, the threads stop and their results are dropped */
+	pthread_mutex_lock(&pool->lock);
+	pool->stop = 1;
+	pthread_cond_broadcast(&pool->taken);
+	pthread_mutex_unlock(&pool->lock);
+	while (0 < nthread) {
+		pthread_join(thread[--nthread], NULL);
+	}
+	for (i = 0; i < POOL_QUEUE; i++) {
+		if (pool->slot[i].done && NULL != drop) {
+			drop(arg, pool->slot[i].result);
+		}
+	}
+
+	pthread_cond_destroy(&pool->taken);
+	pthread_cond_destroy(&pool->done);
+	pthread_mutex_destroy(&pool->lock);
+	free(pool);
+
+	return (0 == ret) ? 0 : -1;
+}
@@ -0,0 +1,35 @@
+/*
+ * pool.h -- run a job per file on threads, taking the results in order
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#ifndef POOL_H
+#define POOL_H
+
+#define POOL_MAXJOBS	256
+#define POOL_QUEUE	1024	/* jobs run ahead of the results taken */
+
+/* run on a pool thread; returns the result of job i (may be NULL) */
+typedef void *(*PoolJob)(void *arg, long i);
+
+/* run on the calling thread, in order of i; -1 to take no more */
+typedef int (*PoolTake)(void *arg, long i, void *result);
+
+/* free a result that was not taken */
+typedef void (*PoolDrop)(void *arg, void *result);
+
+/*
+ * run job(arg, i) for i from 0 to n - 1 on njobs threads, and pass each
+ * result to take(arg, i, result) on the calling thread in order of i
+ * once take returns -1 the jobs stop, and the results left are passed to
+ * drop (if not NULL).  With njobs 0, or if no thread can be started,
+ * each job is run and taken in turn on the calling thread, as to time
+ * it with stats_file_begin()
+ * returns -1 if take did, or 0
+ */
+int pool_run(long n, int njobs, PoolJob job, PoolTake take, PoolDrop drop,
+             void *arg);
+
+#endif
@@ -0,0 +1,369 @@
+/*
+ * probe.c -- audio file header probing
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "cd.h"
+#include "probe.h"
+
+#define CD_RATE			44100
+#define CD_FRAME_BYTES		2352
+
+/* a file on disk or in memory */
+typedef struct Source Source;
+struct Source {
+	FILE *fp;
+	const unsigned char *data;
+	long size;
+};
+
+/* read up to n bytes at pos; returns the number read */
+static size_t source_read(Source *src, long pos, unsigned char *buf, size_t n)
+{
+	if (0 > pos || pos >= src->size) {
+		return 0;
+	}
+	if ((long) n > src->size - pos) {
+		n = src->size - pos;
+	}
+
+	if (NULL != src->data) {
+		memcpy(buf, src->data + pos, n);
+		return n;
+	}
+	if (0 != fseek(src->fp, pos, SEEK_SET)) {
+		return 0;
+	}
+
+	return fread(buf, 1, n, src->fp);
+}
+
+static unsigned long get_le16(const unsigned char *p)
+{
+	return p[0] | p[1] << 8;
+}
+
+static unsigned long get_le32(const unsigned char *p)
+{
+	return p[0] | p[1] << 8 | p[2] << 16 | (unsigned long) p[3] << 24;
+}
+
+static unsigned long get_be16(const unsigned char *p)
+{
+	return p[0] << 8 | p[1];
+}
+
+static unsigned long get_be32(const unsigned char *p)
+{
+	return (unsigned long) p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+}
+
+/* playing time of the sample data, in CD frames */
+static void set_frames(Probe *probe)
+{
+	long bytes = probe->channels * probe->bits / 8;
+
+	probe->frames = 0;
+	if (0 < bytes && 0 < probe->rate) {
+		probe->frames = (double) (probe->size / bytes) * 75 / probe->rate;
+	}
+}
+
+/* headerless CD-DA */
+static int probe_raw(Source *src, int filetype, Probe *probe)
+{
+	probe->filetype = (FILE_MOTOROLA == filetype) ? FILE_MOTOROLA
+	                                              : FILE_BINARY;
+	probe->offset = 0;
+	probe->size = src->size;
+	probe->rate = CD_RATE;
+	probe->channels = 2;
+	probe->bits = 16;
+	probe->big_endian = (FILE_MOTOROLA == filetype);
+	probe->frames = src->size / CD_FRAME_BYTES;
+
+	return 0;
+}
+
+/* RIFF WAVE: a fmt chunk, then a data chunk */
+static int probe_wave(Source *src, Probe *probe)
+{
+	unsigned char hdr[16];
+	long pos = 12;
+	unsigned long chunk;
+
+	probe_raw(src, FILE_BINARY, probe);
+	probe->filetype = FILE_WAVE;
+
+	while (8 == source_read(src, pos, hdr, 8)) {
+		chunk = get_le32(hdr + 4);
+		if (0 == memcmp(hdr, "fmt ", 4)) {
+			if (16 > chunk || 16 != source_read(src, pos + 8, hdr, 16)) {
+				return -1;
+			}
+			probe->channels = get_le16(hdr + 2);
+			probe->rate = get_le32(hdr + 4);
+			probe->bits = get_le16(hdr + 14);
+		} else if (0 == memcmp(hdr, "data", 4)) {
+			probe->offset = pos + 8;
+			probe->size = src->size - probe->offset;
+			/* a streamed file may leave the size unset */
+			if (0 != chunk && chunk < (unsigned long) probe->size) {
+				probe->size = chunk;
+			}
+			set_frames(probe);
+			return 0;
+		}
+		pos += 8 + chunk + (chunk & 1);
+	}
+
+	return -1;
+}
+
+/* the 80-bit extended sample rate of an AIFF COMM chunk */
+static long get_be80(const unsigned char *p)
+{
+	int exp = (p[0] & 0x7f) << 8 | p[1];
+	unsigned long mant = get_be32(p + 2);
+
+	/* the top 32 bits of the mantissa are plenty for a sample rate */
+	if (16383 > exp || 16383 + 31 < exp) {
+		return 0;
+	}
+
+	return mant >> (16383 + 31 - exp);
+}
+
+/*
+ * AIFF or AIFF-C: a COMM chunk, then an SSND chunk
+ * the samples are big-endian, but for AIFF-C of compression type sowt
+ */
+static int probe_aiff(Source *src, Probe *probe)
+{
+	unsigned char hdr[18];
+	long pos = 12;
+	unsigned long chunk;
+
+	probe_raw(src, FILE_MOTOROLA, probe);
+	probe->filetype = FILE_AIFF;
+
+	while (8 == source_read(src, pos, hdr, 8)) {
+		chunk = get_be32(hdr + 4);
+		if (0 == memcmp(hdr, "COMM", 4)) {
+			if (18 > chunk || 18 != source_read(src, pos + 8, hdr, 18)) {
+				return -1;
+			}
+			probe->channels = get_be16(hdr);
+			probe->bits = get_be16(hdr + 6);
+			probe->rate = get_be80(hdr + 8);
+			if (22 <= chunk && 4 == source_read(src, pos + 26, hdr, 4)
+			    && 0 == memcmp(hdr, "sowt", 4)) {
+				probe->big_endian = 0;
+			}
+		} else if (0 == memcmp(hdr, "SSND", 4)) {
+			if (8 > chunk || 8 != source_read(src, pos + 8, hdr, 8)) {
+				return -1;
+			}
+			probe->offset = pos + 16 + get_be32(hdr);
+			probe->size = chunk - 8 - get_be32(hdr);
+			if (probe->size > src->size - probe->offset) {
+				probe->size = src->size - probe->offset;
+			}
+			set_frames(probe);
+			return 0;
+		}
+		pos += 8 + chunk + (chunk & 1);
+	}
+
+	return -1;
+}
+
+/* kbit/s, by MPEG-1 layer I, II, III, then MPEG-2 layer I, II and III */
+static const int bitrates[5][15] = {
+	{0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448},
+	{0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384},
+	{0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320},
+	{0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256},
+	{0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160}
+};
+
+static const long samplerates[3] = {44100, 48000, 32000};
+
+/* an MPEG audio frame header */
+typedef struct Mpeg Mpeg;
+struct Mpeg {
+	int mpeg1;
+	int layer;
+	long bitrate;		/* bit/s */
+	long rate;
+	int channels;
+	long samples;		/* samples per frame */
+	long length;		/* bytes in the frame */
+	int side;		/* bytes of layer III side information */
+};
+
+/* parse the frame header at p; returns -1 if it is not one */
+static int mpeg_header(const unsigned char *p, Mpeg *m)
+{
+	int version = (p[1] >> 3) & 3;	/* 0: 2.5, 2: 2, 3: 1 */
+	int brindex = p[2] >> 4;
+	int srindex = (p[2] >> 2) & 3;
+	int pad = (p[2] >> 1) & 1;
+
+	if (0xff != p[0] || 0xe0 != (p[1] & 0xe0) || 1 == version
+	    || 0 == (p[1] & 0x06) || 0 == brindex || 15 == brindex
+	    || 3 == srindex) {
+		return -1;
+	}
+
+	m->mpeg1 = (3 == version);
+	m->layer = 4 - ((p[1] >> 1) & 3);
+	m->bitrate = 1000L * bitrates[m->mpeg1 ? m->layer - 1
+	             : (1 == m->layer) ? 3 : 4][brindex];
+	m->rate = samplerates[srindex] >> (3 - version - (0 == version));
+	m->channels = (3 == (p[3] >> 6)) ? 1 : 2;
+
+	if (1 == m->layer) {
+		m->samples = 384;
+		m->length = (12 * m->bitrate / m->rate + pad) * 4;
+	} else if (2 == m->layer || m->mpeg1) {
+		m->samples = 1152;
+		m->length = 144 * m->bitrate / m->rate + pad;
+	} else {
+		m->samples = 576;
+		m->length = 72 * m->bitrate / m->rate + pad;
+	}
+
+	if (m->mpeg1) {
+		m->side = (1 == m->channels) ? 17 : 32;
+	} else {
+		m->side = (1 == m->channels) ? 9 : 17;
+	}
+
+	return 0;
+}
+
+/*
+ * MP3: skip any ID3v2 tag, find the first frame, and take the number of
+ * frames from a Xing or VBRI header, or else from the bitrate
+ */
+static int probe_mp3(Source *src, Probe *probe)
+{
+	unsigned char buf[PROBE_SIZE];
+	unsigned char *p = NULL;
+	Mpeg m;
+	Mpeg next;
+	long pos = 0;
+	long end = src->size;
+	long nframes = -1;
+	size_t n;
+	size_t i;
+
+	probe_raw(src, FILE_BINARY, probe);
+	probe->filetype = FILE_MP3;
+
+	if (10 == source_read(src, 0, buf, 10) && 0 == memcmp(buf, "ID3", 3)) {
+		pos = 10 + ((buf[6] & 0x7f) << 21 | (buf[7] & 0x7f) << 14
+		            | (buf[8] & 0x7f) << 7 | (buf[9] & 0x7f));
+		if (buf[5] & 0x10) {
+			pos += 10;	/* footer */
+		}
+	}
+	if (3 == source_read(src, end - 128, buf, 3)
+	    && 0 == memcmp(buf, "TAG", 3)) {
+		end -= 128;	/* ID3v1 */
+	}
+
+	/* a frame header is only believed if the next frame follows it */
+	n = source_read(src, pos, buf, sizeof(buf));
+	for (i = 0; i + 4 <= n; i++) {
+		if (0 == mpeg_header(buf + i, &m)
+		    && (i + m.length + 4 > n
+		        || 0 == mpeg_header(buf + i + m.length, &next))) {
+			break;
+		}
+	}
+	if (i + 4 > n) {
+		return -1;
+	}
+	p = buf + i;
+	pos += i;
+
+	if (i + 4 + m.side + 12 <= n
+	    && (0 == memcmp(p + 4 + m.side, "Xing", 4)
+	        || 0 == memcmp(p + 4 + m.side, "Info", 4))) {
+		if (get_be32(p + 4 + m.side + 4) & 1) {
+			nframes = get_be32(p + 4 + m.side + 8);
+		}
+	} else if (i + 36 + 18 <= n && 0 == memcmp(p + 36, "VBRI", 4)) {
+		nframes = get_be32(p + 36 + 14);
+	}
+
+	probe->offset = pos;
+	probe->size = end - pos;
+	probe->rate = m.rate;
+	probe->channels = m.channels;
+	probe->bits = 16;
+	if (0 <= nframes) {
+		probe->frames = (double) nframes * m.samples * 75 / m.rate;
+	} else {
+		/* constant bitrate */
+		probe->frames = (double) probe->size * 8 * 75 / m.bitrate;
+	}
+
+	return 0;
+}
+
+static int probe_source(Source *src, int filetype, Probe *probe)
+{
+	unsigned char hdr[12];
+
+	if (12 == source_read(src, 0, hdr, 12)) {
+		if (0 == memcmp(hdr, "RIFF", 4) && 0 == memcmp(hdr + 8, "WAVE", 4)) {
+			return probe_wave(src, probe);
+		}
+		if (0 == memcmp(hdr, "FORM", 4) && (0 == memcmp(hdr + 8, "AIFF", 4)
+		    || 0 == memcmp(hdr + 8, "AIFC", 4))) {
+			return probe_aiff(src, probe);
+		}
+	}
+	if (FILE_MP3 == filetype) {
+		return probe_mp3(src, probe);
+	}
+
+	return probe_raw(src, filetype, probe);
+}
+
+int probe_file(const char *name, int filetype, Probe *probe)
+{
+	Source src;
+	int ret = -1;
+
+	src.data = NULL;
+	if (NULL == (src.fp = fopen(name, "rb"))) {
+		return -1;
+	}
+
+	if (0 == fseek(src.fp, 0, SEEK_END) && 0 <= (src.size = ftell(src.fp))) {
+		ret = probe_source(&src, filetype, probe);
+	}
+	fclose(src.fp);
+
+	return ret;
+}
+
+int probe_memory(const unsigned char *data, size_t size, int filetype,
+                 Probe *probe)
+{
+	Source src;
+
+	src.fp = NULL;
+	src.data = data;
+	src.size = size;
+
+	return probe_source(&src, filetype, probe);
+}
@@ -0,0 +1,41 @@
+/*
+ * probe.h -- audio file header probing
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#ifndef PROBE_H
+#define PROBE_H
+
+#include <stddef.h>
+
+#define PROBE_SIZE	4096	/* bytes searched for an MP3 frame header */
+
+/* what the headers of an audio file say */
+typedef struct Probe Probe;
+struct Probe {
+	int filetype;		/* FileType found */
+	long offset;		/* start of the sample data in the file */
+	long size;		/* bytes of sample data */
+	long frames;		/* playing time in CD frames (1/75 s) */
+	long rate;		/* samples per second */
+	int channels;
+	int bits;		/* bits per sample */
+	int big_endian;		/* samples are big-endian */
+};
+
+/*
+ * read the headers of an audio file, but none of its samples
+ * WAVE and AIFF headers are recognized whatever filetype (enum FileType)
+ * the sheet gives, and MP3 frame headers only for FILE_MP3.  A file with
+ * no header is raw CD-DA, big-endian only for FILE_MOTOROLA.
+ * returns -1 if the file can not be read, or an MP3 file has no frames
+ */
+int probe_file(const char *name, int filetype, Probe *probe);
+
+/* same, for a file already in memory */
+int probe_memory(const unsigned char *data, size_t size, int filetype,
+                 Probe *probe);
+
+#endif
@@ -0,0 +1,43 @@
+/*
+ * probes.h -- static (USDT) tracepoints
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+/*
+ * Probes are compiled in when <sys/sdt.h> is available (systemtap-sdt-dev)
+ * and cost a single nop when nothing is attached.  Provider "cuetools":
+ *
+ * parse__start(char *name)		cf_parse() entry
+ * parse__done(char *name, long bytes, int ok)	cf_parse() exit
+ * token(int token, int lineno)		token returned by a scanner
+ * track__add(void *cd, int trackno)	cd_add_track()
+ * parse__error(int lineno, char *msg)	yyerror() in either parser
+ * print__start(char *name, int format)	cf_print() entry
+ * print__done(char *name, long bytes)	cf_print() exit
+ *
+ * e.g. bpftrace -e 'usdt:./cueconvert:cuetools:parse__error
+ *                   { printf("%d: %s\n", arg0, str(arg1)); }'
+ */
+
+#ifndef PROBES_H
+#define PROBES_H
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif /* HAVE_CONFIG_H */
+
+#if HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+
+#define PROBE1(name, a)		DTRACE_PROBE1(cuetools, name, a)
+#define PROBE2(name, a, b)	DTRACE_PROBE2(cuetools, name, a, b)
+#define PROBE3(name, a, b, c)	DTRACE_PROBE3(cuetools, name, a, b, c)
+#else /* not HAVE_SYS_SDT_H */
+#define PROBE1(name, a)
+#define PROBE2(name, a, b)
+#define PROBE3(name, a, b, c)
+#endif /* HAVE_SYS_SDT_H */
+
+#endif
@@ -0,0 +1,863 @@
+/*
+ * search.c -- inverted index of the text of a library of sheets
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#include <ctype.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "search.h"
+
+/*
+ * an index file, with all numbers 32-bit little-endian:
+ *
+ *	magic, nsheet, ndoc, nterm, and the offsets of the tables below
+ *	sheets: nsheet offsets of names in the pool
+ *	docs: ndoc times sheet << 8 | trackno
+ *	terms: nterm times key offset in the pool, postings offset, count,
+ *	       sorted by key
+ *	pool: NUL-terminated names and keys
+ *	postings: varint document number differences
+ */
+#define SEARCH_MAGIC	"CUEIDX1"	/* with its NUL, 8 bytes */
+#define HEADER_SIZE	40
+#define TERM_SIZE	12
+#define MAXSHEET	0xffffff	/* sheets in an index */
+#define MAXKEY		256		/* bytes in a key */
+
+/* the fields of a document, with the code fields last */
+static const struct {
+	int pti;		/* or -1 for a code */
+	char *name;
+} fields[] = {
+	{PTI_TITLE, "title"},
+	{PTI_PERFORMER, "performer"},
+	{PTI_SONGWRITER, "songwriter"},
+	{PTI_COMPOSER, "composer"},
+	{PTI_ARRANGER, "arranger"},
+	{PTI_MESSAGE, "message"},
+	{PTI_GENRE, "genre"},
+	{-1, "isrc"},
+	{-1, "catalog"}
+};
+
+#define NFIELD	((int) (sizeof(fields) / sizeof(*fields)))
+
+/* a term being built, and its posting list */
+typedef struct Term Term;
+struct Term {
+	char *key;
+	unsigned char *post;
+	size_t len;
+	size_t size;
+	uint32_t last;		/* last document added */
+	uint32_t count;
+};
+
+struct SearchBuilder {
+	char **sheet;
+	uint32_t nsheet;
+	uint32_t sheetsize;
+	uint32_t *doc;
+	uint32_t ndoc;
+	uint32_t docsize;
+	Term *term;
+	uint32_t nterm;
+	uint32_t termsize;
+	uint32_t *slot;		/* term number + 1, or 0 if empty */
+	uint32_t nslot;		/* a power of two */
+};
+
+struct Search {
+	unsigned char *map;
+	size_t size;
+	uint32_t nsheet;
+	uint32_t ndoc;
+	uint32_t nterm;
+	const unsigned char *sheets;
+	const unsigned char *docs;
+	const unsigned char *terms;
+	const char *pool;
+	uint32_t poolsize;
+	const unsigned char *postings;
+	uint32_t postsize;
+};
+
+/* a set of documents, sorted */
+typedef struct Set Set;
+struct Set {
+	uint32_t *v;
+	long n;
+	long size;
+};
+
+static unsigned long get_le32(const unsigned char *p)
+{
+	return p[0] | p[1] << 8 | p[2] << 16 | (unsigned long) p[3] << 24;
+}
+
+static void put_le32(unsigned char *p, unsigned long n)
+{
+	p[0] = n & 0xff;
+	p[1] = (n >> 8) & 0xff;
+	p[2] = (n >> 16) & 0xff;
+	p[3] = (n >> 24) & 0xff;
+}
+
+/* make room for n + 1 elements of array *p, doubling it */
+static int grow(void **p, uint32_t *size, uint32_t n, size_t elem)
+{
+	void *q = NULL;
+	uint32_t newsize;
+
+	if (n < *size) {
+		return 0;
+	}
+	newsize = (0 == *size) ? 64 : 2 * *size;
+	if (NULL == (q = realloc(*p, (size_t) newsize * elem))) {
+		fprintf(stderr, "unable to allocate memory\n");
+		return -1;
+	}
+	*p = q;
+	*size = newsize;
+
+	return 0;
+}
+
+/*
+ * building
+ */
+
+SearchBuilder *search_builder_new(void)
+{
+	SearchBuilder *b = NULL;
+
+	if (NULL == (b = calloc(1, sizeof(SearchBuilder)))) {
+		fprintf(stderr, "unable to allocate memory\n");
+	}
+
+	return b;
+}
+
+void search_builder_delete(SearchBuilder *b)
+{
+	uint32_t i;
+
+	for (i = 0; i < b->nsheet; i++) {
+		free(b->sheet[i]);
+	}
+	for (i = 0; i < b->nterm; i++) {
+		free(b->term[i].key);
+		free(b->term[i].post);
+	}
+	free(b->sheet);
+	free(b->doc);
+	free(b->term);
+	free(b->slot);
+	free(b);
+}
+
+/* FNV-1a */
+static uint32_t search_hash(const char *key)
+{
+	uint32_t h = 2166136261U;
+
+	for (; '\0' != *key; key++) {
+		h = (h ^ (unsigned char) *key) * 16777619U;
+	}
+
+	return h;
+}
+
+static uint32_t *search_slot(SearchBuilder *b, const char *key)
+{
+	uint32_t i = search_hash(key) & (b->nslot - 1);
+
+	while (0 != b->slot[i] && 0 != strcmp(b->term[b->slot[i] - 1].key, key)) {
+		i = (i + 1) & (b->nslot - 1);
+	}
+
+	return &b->slot[i];
+}
+
+/* double the slots, keeping them at most half full */
+static int search_rehash(SearchBuilder *b)
+{
+	uint32_t i;
+
+	free(b->slot);
+	b->nslot = (0 == b->nslot) ? 1024 : 2 * b->nslot;
+	if (NULL == (b->slot = calloc(b->nslot, sizeof(uint32_t)))) {
+		fprintf(stderr, "unable to allocate memory\n");
+		b->nslot = 0;
+		return -1;
+	}
+	for (i = 0; i < b->nterm; i++) {
+		*search_slot(b, b->term[i].key) = i + 1;
+	}
+
+	return 0;
+}
+
+static int search_put_varint(Term *t, uint32_t n)
+{
+	unsigned char *post = NULL;
+
+	if (t->len + 5 > t->size) {
+		t->size = (0 == t->size) ? 8 : 2 * t->size;
+		if (NULL == (post = realloc(t->post, t->size))) {
+			fprintf(stderr, "unable to allocate memory\n");
+			return -1;
+		}
+		t->post = post;
+	}
+	for (; 0x80 <= n; n >>= 7) {
+		t->post[t->len++] = (n & 0x7f) | 0x80;
+	}
+	t->post[t->len++] = n;
+
+	return 0;
+}
+
+/* add document doc to the posting list of key */
+static int search_add_term(SearchBuilder *b, const char *key, uint32_t doc)
+{
+	uint32_t *slot = NULL;
+	Term *t = NULL;
+
+	if (2 * (b->nterm + 1) > b->nslot && 0 != search_rehash(b)) {
+		return -1;
+	}
+
+	slot = search_slot(b, key);
+	if (0 == *slot) {
+		if (0 != grow((void **) &b->term, &b->termsize, b->nterm,
+		              sizeof(Term))) {
+			return -1;
+		}
+		t = &b->term[b->nterm];
+		memset(t, 0, sizeof(Term));
+		if (NULL == (t->key = strdup(key))) {
+			fprintf(stderr, "unable to allocate memory\n");
+			return -1;
+		}
+		*slot = ++b->nterm;
+	}
+
+	t = &b->term[*slot - 1];
+	if (0 < t->count && t->last == doc) {
+		return 0;
+	}
+	if (0 != search_put_varint(t, (0 == t->count) ? doc : doc - t->last)) {
+		return -1;
+	}
+	t->last = doc;
+	t->count++;
+
+	return 0;
+}
+
+static int search_is_token(int c)
+{
+	return isalnum(c) || 0x80 <= c;
+}
+
+/*
+ * the key of field and the token at text into key, lowercased
+ * returns the length of the token, or 0 if text does not start with one
+ */
+static size_t search_key(char *key, const char *field, const char *text)
+{
+	size_t n = strlen(field);
+	size_t len;
+
+	memcpy(key, field, n);
+	key[n++] = ':';
+	for (len = 0; search_is_token((unsigned char) text[len]); len++) {
+		if (n + 1 < MAXKEY) {
+			key[n++] = tolower((unsigned char) text[len]);
+		}
+	}
+	key[n] = '\0';
+
+	return len;
+}
+
+/* letters and digits, lowercased */
+static void search_code_key(char *key, const char *field, const char *code)
+{
+	size_t n = strlen(field);
+
+	memcpy(key, field, n);
+	key[n++] = ':';
+	for (; '\0' != *code && n + 1 < MAXKEY; code++) {
+		if (isalnum((unsigned char) *code)) {
+			key[n++] = tolower((unsigned char) *code);
+		}
+	}
+	key[n] = '\0';
+}
+
+/* the words of each CD-TEXT field */
+static int search_add_text(SearchBuilder *b, Cdtext *cdtext, uint32_t doc)
+{
+	char key[MAXKEY];
+	const char *text = NULL;
+	size_t len;
+	int i;
+
+	for (i = 0; i < NFIELD && 0 <= fields[i].pti; i++) {
+		if (NULL == (text = cdtext_get(fields[i].pti, cdtext))) {
+			continue;
+		}
+		while ('\0' != *text) {
+			if (0 == (len = search_key(key, fields[i].name, text))) {
+				text++;
+			} else if (0 != search_add_term(b, key, doc)) {
+				return -1;
+			} else {
+				text += len;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int search_add_code(SearchBuilder *b, const char *field,
+                           const char *code, uint32_t doc)
+{
+	char key[MAXKEY];
+
+	if (NULL == code) {
+		return 0;
+	}
+	search_code_key(key, field, code);
+
+	return (strlen(field) + 1 == strlen(key)) ? 0
+	       : search_add_term(b, key, doc);
+}
+
+/* a new document of the last sheet */
+static int search_add_doc(SearchBuilder *b, int trackno, uint32_t *doc)
+{
+	if (0 != grow((void **) &b->doc, &b->docsize, b->ndoc,
+	              sizeof(uint32_t))) {
+		return -1;
+	}
+	*doc = b->ndoc;
+	b->doc[b->ndoc++] = (b->nsheet - 1) << 8 | trackno;
+
+	return 0;
+}
+
+int search_builder_add(SearchBuilder *b, const char *sheet, Cd *cd)
+{
+	Track *track = NULL;
+	uint32_t doc;
+	int i;
+
+	if (MAXSHEET <= b->nsheet) {
+		fprintf(stderr, "%s: too many sheets\n", sheet);
+		return -1;
+	}
+	if (0 != grow((void **) &b->sheet, &b->sheetsize, b->nsheet,
+	              sizeof(char *))) {
+		return -1;
+	}
+	if (NULL == (b->sheet[b->nsheet] = strdup(sheet))) {
+		fprintf(stderr, "unable to allocate memory\n");
+		return -1;
+	}
+	b->nsheet++;
+
+	if (0 != search_add_doc(b, 0, &doc)
+	    || 0 != search_add_text(b, cd_get_cdtext(cd), doc)
+	    || 0 != search_add_code(b, "catalog", cd_get_catalog(cd), doc)) {
+		return -1;
+	}
+
+	for (i = 1; i <= cd_get_ntrack(cd); i++) {
+		track = cd_get_track(cd, i);
+		if (0 != search_add_doc(b, i, &doc)
+		    || 0 != search_add_text(b, track_get_cdtext(track), doc)
+		    || 0 != search_add_code(b, "isrc", track_get_isrc(track),
+		                            doc)) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static int search_term_cmp(const void *a, const void *b)
+{
+	return strcmp((*(Term **) a)->key, (*(Term **) b)->key);
+}
+
+static int search_put(FILE *fp, unsigned long n)
+{
+	unsigned char buf[4];
+
+	put_le32(buf, n);
+
+	return (1 == fwrite(buf, 4, 1, fp)) ? 0 : -1;
+}
+
+int search_builder_write(SearchBuilder *b, const char *name)
+{
+	Term **sorted = NULL;
+	FILE *fp = NULL;
+	uint64_t pool = 0;
+	uint64_t post = 0;
+	uint64_t end;
+	unsigned long off;
+	unsigned long poff;
+	unsigned long tables[4];
+	int err = 0;
+	uint32_t i;
+
+	if (0 < b->nterm
+	    && NULL == (sorted = malloc(b->nterm * sizeof(Term *)))) {
+		fprintf(stderr, "unable to allocate memory\n");
+		return -1;
+	}
+	for (i = 0; i < b->nterm; i++) {
+		sorted[i] = &b->term[i];
+		pool += strlen(b->term[i].key) + 1;
+		post += b->term[i].len;
+	}
+	for (i = 0; i < b->nsheet; i++) {
+		pool += strlen(b->sheet[i]) + 1;
+	}
+	if (0 < b->nterm) {
+		qsort(sorted, b->nterm, sizeof(Term *), search_term_cmp);
+	}
+
+	/* sheets, docs, terms, pool; then the postings */
+	tables[0] = HEADER_SIZE;
+	tables[1] = tables[0] + 4UL * b->nsheet;
+	tables[2] = tables[1] + 4UL * b->ndoc;
+	tables[3] = tables[2] + (unsigned long) TERM_SIZE * b->nterm;
+	end = (uint64_t) tables[3] + pool + post;
+	if (0xffffffffUL < end) {
+		fprintf(stderr, "%s: index would be over 4 GiB\n", name);
+		free(sorted);
+		return -1;
+	}
+
+	if (NULL == (fp = fopen(name, "wb"))) {
+		fprintf(stderr, "%s: error opening file for writing\n", name);
+		free(sorted);
+		return -1;
+	}
+
+	err |= (1 != fwrite(SEARCH_MAGIC, 8, 1, fp));
+	err |= search_put(fp, b->nsheet);
+	err |= search_put(fp, b->ndoc);
+	err |= search_put(fp, b->nterm);
+	for (i = 0; i < 4; i++) {
+		err |= search_put(fp, tables[i]);
+	}
+	err |= search_put(fp, tables[3] + pool);	/* postings */
+
+	off = 0;
+	for (i = 0; i < b->nsheet; i++) {
+		err |= search_put(fp, off);
+		off += strlen(b->sheet[i]) + 1;
+	}
+	for (i = 0; i < b->ndoc; i++) {
+		err |= search_put(fp, b->doc[i]);
+	}
+	poff = 0;
+	for (i = 0; i < b->nterm; i++) {
+		err |= search_put(fp, off);
+		err |= search_put(fp, poff);
+		err |= search_put(fp, sorted[i]->count);
+		off += strlen(sorted[i]->key) + 1;
+		poff += sorted[i]->len;
+	}
+	for (i = 0; i < b->nsheet; i++) {
+		err |= (1 != fwrite(b->sheet[i], strlen(b->sheet[i]) + 1, 1, fp));
+	}
+	for (i = 0; i < b->nterm; i++) {
+		err |= (1 != fwrite(sorted[i]->key, strlen(sorted[i]->key) + 1, 1,
+		                    fp));
+	}
+	for (i = 0; i < b->nterm; i++) {
+		err |= (sorted[i]->len != fwrite(sorted[i]->post, 1,
+		                                 sorted[i]->len, fp));
+	}
+	free(sorted);
+
+	if (0 != fclose(fp) || 0 != err) {
+		fprintf(stderr, "%s: error writing file\n", name);
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * searching
+ */
+
+Search *search_open(const char *name)
+{
+	Search *s = NULL;
+	struct stat st;
+	const unsigned char *h = NULL;
+	unsigned long off[5];
+	int fd;
+	int i;
+
+	if (-1 == (fd = open(name, O_RDONLY))) {
+		fprintf(stderr, "%s: error opening file\n", name);
+		return NULL;
+	}
+	if (NULL == (s = calloc(1, sizeof(Search)))) {
+		fprintf(stderr, "unable to allocate memory\n");
+		close(fd);
+		return NULL;
+	}
+	if (0 != fstat(fd, &st) || HEADER_SIZE > st.st_size
+	    || 0xffffffffUL < (uint64_t) st.st_size) {
+		fprintf(stderr, "%s: not an index\n", name);
+		close(fd);
+		free(s);
+		return NULL;
+	}
+
+	s->size = st.st_size;
+	s->map = mmap(NULL, s->size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (MAP_FAILED == s->map) {
+		fprintf(stderr, "%s: error mapping file\n", name);
+		free(s);
+		return NULL;
+	}
+
+	/* the tables must be in order, and fit */
+	h = s->map;
+	s->nsheet = get_le32(h + 8);
+	s->ndoc = get_le32(h + 12);
+	s->nterm = get_le32(h + 16);
+	for (i = 0; i < 5; i++) {
+		off[i] = get_le32(h + 20 + 4 * i);
+	}
+	if (0 != memcmp(h, SEARCH_MAGIC, 8) || HEADER_SIZE != off[0]
+	    || off[0] + 4 * (uint64_t) s->nsheet != off[1]
+	    || off[1] + 4 * (uint64_t) s->ndoc != off[2]
+	    || off[2] + (uint64_t) TERM_SIZE * s->nterm != off[3]
+	    || off[3] > off[4] || off[4] > s->size
+	    || (off[3] < off[4] && '\0' != h[off[4] - 1])) {
+		fprintf(stderr, "%s: not an index\n", name);
+		search_close(s);
+		return NULL;
+	}
+
+	s->sheets = h + off[0];
+	s->docs = h + off[1];
+	s->terms = h + off[2];
+	s->pool = (const char *) h + off[3];
+	s->poolsize = off[4] - off[3];
+	s->postings = h + off[4];
+	s->postsize = s->size - off[4];
+
+	return s;
+}
+
+void search_close(Search *s)
+{
+	munmap(s->map, s->size);
+	free(s);
+}
+
+/* a string of the pool, or "" if off is out of it */
+static const char *search_string(Search *s, unsigned long off)
+{
+	return (off < s->poolsize) ? s->pool + off : "";
+}
+
+static const char *search_term_key(Search *s, uint32_t i)
+{
+	return search_string(s, get_le32(s->terms + TERM_SIZE * i));
+}
+
+int search_doc(Search *s, uint32_t n, SearchDoc *doc)
+{
+	unsigned long d;
+
+	if (n >= s->ndoc) {
+		return -1;
+	}
+	d = get_le32(s->docs + 4 * n);
+	if ((d >> 8) >= s->nsheet) {
+		return -1;
+	}
+	doc->sheet = search_string(s, get_le32(s->sheets + 4 * (d >> 8)));
+	doc->trackno = d & 0xff;
+
+	return 0;
+}
+
+/* the first term not less than key */
+static uint32_t search_lower_bound(Search *s, const char *key)
+{
+	uint32_t lo = 0;
+	uint32_t hi = s->nterm;
+	uint32_t mid;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (0 > strcmp(search_term_key(s, mid), key)) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+static int set_append(Set *set, uint32_t n)
+{
+	uint32_t *v = NULL;
+
+	if (set->n == set->size) {
+		set->size = (0 == set->size) ? 64 : 2 * set->size;
+		if (NULL == (v = realloc(set->v, set->size * sizeof(uint32_t)))) {
+			fprintf(stderr, "unable to allocate memory\n");
+			return -1;
+		}
+		set->v = v;
+	}
+	set->v[set->n++] = n;
+
+	return 0;
+}
+
+/* append the posting list of term i */
+static int search_postings(Search *s, uint32_t i, Set *set)
+{
+	const unsigned char *p = s->terms + TERM_SIZE * i;
+	unsigned long pos = get_le32(p + 4);
+	unsigned long count = get_le32(p + 8);
+	uint32_t doc = 0;
+	uint32_t n;
+	int shift;
+
+	for (; 0 < count; count--) {
+		n = 0;
+		shift = 0;
+		do {
+			if (pos >= s->postsize || 28 < shift) {
+				fprintf(stderr, "index is corrupt\n");
+				return -1;
+			}
+			n |= (uint32_t) (s->postings[pos] & 0x7f) << shift;
+			shift += 7;
+		} while (s->postings[pos++] & 0x80);
+
+		doc += n;
+		if (0 != set_append(set, doc)) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/* append the postings of key, or of every key it is a prefix of */
+static int search_lookup(Search *s, const char *key, int prefix, Set *set)
+{
+	size_t len = strlen(key);
+	uint32_t i = search_lower_bound(s, key);
+
+	for (; i < s->nterm; i++) {
+		if (prefix ? 0 != strncmp(search_term_key(s, i), key, len)
+		           : 0 != strcmp(search_term_key(s, i), key)) {
+			break;
+		}
+		if (0 != search_postings(s, i, set)) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static int set_cmp(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *) a;
+	uint32_t y = *(const uint32_t *) b;
+
+	return (x > y) - (x < y);
+}
+
+/* sort and drop duplicates, making a set of what was appended */
+static void set_normalize(Set *set)
+{
+	long i;
+	long n = 0;
+
+	qsort(set->v, set->n, sizeof(uint32_t), set_cmp);
+	for (i = 0; i < set->n; i++) {
+		if (0 == n || set->v[n - 1] != set->v[i]) {
+			set->v[n++] = set->v[i];
+		}
+	}
+	set->n = n;
+}
+
+/* keep the documents of a that are in b */
+static void set_intersect(Set *a, Set *b)
+{
+	long i;
+	long j = 0;
+	long n = 0;
+
+	for (i = 0; i < a->n; i++) {
+		while (j < b->n && b->v[j] < a->v[i]) {
+			j++;
+		}
+		if (j < b->n && b->v[j] == a->v[i]) {
+			a->v[n++] = a->v[i];
+		}
+	}
+	a->n = n;
+}
+
+/*
+ * append the documents matching word in field
+ * the words of text must all match; a code is matched whole
+ */
+static int search_word(Search *s, int field, const char *word, int prefix,
+                       Set *set)
+{
+	char key[MAXKEY];
+	Set tokens;
+	Set one;
+	size_t len;
+	int first = 1;
+	int ret = 0;
+
+	if (0 > fields[field].pti) {
+		search_code_key(key, fields[field].name, word);
+		return search_lookup(s, key, prefix, set);
+	}
+
+	memset(&tokens, 0, sizeof(Set));
+	memset(&one, 0, sizeof(Set));
+	for (; '\0' != *word && 0 == ret; word += len) {
+		if (0 == (len = search_key(key, fields[field].name, word))) {
+			len = 1;
+			continue;
+		}
+		one.n = 0;
+		ret = search_lookup(s, key, prefix && '\0' == word[len], &one);
+		set_normalize(&one);
+		if (first) {
+			tokens = one;
+			memset(&one, 0, sizeof(Set));
+			first = 0;
+		} else {
+			set_intersect(&tokens, &one);
+		}
+	}
+	for (len = 0; 0 == ret && (long) len < tokens.n; len++) {
+		ret = set_append(set, tokens.v[len]);
+	}
+	free(tokens.v);
+	free(one.v);
+
+	return ret;
+}
+
+/* append the documents matching a word of a query */
+static int search_query_word(Search *s, const char *word, Set *set)
+{
+	char text[MAXKEY];
+	const char *colon = strchr(word, ':');
+	size_t len = strlen(word);
+	int prefix = (0 < len && '*' == word[len - 1]);
+	int i;
+
+	if (len >= MAXKEY) {
+		len = MAXKEY - 1;
+	}
+	memcpy(text, word, len);
+	text[len - prefix] = '\0';
+
+	for (i = 0; i < NFIELD; i++) {
+		if (NULL != colon) {
+			if (strlen(fields[i].name) != (size_t) (colon - word)
+			    || 0 != strncasecmp(fields[i].name, word,
+			                        colon - word)) {
+				continue;
+			}
+			return search_word(s, i, text + (colon - word) + 1,
+			                   prefix, set);
+		}
+		if (0 != search_word(s, i, text, prefix, set)) {
+			return -1;
+		}
+	}
+	if (NULL != colon) {
+		fprintf(stderr, "unknown field in `%s'\n", word);
+		return -1;
+	}
+
+	return 0;
+}
+
+long search_query(Search *s, int nword, char **word, uint32_t **docs)
+{
+	Set result;
+	Set clause;
+	int first = 1;
+	int i = 0;
+
+	memset(&result, 0, sizeof(Set));
+	memset(&clause, 0, sizeof(Set));
+	*docs = NULL;
+
+	while (i < nword) {
+		/* a clause: words joined by OR */
+		clause.n = 0;
+		for (;;) {
+			if (0 != search_query_word(s, word[i++], &clause)) {
+				free(clause.v);
+				free(result.v);
+				return -1;
+			}
+			if (i + 1 >= nword || 0 != strcmp("OR", word[i])) {
+				break;
+			}
+			i++;
+		}
+		set_normalize(&clause);
+
+		if (first) {
+			result = clause;
+			memset(&clause, 0, sizeof(Set));
+			first = 0;
+		} else {
+			set_intersect(&result, &clause);
+		}
+	}
+	free(clause.v);
+
+	*docs = result.v;
+
+	return result.n;
+}
@@ -0,0 +1,61 @@
+/*
+ * search.h -- inverted index of the text of a library of sheets
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <stdint.h>
+#include "cd.h"
+
+/*
+ * the index maps terms to the discs and tracks (documents) they are in.
+ * a term is a field name, a colon and a token, as in "performer:beatles":
+ * the words of each CD-TEXT field, lowercased, and the whole of each ISRC
+ * and catalog number, with dashes and spaces dropped.  A disc's CD-TEXT is
+ * in document 0 of the disc, a track's in the document of the track.
+ *
+ * each posting list is the ascending document numbers, stored as the
+ * varint-encoded differences between them.  An index file is read in
+ * place with mmap().
+ */
+
+typedef struct SearchBuilder SearchBuilder;
+typedef struct Search Search;
+
+/* a document: a disc (trackno 0) or a track of a sheet */
+typedef struct SearchDoc SearchDoc;
+struct SearchDoc {
+	const char *sheet;
+	int trackno;
+};
+
+SearchBuilder *search_builder_new(void);
+void search_builder_delete(SearchBuilder *b);
+
+/* add the disc and tracks of a sheet; returns -1 if memory ran out */
+int search_builder_add(SearchBuilder *b, const char *sheet, Cd *cd);
+
+/* write the index; returns -1 on error */
+int search_builder_write(SearchBuilder *b, const char *name);
+
+/* map an index file; returns NULL if it cannot be read or is not one */
+Search *search_open(const char *name);
+void search_close(Search *s);
+
+/*
+ * find the documents matching a query of words, all of which must match
+ * a document.  Words joined by OR match if either does.  A word is a term,
+ * or a token that matches in any field; a trailing * matches any token
+ * with that prefix.  The documents are set to a new array (free it),
+ * sorted by document number.  Returns their number, or -1 on error.
+ */
+long search_query(Search *s, int nword, char **word, uint32_t **docs);
+
+/* the sheet and track of document n */
+int search_doc(Search *s, uint32_t n, SearchDoc *doc);
+
+#endif
@@ -0,0 +1,119 @@
+/*
+ * sha1.c -- SHA-1 message digest (FIPS 180-4)
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#include <string.h>
+#include "sha1.h"
+
+#define ROL(x, n)	(((x) << (n)) | ((x) >> (32 - (n))))
+
+static void sha1_block(Sha1 *ctx, const unsigned char *p)
+{
+	uint32_t w[80];
+	uint32_t a, b, c, d, e, f, k, t;
+	int i;
+
+	for (i = 0; i < 16; i++) {
+		w[i] = (uint32_t) p[4 * i] << 24 | (uint32_t) p[4 * i + 1] << 16
+		       | (uint32_t) p[4 * i + 2] << 8 | p[4 * i + 3];
+	}
+	for (; i < 80; i++) {
+		w[i] = ROL(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+	}
+
+	a = ctx->h[0];
+	b = ctx->h[1];
+	c = ctx->h[2];
+	d = ctx->h[3];
+	e = ctx->h[4];
+
+	for (i = 0; i < 80; i++) {
+		if (20 > i) {
+			f = (b & c) | (~b & d);
+			k = 0x5A827999;
+		} else if (40 > i) {
+			f = b ^ c ^ d;
+			k = 0x6ED9EBA1;
+		} else if (60 > i) {
+			f = (b & c) | (b & d) | (c & d);
+			k = 0x8F1BBCDC;
+		} else {
+			f = b ^ c ^ d;
+			k = 0xCA62C1D6;
+		}
+		t = ROL(a, 5) + f + e + k + w[i];
+		e = d;
+		d = c;
+		c = ROL(b, 30);
+		b = a;
+		a = t;
+	}
+
+	ctx->h[0] += a;
+	ctx->h[1] += b;
+	ctx->h[2] += c;
+	ctx->h[3] += d;
+	ctx->h[4] += e;
+}
+
+void sha1_init(Sha1 *ctx)
+{
+	ctx->h[0] = 0x67452301;
+	ctx->h[1] = 0xEFCDAB89;
+	ctx->h[2] = 0x98BADCFE;
+	ctx->h[3] = 0x10325476;
+	ctx->h[4] = 0xC3D2E1F0;
+	ctx->len = 0;
+}
+
+void sha1_update(Sha1 *ctx, const void *data, size_t len)
+{
+	const unsigned char *p = data;
+	size_t used = ctx->len % 64;
+	size_t n;
+
+	ctx->len += len;
+
+	if (0 != used) {
+		n = (64 - used < len) ? 64 - used : len;
+		memcpy(ctx->block + used, p, n);
+		p += n;
+		len -= n;
+		if (64 > used + n) {
+			return;
+		}
+		sha1_block(ctx, ctx->block);
+	}
+
+	for (; 64 <= len; p += 64, len -= 64) {
+		sha1_block(ctx, p);
+	}
+
+	memcpy(ctx->block, p, len);
+}
+
+void sha1_final(Sha1 *ctx, unsigned char *digest)
+{
+	uint64_t bits = ctx->len * 8;
+	size_t used = ctx->len % 64;
+	int i;
+
+	ctx->block[used++] = 0x80;
+	if (56 < used) {
+		memset(ctx->block + used, 0, 64 - used);
+		sha1_block(ctx, ctx->block);
+		used = 0;
+	}
+	memset(ctx->block + used, 0, 56 - used);
+	for (i = 0; i < 8; i++) {
+		ctx->block[56 + i] = bits >> (56 - 8 * i);
+	}
+	sha1_block(ctx, ctx->block);
+
+	for (i = 0; i < SHA1_SIZE; i++) {
+		digest[i] = ctx->h[i / 4] >> (24 - 8 * (i % 4));
+	}
+}
@@ -0,0 +1,27 @@
+/*
+ * sha1.h -- SHA-1 message digest (FIPS 180-4)
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#ifndef SHA1_H
+#define SHA1_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SHA1_SIZE	20	/* digest length in bytes */
+
+typedef struct Sha1 Sha1;
+struct Sha1 {
+	uint32_t h[5];
+	uint64_t len;			/* message length in bytes */
+	unsigned char block[64];	/* partial block */
+};
+
+void sha1_init(Sha1 *ctx);
+void sha1_update(Sha1 *ctx, const void *data, size_t len);
+void sha1_final(Sha1 *ctx, unsigned char *digest);
+
+#endif
@@ -0,0 +1,236 @@
+/*
+ * stats.c -- performance counters
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "stats.h"
+
+#define NSLOW	5	/* number of slowest files to remember */
+
+/*
+ * Wall time is read at every phase switch.  CPU time is a system call
+ * on most systems, so it is only read when entering or leaving
+ * PHASE_IO and at file boundaries; the CPU time in between is shared
+ * among the other phases in proportion to their wall time.
+ *
+ * The library may be called from several threads at once.  Each thread
+ * has its own current phase, only the thread that called stats_enable()
+ * is timed, and the counters are only kept once enabled, atomically.
+ */
+static __thread int stats_cur_phase;	/* current phase of this thread */
+static __thread int stats_timed;	/* this thread is timed */
+
+static struct {
+	int enabled;
+	double wall_last;		/* wall time at last phase switch */
+	double cpu_last;		/* cpu time at last settlement */
+	double wall_pending[PHASE_END];	/* wall time since last settlement */
+	double wall[PHASE_END];		/* wall time per phase (ns) */
+	double cpu[PHASE_END];		/* cpu time per phase (ns) */
+	unsigned long count[STATS_END];
+
+	char *file;			/* file being processed */
+	double file_start;		/* wall time at stats_file_begin() */
+	int nslow;			/* number of slowest files */
+	struct {
+		char *name;
+		double wall;
+	} slow[NSLOW];			/* slowest files, slowest first */
+} stats;
+
+static double clock_ns(clockid_t clock)
+{
+	struct timespec ts;
+
+	clock_gettime(clock, &ts);
+
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* share cpu time since the last settlement among the pending phases */
+static void stats_settle()
+{
+	double cpu = clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+	double total = 0;
+	int i;
+
+	for (i = 0; i < PHASE_END; i++) {
+		total += stats.wall_pending[i];
+	}
+
+	for (i = 0; i < PHASE_END; i++) {
+		if (0 < total) {
+			stats.cpu[i] += (cpu - stats.cpu_last)
+			              * stats.wall_pending[i] / total;
+		}
+		stats.wall_pending[i] = 0;
+	}
+
+	stats.cpu_last = cpu;
+}
+
+void stats_enable()
+{
+	stats.enabled = 1;
+	stats_timed = 1;
+	stats.wall_last = clock_ns(CLOCK_MONOTONIC);
+	stats.cpu_last = clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+}
+
+int stats_enabled()
+{
+	return stats.enabled;
+}
+
+int stats_phase(int phase)
+{
+	int prev = stats_cur_phase;
+	double wall;
+
+	if (stats_timed && phase != prev) {
+		wall = clock_ns(CLOCK_MONOTONIC);
+		stats.wall[prev] += wall - stats.wall_last;
+		stats.wall_pending[prev] += wall - stats.wall_last;
+		stats.wall_last = wall;
+
+		if (PHASE_IO == prev || PHASE_IO == phase) {
+			stats_settle();
+		}
+	}
+
+	stats_cur_phase = phase;
+
+	return prev;
+}
+
+void stats_count(int counter, unsigned long n)
+{
+	if (stats.enabled) {
+		__atomic_fetch_add(&stats.count[counter], n, __ATOMIC_RELAXED);
+	}
+}
+
+unsigned long stats_get(int counter)
+{
+	return __atomic_load_n(&stats.count[counter], __ATOMIC_RELAXED);
+}
+
+void stats_file_begin(char *name)
+{
+	stats_count(STATS_FILES, 1);
+
+	if (stats_timed) {
+		stats.file = name;
+		stats.file_start = clock_ns(CLOCK_MONOTONIC);
+	}
+}
+
+void stats_file_end()
+{
+	double wall;
+	int i;
+
+	if (!stats_timed || NULL == stats.file) {
+		return;
+	}
+
+	stats_phase(PHASE_IDLE);
+	stats_settle();
+	wall = clock_ns(CLOCK_MONOTONIC) - stats.file_start;
+
+	/* insert into the list of slowest files */
+	for (i = stats.nslow; 0 < i && stats.slow[i - 1].wall < wall; i--) {
+		if (NSLOW > i) {
+			stats.slow[i] = stats.slow[i - 1];
+		} else {
+			free(stats.slow[i - 1].name);
+		}
+	}
+
+	if (NSLOW > i) {
+		stats.slow[i].name = strdup(stats.file);
+		stats.slow[i].wall = wall;
+		if (NSLOW > stats.nslow) {
+			stats.nslow++;
+		}
+	}
+
+	stats.file = NULL;
+}
+
+void stats_print(FILE *fp)
+{
+	static const char *phase_name[] = {
+		"idle", "io", "lex", "parse", "build", "print"
+	};
+	double wall = 0;
+	double cpu = 0;
+	int i;
+
+	if (stats_timed) {
+		stats_phase(PHASE_IDLE);
+		stats_settle();
+	}
+
+	fprintf(fp, "files:          %lu\n", stats.count[STATS_FILES]);
+	fprintf(fp, "bytes read:     %lu\n", stats.count[STATS_BYTES_READ]);
+	fprintf(fp, "bytes written:  %lu\n", stats.count[STATS_BYTES_WRITTEN]);
+	fprintf(fp, "tokens lexed:   %lu\n", stats.count[STATS_TOKENS]);
+	fprintf(fp, "allocations:    %lu (%lu bytes)\n",
+	        stats.count[STATS_ALLOCS], stats.count[STATS_ALLOC_BYTES]);
+
+	if (!stats.enabled) {
+		return;
+	}
+
+	fprintf(fp, "\nphase     wall (ms)   cpu (ms)\n");
+	for (i = PHASE_IDLE + 1; i < PHASE_END; i++) {
+		fprintf(fp, "%-8s %10.3f %10.3f\n", phase_name[i],
+		        stats.wall[i] / 1e6, stats.cpu[i] / 1e6);
+		wall += stats.wall[i];
+		cpu += stats.cpu[i];
+	}
+	fprintf(fp, "%-8s %10.3f %10.3f\n", "total", wall / 1e6, cpu / 1e6);
+
+	if (0 < stats.nslow) {
+		fprintf(fp, "\nslowest files (ms)\n");
+		for (i = 0; i < stats.nslow; i++) {
+			fprintf(fp, "%10.3f  %s\n", stats.slow[i].wall / 1e6,
+			        stats.slow[i].name);
+		}
+	}
+}
+
+void *stats_malloc(size_t size)
+{
+	stats_count(STATS_ALLOCS, 1);
+	stats_count(STATS_ALLOC_BYTES, size);
+
+	return malloc(size);
+}
+
+void *stats_calloc(size_t nmemb, size_t size)
+{
+	stats_count(STATS_ALLOCS, 1);
+	stats_count(STATS_ALLOC_BYTES, nmemb * size);
+
+	return calloc(nmemb, size);
+}
+
+char *stats_strdup(const char *s)
+{
+	size_t size = strlen(s) + 1;
+	char *new_s = stats_malloc(size);
+
+	if (NULL != new_s) {
+		memcpy(new_s, s, size);
+	}
+
+	return new_s;
+}
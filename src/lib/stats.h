@@ -0,0 +1,71 @@
+/*
+ * stats.h -- performance counters
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * phases that time is charged to
+ * time spent in PHASE_IDLE is not reported
+ */
+enum StatsPhase {
+	PHASE_IDLE,		/* outside of the library */
+	PHASE_IO,		/* opening, reading and writing files */
+	PHASE_LEX,		/* scanning tokens */
+	PHASE_PARSE,		/* parsing (not counting the phases below) */
+	PHASE_BUILD,		/* adding tracks, indexes and strings to a Cd */
+	PHASE_PRINT,		/* formatting output */
+	PHASE_END		/* terminating phase (for stepping through phases) */
+};
+
+/* counters, kept once stats_enable() is called */
+enum StatsCounter {
+	STATS_FILES,		/* input files processed */
+	STATS_BYTES_READ,	/* bytes read from input files */
+	STATS_BYTES_WRITTEN,	/* bytes of output */
+	STATS_TOKENS,		/* tokens returned by the scanners */
+	STATS_ALLOCS,		/* number of allocations */
+	STATS_ALLOC_BYTES,	/* bytes allocated */
+	STATS_END		/* terminating counter */
+};
+
+/*
+ * turn on the counters, and timing of the calling thread; call it
+ * before starting other threads
+ */
+void stats_enable();
+int stats_enabled();
+
+/*
+ * make phase the current phase of the calling thread and return the
+ * previous one; restore it with stats_phase(previous) when done
+ */
+int stats_phase(int phase);
+
+/* add n to counter; any thread may count */
+void stats_count(int counter, unsigned long n);
+unsigned long stats_get(int counter);
+
+/*
+ * bracket the processing of one input file
+ * the slowest files are remembered for stats_print()
+ */
+void stats_file_begin(char *name);
+void stats_file_end();
+
+/* print counters, time per phase and the slowest files */
+void stats_print(FILE *fp);
+
+/* allocation functions which update the allocation counters */
+void *stats_malloc(size_t size);
+void *stats_calloc(size_t nmemb, size_t size);
+char *stats_strdup(const char *s);
+
+#endif
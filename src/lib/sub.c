@@ -0,0 +1,293 @@
+/*
+ * sub.c -- P and Q sub-channel data of a disc image
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#include <ctype.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cd.h"
+#include "crc.h"
+#include "stats.h"
+#include "sub.h"
+
+#define SUB_LEAD_IN	150	/* frames before disc frame 0 (00:02:00) */
+#define SUB_BATCH	1024	/* sectors per fwrite() */
+
+#define ADR_POSITION	0x01
+#define ADR_MCN		0x02
+#define ADR_ISRC	0x03
+
+/*
+ * bit_spread[b] holds the bits of b, most significant first, one per
+ * byte in bit 0; interleaving shifts it to the bit of the channel
+ */
+static uint64_t bit_spread[256];
+static pthread_once_t bit_spread_once = PTHREAD_ONCE_INIT;
+
+static void bit_spread_init()
+{
+	unsigned char bytes[8];
+	int i;
+	int k;
+
+	for (i = 0; i < 256; i++) {
+		for (k = 0; k < 8; k++) {
+			bytes[k] = (i >> (7 - k)) & 1;
+		}
+		memcpy(&bit_spread[i], bytes, sizeof(bytes));
+	}
+}
+
+static unsigned char sub_bcd(int n)
+{
+	n %= 100;
+
+	return (n / 10) << 4 | n % 10;
+}
+
+static void sub_msf(unsigned char *p, long frame)
+{
+	p[0] = sub_bcd(frame / (60 * 75));
+	p[1] = sub_bcd(frame / 75 % 60);
+	p[2] = sub_bcd(frame % 75);
+}
+
+/* the ones' complement of the CRC-16 of bytes 0 to 9, high byte first */
+static void sub_crc(unsigned char *q)
+{
+	uint16_t crc = ~crc16_update(0, q, 10);
+
+	q[10] = crc >> 8;
+	q[11] = crc & 0xFF;
+}
+
+/* an ISRC character as a 6-bit code: 0 to 9 for digits, 17 on for letters */
+static int sub_isrc_code(int c)
+{
+	return isdigit(c) ? c - '0' : c - 'A' + 0x11;
+}
+
+/* ADR 2: thirteen BCD digits */
+static int sub_mcn(unsigned char *q, const char *catalog)
+{
+	int i;
+
+	memset(q, 0, SUB_Q_SIZE);
+	for (i = 0; i < 13; i++) {
+		if (!isdigit((unsigned char) catalog[i])) {
+			return -1;
+		}
+		q[1 + i / 2] |= (catalog[i] - '0') << ((0 == i % 2) ? 4 : 0);
+	}
+
+	return ('\0' == catalog[13]) ? 0 : -1;
+}
+
+/* ADR 3: five 6-bit codes, then seven BCD digits */
+static int sub_isrc(unsigned char *q, const char *isrc)
+{
+	uint32_t codes = 0;
+	int i;
+
+	memset(q, 0, SUB_Q_SIZE);
+	if (12 != strlen(isrc)) {
+		return -1;
+	}
+	for (i = 0; i < 12; i++) {
+		if (5 > i && !isupper((unsigned char) isrc[i])
+		    && !isdigit((unsigned char) isrc[i])) {
+			return -1;
+		}
+		if (5 <= i && !isdigit((unsigned char) isrc[i])) {
+			return -1;
+		}
+	}
+
+	for (i = 0; i < 5; i++) {
+		codes |= (uint32_t) sub_isrc_code(isrc[i]) << (26 - 6 * i);
+	}
+	q[1] = codes >> 24;
+	q[2] = codes >> 16;
+	q[3] = codes >> 8;
+	q[4] = codes;
+	for (i = 5; i < 12; i++) {
+		q[5 + (i - 5) / 2] |= (isrc[i] - '0') << ((1 == i % 2) ? 4 : 0);
+	}
+
+	return 0;
+}
+
+int sub_init(SubGen *gen, Cd *cd)
+{
+	Track *track = NULL;
+	CdExtent *e = NULL;
+	CdPoint *p = NULL;
+	char *code = NULL;
+	int i;
+
+	memset(gen, 0, sizeof(SubGen));
+	if (0 == cd_get_npoint(cd)) {
+		return -1;
+	}
+
+	e = cd_get_extent(cd, cd_get_nextent(cd) - 1);
+	gen->length = (NULL == e) ? 0 : e->frame + e->length;
+
+	for (i = 1; i <= cd_get_ntrack(cd); i++) {
+		track = cd_get_track(cd, i);
+		gen->control[i] = track_is_set_flag(track, FLAG_PRE_EMPHASIS
+		                                    | FLAG_COPY_PERMITTED
+		                                    | FLAG_DATA
+		                                    | FLAG_FOUR_CHANNEL);
+		if (MODE_AUDIO != track_get_mode(track)) {
+			gen->control[i] |= FLAG_DATA;
+		}
+		gen->start[i] = -1;
+
+		code = track_get_isrc(track);
+		if (NULL != code && 0 == sub_isrc(gen->isrc[i], code)) {
+			gen->isrc[i][0] = gen->control[i] << 4 | ADR_ISRC;
+			gen->has_isrc[i] = 1;
+		}
+	}
+
+	/* index 1 is the first point of a track past index 0 */
+	for (i = 0; i < cd_get_npoint(cd); i++) {
+		p = cd_get_point(cd, i);
+		if (0 < i && p->frame < cd_get_point(cd, i - 1)->frame) {
+			return -1;
+		}
+		if (0 < p->index && 0 > gen->start[p->trackno]) {
+			gen->start[p->trackno] = p->frame;
+		}
+	}
+
+	/* a layout that stopped at a track of unknown length has no more */
+	for (i = 1; i <= cd_get_ntrack(cd); i++) {
+		if (0 > gen->start[i]) {
+			return -1;
+		}
+	}
+
+	code = cd_get_catalog(cd);
+	if (NULL != code && 0 == sub_mcn(gen->mcn, code)) {
+		gen->has_mcn = 1;
+	}
+
+	cd_iter_init(&gen->it, cd, 0);
+
+	return 0;
+}
+
+/*
+ * the Q frame of the current sector
+ * ADR 1 frames but for one in each 100 for the MCN and ISRC, which are
+ * kept out of pregaps and off the first frame of a track or index
+ */
+static void sub_q(SubGen *gen, unsigned char *q)
+{
+	CdIter *it = &gen->it;
+	long frame = it->frame;
+	long abs = frame + SUB_LEAD_IN;
+	int trackno = (0 < it->trackno) ? it->trackno : 1;
+	int edge = cd_get_point(it->cd, it->point)->frame == frame;
+	long rel;
+
+	if (!edge && gen->has_mcn && SUB_MCN_FRAME == abs % 100) {
+		memcpy(q, gen->mcn, SUB_Q_SIZE);
+		q[0] = gen->control[trackno] << 4 | ADR_MCN;
+		q[9] = sub_bcd(abs % 75);
+	} else if (!edge && gen->has_isrc[trackno] && 0 < it->index
+	           && SUB_ISRC_FRAME == abs % 100) {
+		memcpy(q, gen->isrc[trackno], SUB_Q_SIZE);
+		q[9] = sub_bcd(abs % 75);
+	} else {
+		/* the pause counts down to 00:00:00 at its last frame */
+		rel = (0 == it->index) ? gen->start[trackno] - frame - 1
+		      : frame - gen->start[trackno];
+		q[0] = gen->control[trackno] << 4 | ADR_POSITION;
+		q[1] = sub_bcd(trackno);
+		q[2] = sub_bcd(it->index);
+		sub_msf(q + 3, (0 <= rel) ? rel : 0);
+		q[6] = 0;
+		sub_msf(q + 7, abs);
+	}
+
+	sub_crc(q);
+}
+
+/* P and Q of a sector as twelve bytes each into the bits of 96 bytes */
+static void sub_interleave(unsigned char *out, const unsigned char *p,
+                           const unsigned char *q)
+{
+	uint64_t bits;
+	int i;
+
+	for (i = 0; i < SUB_Q_SIZE; i++) {
+		bits = bit_spread[p[i]] << 7 | bit_spread[q[i]] << 6;
+		memcpy(out + 8 * i, &bits, sizeof(bits));
+	}
+}
+
+long sub_generate(SubGen *gen, unsigned char *buf, long n, int format)
+{
+	unsigned char p[SUB_Q_SIZE];
+	unsigned char q[SUB_Q_SIZE];
+	unsigned char *out = buf;
+	long i;
+
+	pthread_once(&bit_spread_once, bit_spread_init);
+
+	if (n > gen->length - gen->it.frame) {
+		n = gen->length - gen->it.frame;
+	}
+
+	for (i = 0; i < n; i++, out += SUB_SIZE) {
+		/* P is set through each pause */
+		memset(p, (0 == gen->it.index) ? 0xFF : 0x00, sizeof(p));
+		sub_q(gen, q);
+
+		if (SUB_INTERLEAVED == format) {
+			sub_interleave(out, p, q);
+		} else {
+			memcpy(out, p, SUB_Q_SIZE);
+			memcpy(out + SUB_Q_SIZE, q, SUB_Q_SIZE);
+			memset(out + 2 * SUB_Q_SIZE, 0,
+			       SUB_SIZE - 2 * SUB_Q_SIZE);
+		}
+		cd_iter_advance(&gen->it, 1);
+	}
+
+	return n;
+}
+
+int sub_write(Cd *cd, FILE *fp, int format)
+{
+	SubGen gen;
+	unsigned char *buf = NULL;
+	long n;
+	int ret = 0;
+
+	if (0 != sub_init(&gen, cd)) {
+		return -1;
+	}
+	if (NULL == (buf = stats_malloc(SUB_BATCH * SUB_SIZE))) {
+		fprintf(stderr, "unable to allocate memory\n");
+		return -1;
+	}
+
+	while (0 == ret && 0 < (n = sub_generate(&gen, buf, SUB_BATCH,
+	                                         format))) {
+		if ((size_t) n != fwrite(buf, SUB_SIZE, n, fp)) {
+			ret = -1;
+		}
+	}
+	free(buf);
+
+	return ret;
+}
@@ -0,0 +1,61 @@
+/*
+ * sub.h -- P and Q sub-channel data of a disc image
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+/* references: MMC-3 draft revision 10g, 4.2.3 and 5.29.2.13 */
+
+#ifndef SUB_H
+#define SUB_H
+
+#include <stdio.h>
+#include "cd.h"
+
+#define SUB_SIZE	96	/* bytes of sub-channel data of a sector */
+#define SUB_Q_SIZE	12	/* bytes of a Q sub-channel frame, with its CRC */
+#define SUB_MCN_FRAME	25	/* frame of each 100 given to the MCN */
+#define SUB_ISRC_FRAME	75	/* frame of each 100 given to the ISRC */
+
+/* how the eight channels, P to W, of a sector are stored */
+enum SubFormat {
+	SUB_PACKED,		/* 12 bytes of each channel in turn (.sub) */
+	SUB_INTERLEAVED		/* a bit of each channel per byte, P first */
+};
+
+/*
+ * a pass over the sub-channel of a disc, from the pregap of track 1 (at
+ * absolute time 00:02:00) to the lead-out
+ */
+typedef struct SubGen SubGen;
+struct SubGen {
+	CdIter it;
+	long length;			/* frames of the disc */
+	int control[MAXTRACK + 1];	/* CONTROL field of each track */
+	long start[MAXTRACK + 1];	/* disc frame of index 1 */
+	unsigned char mcn[SUB_Q_SIZE];	/* ADR 2 frame, but for AFRAME */
+	int has_mcn;
+	unsigned char isrc[MAXTRACK + 1][SUB_Q_SIZE];	/* ADR 3 frames */
+	int has_isrc[MAXTRACK + 1];
+};
+
+/*
+ * start a pass over cd, which must be laid out (see cd_layout())
+ * a catalog number that is not 13 digits, or an ISRC that is not 12
+ * letters and digits, is left out.  returns -1 if cd is not laid out in
+ * full, or if its points are not in order
+ */
+int sub_init(SubGen *gen, Cd *cd);
+
+/*
+ * the sub-channel of the next n sectors, SUB_SIZE bytes each, into buf
+ * in format (enum SubFormat); R to W are zero
+ * returns the number of sectors, less than n at the end of the disc
+ */
+long sub_generate(SubGen *gen, unsigned char *buf, long n, int format);
+
+/* write the sub-channel of all of cd to fp; returns -1 on error */
+int sub_write(Cd *cd, FILE *fp, int format);
+
+#endif
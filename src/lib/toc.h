@@ -5,5 +5,16 @@
  * For license terms, see the file COPYING in this distribution.
  */
 
-Cd *toc_parse(FILE *fp);
+typedef struct TocParser TocParser;
+
+/*
+ * incremental parser
+ * push input that ends at a line boundary, then finish to get the Cd
+ * toc_parser_push() returns non-zero once the parse has failed
+ */
+TocParser *toc_parser_new();
+int toc_parser_push(TocParser *p, char *bytes, size_t len);
+Cd *toc_parser_finish(TocParser *p);
+void toc_parser_delete(TocParser *p);
+
 void toc_print(FILE *fp, Cd *cd);
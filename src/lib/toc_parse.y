@@ -10,21 +10,42 @@
 #include <stdio.h>
 #include <string.h>
 #include "cd.h"
-#include "time.h"
+#include "cdtime.h"
+#include "toc.h"
+#include "stats.h"
+#include "probes.h"
 #include "toc_parse_prefix.h"
 
 #define YYDEBUG 1
-
-extern int yylex();
-void yyerror (char *s);
-
-static Cd *cd = NULL;
-static Track *track = NULL;
-static Cdtext *cdtext = NULL;
+#define MAXBYTES 3072		/* of binary CD-TEXT data, as in 256 packs */
+
+/* parser state, one per input (see toc_parser_new()) */
+struct TocParser {
+	void *scanner;			/* reentrant scanner */
+	struct yypstate *ps;		/* push parser */
+	int status;			/* YYPUSH_MORE while parsing */
+	int lineno;			/* line being scanned */
+	Cd *cd;
+	Track *track;
+	Cdtext *cdtext;
+	char bytes[MAXBYTES + 1];	/* binary CD-TEXT data */
+	int nbytes;
+};
+
+void yyerror (TocParser *p, char *s);
+static int toc_add_byte(TocParser *p, long byte);
 %}
 
 %start tocfile
 
+%define api.pure full
+%define api.push-pull push
+%parse-param {struct TocParser *p}
+
+%code requires {
+struct TocParser;
+}
+
 %union {
 	long ival;
 	char *sval;
@@ -33,6 +54,8 @@ static Cdtext *cdtext = NULL;
 %token <ival> NUMBER
 %token <sval> STRING
 
+%destructor { free($$); } <sval>
+
 /* global (header) */
 %token CATALOG
 
@@ -105,8 +128,8 @@ tocfile
 
 new_cd
 	: /* empty */ {
-		cd = cd_init();
-		cdtext = cd_get_cdtext(cd);
+		p->cd = cd_init();
+		p->cdtext = cd_get_cdtext(p->cd);
 	}
 	;
 
@@ -116,8 +139,8 @@ global_statements
 	;
 
 global_statement
-	: CATALOG STRING '\n' { cd_set_catalog(cd, $2); }
-	| disc_mode '\n' { cd_set_mode(cd, $1); }
+	: CATALOG STRING '\n' { cd_set_catalog(p->cd, $2); free($2); }
+	| disc_mode '\n' { cd_set_mode(p->cd, $1); }
 	| CD_TEXT '{' opt_nl language_map cdtext_langs '}' '\n'
 	| error '\n'
 	;
@@ -135,28 +158,30 @@ track_list
 
 track
 	: new_track track_def track_statements {
-		while (2 > track_get_nindex(track)) {
-			track_add_index(track, 0);
+		while (2 > track_get_nindex(p->track)) {
+			track_add_index(p->track, 0);
 		}
 	}
 	;
 
 new_track
 	: /* empty */ {
-		track = cd_add_track(cd);
-		cdtext = track_get_cdtext(track);
+		if (NULL == (p->track = cd_add_track(p->cd))) {
+			YYABORT;
+		}
+		p->cdtext = track_get_cdtext(p->track);
 		/* add 0 index */
-		track_add_index(track, 0);
+		track_add_index(p->track, 0);
 	}
 	;
 
 track_def
-	: TRACK track_modes '\n' { track_set_mode(track, $2); }
+	: TRACK track_modes '\n' { track_set_mode(p->track, $2); }
 	;
 
 track_modes
 	: track_mode
-	| track_mode track_sub_mode { track_set_sub_mode(track, $2); }
+	| track_mode track_sub_mode { track_set_sub_mode(p->track, $2); }
 	;
 
 track_mode
@@ -182,7 +207,7 @@ track_statements
 
 track_statement
 	: track_flags
-	| ISRC STRING '\n' { track_set_isrc(track, $2); }
+	| ISRC STRING '\n' { track_set_isrc(p->track, $2); free($2); }
 	| CD_TEXT '{' opt_nl cdtext_langs '}' '\n'
 	| track_data
 	| track_pregap
@@ -191,8 +216,8 @@ track_statement
 	;
 
 track_flags
-	: track_set_flag { track_set_flag(track, $1); }
-	| track_clear_flag { track_clear_flag(track, $1); }
+	: track_set_flag { track_set_flag(p->track, $1); }
+	| track_clear_flag { track_clear_flag(p->track, $1); }
 	;
 
 track_set_flag
@@ -209,31 +234,38 @@ track_clear_flag
 
 track_data
 	: zero_data time '\n' {
-		if (NULL == track_get_filename(track)) {
-			track_set_zero_pre(track, $2);
+		if (NULL == track_get_filename(p->track)) {
+			track_set_zero_pre(p->track, $2);
 		} else {
-			track_set_zero_post(track, $2);
+			track_set_zero_post(p->track, $2);
 		}
 	}
 	| AUDIOFILE STRING time '\n' {
-		track_set_filename(track, $2);
-		track_set_start(track, $3);
+		track_set_filename(p->track, $2);
+		track_set_start(p->track, $3);
+		free($2);
 	}
 	| AUDIOFILE STRING time time '\n' {
-		track_set_filename(track, $2);
-		track_set_start(track, $3);
-		track_set_length(track, $4);
+		track_set_filename(p->track, $2);
+		track_set_start(p->track, $3);
+		track_set_length(p->track, $4);
+		free($2);
 	}
 	| DATAFILE STRING '\n' {
-		track_set_filename(track, $2);
+		track_set_filename(p->track, $2);
+		track_set_filetype(p->track, FILE_BINARY);
+		free($2);
 	}
 	| DATAFILE STRING time '\n' {
-		track_set_filename(track, $2);
-		track_set_start(track, $3);
+		track_set_filename(p->track, $2);
+		track_set_filetype(p->track, FILE_BINARY);
+		track_set_start(p->track, $3);
+		free($2);
 	}
 	| FIFO STRING time '\n' {
-		track_set_filename(track, $2);
-		track_set_start(track, $3);
+		track_set_filename(p->track, $2);
+		track_set_start(p->track, $3);
+		free($2);
 	}
 	;
 
@@ -245,16 +277,22 @@ zero_data
 track_pregap
 	: START '\n'
 	| START time '\n' {
-		track_add_index(track, $2);
+		track_add_index(p->track, $2);
 	}
 	| PREGAP time '\n' {
-		track_set_zero_pre(track, $2);
-		track_add_index(track, $2);
+		track_set_zero_pre(p->track, $2);
+		track_add_index(p->track, $2);
 	}
 	;
 
 track_index
-	: INDEX time '\n' { track_add_index(track, $2); }
+	: INDEX time '\n' {
+		/* with no START, index 01 is at the start of the track */
+		if (2 > track_get_nindex(p->track)) {
+			track_add_index(p->track, 0);
+		}
+		track_add_index(p->track, $2);
+	}
 	;
 
 language_map
@@ -286,10 +324,20 @@ cdtext_defs
 
 cdtext_def
 	: cdtext_item STRING '\n' {
-		cdtext_set ($1, $2, cdtext);
+		cdtext_set ($1, $2, p->cdtext);
+		free($2);
 	}
-	| cdtext_item '{' bytes '}' '\n' {
-		yyerror("binary CD-TEXT data not supported\n");
+	| cdtext_item '{' opt_bytes '}' '\n' {
+		/* text as bytes; the binary PTIs are made anew when written */
+		p->bytes[p->nbytes] = '\0';
+		if (PTI_GENRE == $1 && 2 < p->nbytes) {
+			/* after the genre code */
+			cdtext_set($1, p->bytes + 2, p->cdtext);
+		} else if (PTI_GENRE != $1 && PTI_TOC_INFO1 != $1
+		           && PTI_TOC_INFO2 != $1 && PTI_SIZE_INFO != $1
+		           && 0 < p->nbytes && '\0' != p->bytes[0]) {
+			cdtext_set($1, p->bytes, p->cdtext);
+		}
 	}
 	;
 
@@ -309,9 +357,23 @@ cdtext_item
 	| SIZE_INFO
 	;
 
+opt_bytes
+	: /* empty */ { p->nbytes = 0; }
+	| bytes
+	;
+
 bytes
-	: /* empty */
-	| bytes ',' NUMBER
+	: NUMBER {
+		p->nbytes = 0;
+		if (0 != toc_add_byte(p, $1)) {
+			YYABORT;
+		}
+	}
+	| bytes ',' NUMBER {
+		if (0 != toc_add_byte(p, $3)) {
+			YYABORT;
+		}
+	}
 	;
 
 time
@@ -326,24 +388,93 @@ opt_nl
 
 %%
 
-/* lexer interface */
-extern int toc_lineno;
-extern int yydebug;
-extern FILE *toc_yyin;
+/* scanner interface */
+extern void *toc_scan_new(int *lineno);
+extern void toc_scan_delete(void *scanner);
+extern int toc_scan_push(void *scanner, char *bytes, size_t len,
+                         yypstate *ps, TocParser *p);
 
-void yyerror (char *s)
+void yyerror (TocParser *p, char *s)
 {
-	fprintf(stderr, "%d: %s\n", toc_lineno, s);
+	PROBE2(parse__error, p->lineno, s);
+	fprintf(stderr, "%d: %s\n", p->lineno, s);
+}
+
+/* returns -1 if byte is out of range, which fails the parse */
+static int toc_add_byte(TocParser *p, long byte)
+{
+	if (0 > byte || 255 < byte) {
+		yyerror(p, "CD-TEXT byte out of range");
+		return -1;
+	}
+	if (MAXBYTES > p->nbytes) {
+		p->bytes[p->nbytes++] = byte;
+	}
+
+	return 0;
 }
 
-Cd *toc_parse (FILE *fp)
+TocParser *toc_parser_new()
 {
-	toc_yyin = fp;
-	yydebug = 0;
+	TocParser *p = NULL;
+
+	if (NULL == (p = calloc(1, sizeof(TocParser)))) {
+		fprintf(stderr, "unable to create parser\n");
+		return NULL;
+	}
+
+	p->status = YYPUSH_MORE;
+	p->lineno = 1;
+	p->ps = yypstate_new();
+	p->scanner = toc_scan_new(&p->lineno);
+
+	if (NULL == p->ps || NULL == p->scanner) {
+		fprintf(stderr, "unable to create parser\n");
+		toc_parser_delete(p);
+		return NULL;
+	}
+
+	return p;
+}
+
+void toc_parser_delete(TocParser *p)
+{
+	if (NULL != p) {
+		if (NULL != p->scanner) {
+			toc_scan_delete(p->scanner);
+		}
+		if (NULL != p->ps) {
+			yypstate_delete(p->ps);
+		}
+		cd_delete(p->cd);
+		free(p);
+	}
+}
+
+int toc_parser_push(TocParser *p, char *bytes, size_t len)
+{
+	if (YYPUSH_MORE == p->status) {
+		p->status = toc_scan_push(p->scanner, bytes, len, p->ps, p);
+	}
+
+	return (YYPUSH_MORE == p->status) ? 0 : -1;
+}
+
+Cd *toc_parser_finish(TocParser *p)
+{
+	YYSTYPE lval;
+	Cd *cd = NULL;
+
+	if (YYPUSH_MORE == p->status) {
+		/* end of input */
+		lval.sval = NULL;
+		p->status = yypush_parse(p->ps, 0, &lval, p);
+	}
 
-	if (0 == yyparse()) {
-		return cd;
+	if (0 == p->status) {
+		cd = p->cd;
+		p->cd = NULL;
 	}
 
-	return NULL;
+	return cd;
 }
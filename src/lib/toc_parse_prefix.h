@@ -11,10 +11,12 @@
 
 #define yymaxdepth	toc_yymaxdepth
 #define yyparse		toc_yyparse
+#define yypush_parse	toc_yypush_parse
+#define yypstate	toc_yypstate
+#define yypstate_new	toc_yypstate_new
+#define yypstate_delete	toc_yypstate_delete
 #define yylex		toc_yylex
 #define yyerror		toc_yyerror
-#define yylval		toc_yylval
-#define yychar		toc_ychar
 #define yydebug		toc_yydebug
 #define yypact		toc_yypact
 #define yyr1		toc_yyr1
@@ -25,12 +27,10 @@
 #define yyact		toc_yyact
 #define yyexca		toc_yyexca
 #define yyerrflag	toc_yyerrflag
-#define yynerrs		toc_yynerrs
 #define yyps		toc_yyps
 #define yypv		toc_yypv
 #define yys		toc_yys
 #define yy_yys		toc_yy_yys
-#define yystate		toc_yystate
 #define yytmp		toc_yytmp
 #define yyv		toc_yyv
 #define yy_yyv		toc_yy_yyv
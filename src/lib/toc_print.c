@@ -8,9 +8,10 @@
 #include <stdio.h>
 #include <string.h>
 #include "cd.h"
-#include "time.h"
+#include "cdtime.h"
 
-void toc_print_track (FILE *fp, Track *track);
+void toc_print_track (FILE *fp, Track *track, Track *prev, Track *next);
+void toc_print_file (FILE *fp, char *name, long start, long length);
 void toc_print_cdtext (Cdtext *cdtext, FILE *fp, int istrack);
 
 void toc_print (FILE *fp, Cd *cd)
@@ -47,15 +48,23 @@ void toc_print (FILE *fp, Cd *cd)
 	for (i = 1; i <= cd_get_ntrack(cd); i++) {
 		track = cd_get_track(cd, i);
 		fprintf(fp, "\n");
-		toc_print_track(fp, track);
+		toc_print_track(fp, track, cd_get_track(cd, i - 1),
+		                cd_get_track(cd, i + 1));
 	}
 }
 
-void toc_print_track (FILE *fp, Track *track)
+void toc_print_track (FILE *fp, Track *track, Track *prev, Track *next)
 {
 	Cdtext *cdtext = track_get_cdtext(track);
+	long length = track_get_length(track);
+	long pregap;	/* frames of pregap in the track's own file */
 	int i;	/* index */
 
+	/* a track ends where a pregap of the next one in its file starts */
+	if (NULL != next && 0 <= track_get_pregap_start(next)) {
+		length = track_get_pregap_start(next) - track_get_start(track);
+	}
+
 	fprintf(fp, "TRACK ");
 	switch (track_get_mode(track)) {
 	case MODE_AUDIO:
@@ -104,23 +113,33 @@ void toc_print_track (FILE *fp, Track *track)
 		fprintf(fp, "}\n");
 	}
 
+	/* a pregap at the end of the file of the track before */
+	if (NULL != prev && 0 <= track_get_pregap_start(track)) {
+		toc_print_file(fp, track_get_filename(prev),
+		               track_get_pregap_start(track), 0);
+	}
+
 	if (0 != track_get_zero_pre(track)) {
 		fprintf(fp, "ZERO ");
 		fprintf(fp, "%s", time_frame_to_mmssff(track_get_zero_pre(track)));
 		fprintf(fp, "\n");
 	}
 
-	fprintf(fp, "FILE ");
-	fprintf(fp, "\"%s\" ", track_get_filename(track));
-	if (0 == track_get_start(track)) {
-		fprintf(fp, "0");
+	if (0 > track_get_pregap_start(track)) {
+		toc_print_file(fp, track_get_filename(track),
+		               track_get_start(track), length);
 	} else {
-		fprintf(fp, "%s", time_frame_to_mmssff(track_get_start(track)));
-	}
-	if (0 != track_get_length(track)) {
-		fprintf(fp, " %s", time_frame_to_mmssff(track_get_length(track)));
+		/* the pregap before is of unknown length, so START is bare */
+		pregap = track_get_index(track, 1) - track_get_zero_pre(track);
+		if (0 < pregap) {
+			toc_print_file(fp, track_get_filename(track),
+			               track_get_start(track), pregap);
+		}
+		fprintf(fp, "START\n");
+		toc_print_file(fp, track_get_filename(track),
+		               track_get_start(track) + pregap,
+		               (0 != length) ? length - pregap : 0);
 	}
-	fprintf(fp, "\n");
 
 	if (0 != track_get_zero_post(track)) {
 		fprintf(fp, "ZERO ");
@@ -128,7 +147,8 @@ void toc_print_track (FILE *fp, Track *track)
 		fprintf(fp, "\n");
 	}
 
-	if (track_get_index(track, 1) != 0) {
+	if (0 > track_get_pregap_start(track)
+	    && track_get_index(track, 1) != 0) {
 		fprintf(fp, "START ");
 		fprintf(fp, "%s\n", time_frame_to_mmssff(track_get_index(track, 1)));
 	}
@@ -141,6 +161,22 @@ void toc_print_track (FILE *fp, Track *track)
 	}
 }
 
+/* a FILE line; a length of 0 runs to the end of the file */
+void toc_print_file (FILE *fp, char *name, long start, long length)
+{
+	fprintf(fp, "FILE ");
+	fprintf(fp, "\"%s\" ", name);
+	if (0 == start) {
+		fprintf(fp, "0");
+	} else {
+		fprintf(fp, "%s", time_frame_to_mmssff(start));
+	}
+	if (0 != length) {
+		fprintf(fp, " %s", time_frame_to_mmssff(length));
+	}
+	fprintf(fp, "\n");
+}
+
 void toc_print_cdtext (Cdtext *cdtext, FILE *fp, int istrack)
 {
 	int pti;
@@ -10,7 +10,11 @@
 #include <stdlib.h>	/* exit() */
 #include <string.h>	/* strcasecmp() */
 #include "cuefile.h"
-#include "time.h"
+#include "stats.h"
+#include "cdtime.h"
+
+#define SAMPLES_PER_FRAME	588
+#define BYTES_PER_FRAME		2352	/* of generated silence */
 
 #if HAVE_CONFIG_H
 #include "config.h"
@@ -41,6 +45,9 @@ void usage(int status)
 		       "--append-gaps			append pregaps to previous track (default)\n"
 		       "--prepend-gaps			prefix pregaps to track\n"
 		       "--split-gaps			split at beginning and end of pregaps\n"
+		       "--plan				print the pieces of the data files that\n"
+		       "				make up each output track\n"
+		       "--stats				print timing and allocation statistics\n"
 		       "-V, --version			print version information\n");
 	} else {
 		fprintf(stderr, "Try `%s --help' for more information.\n", progname);
@@ -60,9 +67,11 @@ void version()
 void print_m_ss_ff(long frame)
 {
 	int m, s, f;
+	int n;
 
 	time_frame_to_msf(frame, &m, &s, &f);
-	printf ("%d:%02d.%02d\n", m, s, f);
+	n = printf ("%d:%02d.%02d\n", m, s, f);
+	stats_count(STATS_BYTES_WRITTEN, n);
 }
 
 void print_breakpoint(long b)
@@ -107,17 +116,185 @@ void print_breaks(Cd *cd, int gaps)
 	}
 }
 
-int breaks(char *name, int format, int gaps)
+/*
+ * disc frames where the output tracks start, in order, for the gap mode,
+ * from the points of the layout, so that a pregap in the file of the
+ * track before is where it is on the disc
+ * returns the number of them
+ */
+int plan_starts(Cd *cd, int gaps, long *starts)
+{
+	CdPoint *p = NULL;
+	int trackno = 0;	/* of the last point */
+	int index1 = 0;		/* last track whose index 01 was seen */
+	int n = 0;
+	int i;
+
+	starts[n++] = 0;
+	for (i = 0; i < cd_get_npoint(cd); i++) {
+		p = cd_get_point(cd, i);
+
+		/* an output of nothing, such as an empty pregap, is dropped */
+		if (p->trackno != trackno) {
+			trackno = p->trackno;
+			if ((gaps == PREPEND || gaps == SPLIT)
+			    && starts[n - 1] < p->frame) {
+				starts[n++] = p->frame;
+			}
+		}
+		/* the first pregap has no previous track to append to */
+		if (0 < p->index && index1 != p->trackno) {
+			index1 = p->trackno;
+			if (((gaps == APPEND && 1 < trackno) || gaps == SPLIT)
+			    && starts[n - 1] < p->frame) {
+				starts[n++] = p->frame;
+			}
+		}
+	}
+
+	return n;
+}
+
+/* a piece of a data file, or of generated silence, in an output track */
+typedef struct Piece Piece;
+struct Piece {
+	int output;
+	int trackno;
+	char *filename;		/* NULL for silence */
+	long sample;
+	long offset;
+	long frames;
+	long block;
+};
+
+/*
+ * print a piece as: output, track, start sample, samples, start byte, bytes,
+ * file ("-" for silence)
+ */
+void print_piece(Piece *piece, char *name)
+{
+	char path[4096];
+	int n;
+
+	if (NULL == piece->filename) {
+		n = printf("%d\t%d\t0\t%ld\t0\t%ld\t-\n", piece->output,
+		           piece->trackno, piece->frames * SAMPLES_PER_FRAME,
+		           piece->frames * BYTES_PER_FRAME);
+	} else {
+		cf_data_path(path, sizeof(path), name, piece->filename);
+		n = printf("%d\t%d\t%ld\t%ld\t%ld\t%ld\t%s\n", piece->output,
+		           piece->trackno, piece->sample,
+		           piece->frames * SAMPLES_PER_FRAME, piece->offset,
+		           piece->frames * piece->block, path);
+	}
+	stats_count(STATS_BYTES_WRITTEN, n);
+}
+
+/*
+ * print the pieces that make up each output track, cutting the layout where
+ * outputs start and joining pieces that follow on in one file
+ */
+void print_plan(Cd *cd, char *name, int gaps)
+{
+	CdExtent *e = NULL;
+	Piece piece;
+	long starts[2 * MAXTRACK + 1];
+	long frame;
+	long end;
+	long length;
+	long offset;
+	int nstart;
+	int trackno = 0;	/* of the current output */
+	int index;
+	int out = 0;		/* number of outputs started */
+	int i;
+
+	nstart = plan_starts(cd, gaps, starts);
+	piece.frames = 0;
+
+	for (i = 0; i < cd_get_nextent(cd); i++) {
+		e = cd_get_extent(cd, i);
+		end = e->frame + e->length;
+
+		for (frame = e->frame; frame < end; frame += length) {
+			if (out < nstart && starts[out] == frame) {
+				out++;
+				cd_locate(cd, frame, &trackno, &index);
+			}
+			length = end - frame;
+			if (out < nstart && starts[out] - frame < length) {
+				length = starts[out] - frame;
+			}
+			offset = (NULL == e->filename) ? 0
+			         : e->offset + (frame - e->frame) * e->block;
+
+			/* the same output, and on from the end of the last piece */
+			if (0 < piece.frames && out == piece.output
+			    && ((NULL == e->filename && NULL == piece.filename)
+			        || (NULL != e->filename && NULL != piece.filename
+			            && 0 == strcmp(e->filename, piece.filename)
+			            && e->block == piece.block
+			            && piece.offset + piece.frames * piece.block
+			               == offset))) {
+				piece.frames += length;
+				continue;
+			}
+
+			if (0 < piece.frames) {
+				print_piece(&piece, name);
+			}
+			piece.output = out;
+			piece.trackno = trackno;
+			piece.filename = e->filename;
+			piece.offset = offset;
+			piece.frames = length;
+			piece.block = e->block;
+			piece.sample = 0;
+			if (NULL != e->filename) {
+				piece.sample = (offset - track_get_data_offset(
+				                cd_get_track(cd, e->trackno)))
+				               / e->block * SAMPLES_PER_FRAME;
+			}
+		}
+	}
+	if (0 < piece.frames) {
+		print_piece(&piece, name);
+	}
+}
+
+int breaks(char *name, int format, int gaps, int plan)
 {
 	Cd *cd = NULL;
+	int phase;
+
+	stats_file_begin(name);
 
 	if (NULL == (cd = cf_parse(name, &format))) {
 		fprintf(stderr, "%s: error: unable to parse input file"
 		        " `%s'\n", progname, name);
+		stats_file_end();
 		return -1;
 	}
 
-	print_breaks(cd, gaps);
+	/* a plan needs the length of the last track in each file */
+	if (plan && 0 != cf_set_lengths(cd, name)) {
+		fprintf(stderr, "%s: error: unable to find the track lengths"
+		        " of `%s'\n", progname, name);
+		cd_delete(cd);
+		stats_file_end();
+		return -1;
+	}
+
+	phase = stats_phase(PHASE_PRINT);
+	if (plan) {
+		print_plan(cd, name, gaps);
+	} else {
+		print_breaks(cd, gaps);
+	}
+	stats_phase(phase);
+
+	cd_delete(cd);
+	stats_file_end();
 
 	return 0;
 }
@@ -126,6 +303,7 @@ int main(int argc, char *argv[])
 {
 	int format = UNKNOWN;
 	int gaps = APPEND;
+	int plan = 0;
 	int ret = 0;		/* return value of breaks() */
 
 	/* option variables */
@@ -140,6 +318,8 @@ int main(int argc, char *argv[])
 		{"append-gaps", no_argument, NULL, 'a'},
 		{"prepend-gaps", no_argument, NULL, 'p'},
 		{"split-gaps", no_argument, NULL, 's'},
+		{"plan", no_argument, NULL, 'P'},
+		{"stats", no_argument, NULL, 'S'},
 		{"version", no_argument, NULL, 'V'},
 		{NULL, 0, NULL, 0}
 	};
@@ -152,11 +332,7 @@ int main(int argc, char *argv[])
 			usage(0);
 			break;
 		case 'i':
-			if (0 == strcmp("cue", optarg)) {
-				format = CUE;
-			} else if (0 == strcmp("toc", optarg)) {
-				format = TOC;
-			} else {
+			if (UNKNOWN == (format = cf_format_from_name(optarg))) {
 				fprintf(stderr, "%s: error: unknown input file"
 				        " format `%s'\n", progname, optarg);
 				usage(1);
@@ -171,6 +347,12 @@ int main(int argc, char *argv[])
 		case 's':
 			gaps = SPLIT;
 			break;
+		case 'P':
+			plan = 1;
+			break;
+		case 'S':
+			stats_enable();
+			break;
 		case 'V':
 			version();
 			break;
@@ -183,17 +365,21 @@ int main(int argc, char *argv[])
 	/* What we do depends on the number of operands. */
 	if (optind == argc) {
 		/* No operands: report breakpoints of stdin. */
-		ret = breaks("-", format, gaps);
+		ret = breaks("-", format, gaps, plan);
 	} else {
 		/* Report track breakpoints for each operand. */
 		for (; optind < argc; optind++) {
-			ret = breaks(argv[optind], format, gaps);
+			ret = breaks(argv[optind], format, gaps, plan);
 			/* Exit if breaks() returns nonzero. */
-			if (!ret) {
+			if (0 != ret) {
 				break;
 			}
 		}
 	}
 
+	if (stats_enabled()) {
+		stats_print(stderr);
+	}
+
 	return ret;
 }
@@ -0,0 +1,374 @@
+/*
+ * cuecdtext.c -- write the CD-TEXT of cue or toc files as binary packs,
+ * and read it back
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#include <getopt.h>	/* getopt_long() */
+#include <stdio.h>	/* fprintf(), printf(), stderr */
+#include <stdlib.h>	/* exit(), strtol(), free() */
+#include <string.h>	/* memset(), strcmp(), strrchr() */
+#include "cuefile.h"
+#include "cdt.h"
+#include "stats.h"
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#else /* not HAVE_CONFIG_H */
+#define PACKAGE_STRING "cuecdtext"
+#endif /* HAVE_CONFIG_H */
+
+#define LANGUAGE_ENGLISH	0x09
+
+char *progname;
+
+/* Print usage information and exit */
+void usage(int status)
+{
+	if (0 == status) {
+		printf("Usage: %s [option...] file...\n", progname);
+		printf("Write the CD-TEXT of each CUE or TOC file to a binary CD-TEXT file (.cdt)\n"
+		       "beside it, or of all of them to one file as its language blocks, or print\n"
+		       "the CD-TEXT of binary CD-TEXT files.\n"
+		       "\n"
+		       "OPTIONS\n"
+		       "-h, --help			print usage\n"
+		       "-i, --input-format cue|toc	set format of file(s)\n"
+		       "-o, --output file		write all files to file, one language block\n"
+		       "				each\n"
+		       "-l, --language code[,code...]	language code of each block (default 9,\n"
+		       "				English)\n"
+		       "-c, --charset latin1|ascii|ms-jis\n"
+		       "				character code of the text (default latin1)\n"
+		       "-T, --files-from list		read the names of files from list, one per\n"
+		       "				line (- for standard input)\n"
+		       "-d, --decode			print the CD-TEXT of binary CD-TEXT files\n"
+		       "--stats				print timing and allocation statistics\n"
+		       "-V, --version			print version information\n");
+	} else {
+		fprintf(stderr, "Try `%s --help' for more information.\n", progname);
+	}
+
+	exit (status);
+}
+
+/* Print version information and exit */
+void version()
+{
+	printf("%s\n", PACKAGE_STRING);
+
+	exit(0);
+}
+
+/* name with its suffix, if any, replaced by .cdt */
+void cdt_name(char *out, size_t size, char *name)
+{
+	char *dot = strrchr(name, '.');
+	char *slash = strrchr(name, '/');
+
+	if (NULL == dot || (NULL != slash && dot < slash)) {
+		snprintf(out, size, "%s.cdt", name);
+	} else {
+		snprintf(out, size, "%.*s.cdt", (int) (dot - name), name);
+	}
+}
+
+/* the language block of a sheet; returns -1 on error */
+int read_block(CdtBlock *block, char *name, int format, int language,
+               int charset)
+{
+	Cd *cd = NULL;
+	int ret;
+
+	if (NULL == (cd = cf_parse(name, &format))) {
+		fprintf(stderr, "%s: error: unable to parse input file"
+		        " `%s'\n", progname, name);
+		return -1;
+	}
+	ret = cdt_from_cd(block, cd, language, charset);
+	cd_delete(cd);
+
+	return ret;
+}
+
+/* print the CD-TEXT of a block, as UTF-8 */
+int print_block(char *name, CdtBlock *block, int b)
+{
+	Cd *cd = NULL;
+	Cdtext *cdtext = NULL;
+	char *value = NULL;
+	int pti;
+	int i;
+
+	if (NULL == (cd = cd_init())) {
+		return -1;
+	}
+	for (i = block->first; i <= block->last; i++) {
+		if (NULL == cd_add_track(cd)) {
+			cd_delete(cd);
+			return -1;
+		}
+	}
+	if (0 != cdt_to_cd(block, cd)) {
+		cd_delete(cd);
+		return -1;
+	}
+
+	printf("%s\tblock %d\tlanguage %d\tcharset %d\ttracks %d-%d\n", name, b,
+	       block->language, block->charset, block->first, block->last);
+	for (i = 0; i <= cd_get_ntrack(cd); i++) {
+		cdtext = (0 == i) ? cd_get_cdtext(cd)
+		         : track_get_cdtext(cd_get_track(cd, i));
+		for (pti = 0; PTI_END != pti; pti++) {
+			if (NULL != (value = cdtext_get(pti, cdtext))) {
+				printf("%s\t%d\t%d\t%s\t%s\n", name, b,
+				       (0 == i) ? 0 : block->first + i - 1,
+				       cdtext_get_key(pti, i), value);
+			}
+		}
+	}
+	cd_delete(cd);
+
+	return 0;
+}
+
+/* print each block of a binary CD-TEXT file; returns -1 on error */
+int decode(char *name)
+{
+	CdtBlock block[CDT_MAXBLOCK];
+	unsigned char *packs = NULL;
+	long size;
+	int nblock;
+	int ret = 0;
+	int b;
+
+	if (0 > (size = cdt_read_packs(name, &packs))) {
+		return -1;
+	}
+	if (0 > (nblock = cdt_decode(packs, size, block))) {
+		fprintf(stderr, "%s: error: bad CD-TEXT in `%s'\n", progname,
+		        name);
+		free(packs);
+		return -1;
+	}
+	for (b = 0; b < nblock && 0 == ret; b++) {
+		ret = print_block(name, &block[b], b);
+	}
+	cdt_free(block, nblock);
+	free(packs);
+
+	return ret;
+}
+
+/* write one file of a block per sheet */
+int encode_all(char *out, char **name, int nname, int format, int *language,
+               int nlanguage, int charset)
+{
+	CdtBlock block[CDT_MAXBLOCK];
+	int ret = 0;
+	int i;
+
+	memset(block, 0, sizeof(block));
+	if (CDT_MAXBLOCK < nname) {
+		fprintf(stderr, "%s: error: at most %d language blocks\n",
+		        progname, CDT_MAXBLOCK);
+		return -1;
+	}
+
+	for (i = 0; i < nname && 0 == ret; i++) {
+		ret = read_block(&block[i], name[i], format,
+		                 (i < nlanguage) ? language[i] : LANGUAGE_ENGLISH,
+		                 charset);
+	}
+	if (0 == ret) {
+		ret = cdt_write(out, block, nname);
+	}
+	cdt_free(block, i);
+
+	return ret;
+}
+
+/* write a file for a sheet */
+int encode(char *name, int format, int language, int charset)
+{
+	CdtBlock block;
+	char out[4096];
+	int ret;
+
+	if (0 != read_block(&block, name, format, language, charset)) {
+		return -1;
+	}
+	cdt_name(out, sizeof(out), name);
+	ret = cdt_write(out, &block, 1);
+	cdt_free(&block, 1);
+
+	return ret;
+}
+
+/* what to do with the files of a list */
+typedef struct Listed Listed;
+struct Listed {
+	int decoding;
+	int format;
+	int language;
+	int charset;
+};
+
+/* encode or decode a file named in a list; a bad one does not stop it */
+int each_listed(void *arg, char *name)
+{
+	Listed *l = arg;
+
+	if (l->decoding) {
+		return (0 == decode(name)) ? 0 : 1;
+	}
+
+	return (0 == encode(name, l->format, l->language, l->charset)) ? 0 : 1;
+}
+
+/* a comma separated list of language codes */
+int parse_languages(char *s, int *language)
+{
+	char *end = NULL;
+	int n = 0;
+
+	for (;;) {
+		if (CDT_MAXBLOCK == n) {
+			return -1;
+		}
+		language[n] = strtol(s, &end, 0);
+		if (end == s || 0 > language[n] || 255 < language[n]) {
+			return -1;
+		}
+		n++;
+		if ('\0' == *end) {
+			return n;
+		}
+		if (',' != *end) {
+			return -1;
+		}
+		s = end + 1;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	Listed listed;
+	int language[CDT_MAXBLOCK] = {LANGUAGE_ENGLISH};
+	int nlanguage = 1;
+	int charset = CDT_ISO8859_1;
+	int format = UNKNOWN;
+	int decoding = 0;
+	char *output = NULL;
+	char *list = NULL;
+	int ret = 0;
+
+	/* option variables */
+	int c;
+	/* getopt_long() variables */
+	extern char *optarg;
+	extern int optind;
+
+	static struct option longopts[] = {
+		{"help", no_argument, NULL, 'h'},
+		{"input-format", required_argument, NULL, 'i'},
+		{"output", required_argument, NULL, 'o'},
+		{"language", required_argument, NULL, 'l'},
+		{"charset", required_argument, NULL, 'c'},
+		{"files-from", required_argument, NULL, 'T'},
+		{"decode", no_argument, NULL, 'd'},
+		{"stats", no_argument, NULL, 'S'},
+		{"version", no_argument, NULL, 'V'},
+		{NULL, 0, NULL, 0}
+	};
+
+	progname = argv[0];
+
+	while (-1 != (c = getopt_long(argc, argv, "hi:o:l:c:T:dV", longopts,
+	                              NULL))) {
+		switch (c) {
+		case 'h':
+			usage(0);
+			break;
+		case 'i':
+			if (UNKNOWN == (format = cf_format_from_name(optarg))) {
+				fprintf(stderr, "%s: error: unknown input file"
+				        " format `%s'\n", progname, optarg);
+				usage(1);
+			}
+			break;
+		case 'o':
+			output = optarg;
+			break;
+		case 'l':
+			if (0 > (nlanguage = parse_languages(optarg, language))) {
+				fprintf(stderr, "%s: error: bad language codes"
+				        " `%s'\n", progname, optarg);
+				usage(1);
+			}
+			break;
+		case 'c':
+			if (0 == strcmp("latin1", optarg)) {
+				charset = CDT_ISO8859_1;
+			} else if (0 == strcmp("ascii", optarg)) {
+				charset = CDT_ASCII;
+			} else if (0 == strcmp("ms-jis", optarg)) {
+				charset = CDT_MS_JIS;
+			} else {
+				fprintf(stderr, "%s: error: unknown character"
+				        " code `%s'\n", progname, optarg);
+				usage(1);
+			}
+			break;
+		case 'T':
+			list = optarg;
+			break;
+		case 'd':
+			decoding = 1;
+			break;
+		case 'S':
+			stats_enable();
+			break;
+		case 'V':
+			version();
+			break;
+		default:
+			usage(1);
+			break;
+		}
+	}
+
+	if ((NULL == list && optind == argc)
+	    || (NULL != output && (decoding || NULL != list))) {
+		usage(1);
+	}
+
+	if (NULL != output) {
+		ret = encode_all(output, argv + optind, argc - optind, format,
+		                 language, nlanguage, charset);
+	} else {
+		listed.decoding = decoding;
+		listed.format = format;
+		listed.language = language[0];
+		listed.charset = charset;
+		if (NULL != list
+		    && 0 != cf_read_list(list, each_listed, &listed)) {
+			ret = -1;
+		}
+		for (; optind < argc; optind++) {
+			if (0 != (decoding ? decode(argv[optind])
+			          : encode(argv[optind], format, language[0],
+			                   charset))) {
+				ret = -1;
+			}
+		}
+	}
+
+	if (stats_enabled()) {
+		stats_print(stderr);
+	}
+
+	return (0 == ret) ? 0 : 1;
+}
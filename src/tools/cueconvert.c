@@ -10,6 +10,7 @@
 #include <stdlib.h>	/* exit() */
 #include <string.h>	/* strcasecmp() */
 #include "cuefile.h"
+#include "stats.h"
 
 #if HAVE_CONFIG_H
 #include "config.h"
@@ -24,12 +25,15 @@ void usage(int status)
 {
 	if (0 == status) {
 		printf("Usage: %s [option...] [infile [outfile]]\n", progname);
-		printf("Convert file between the CUE and TOC formats.\n"
+		printf("Convert file between the CUE and TOC formats, and the cue sheets\n"
+		       "embedded in FLAC files and APEv2 tags.\n"
 		       "\n"
 		       "OPTIONS\n"
 		       "-h, --help			print usage\n"
-		       "-i, --input-format cue|toc	set format of input file\n"
-		       "-o, --output-format cue|toc	set format of output file\n"
+		       "-i, --input-format cue|toc|flac|ape\n"
+		       "				set format of input file\n"
+		       "-o, --output-format cue|toc|flac	set format of output file\n"
+		       "--stats				print timing and allocation statistics\n"
 		       "-V, --version			print version information\n");
 	} else {
 		fprintf(stderr, "Try `%s --help' for more information.\n", progname);
@@ -49,10 +53,14 @@ void version()
 int convert(char *iname, int iformat, char *oname, int oformat)
 {
 	Cd *cd = NULL;
+	int ret;
+
+	stats_file_begin(iname);
 
 	if (NULL == (cd = cf_parse(iname, &iformat))) {
 		fprintf(stderr, "%s: error: unable to parse input file"
 		        " `%s'\n", progname, iname);
+		stats_file_end();
 		return -1;
 	}
 
@@ -64,14 +72,19 @@ int convert(char *iname, int iformat, char *oname, int oformat)
 			case CUE:
 					oformat = TOC;
 					break;
-			case TOC:
+			default:
 					oformat = CUE;
 					break;
 			}
 		}
 	}
 
-	return cf_print(oname, &oformat, cd);
+	ret = cf_print(oname, &oformat, cd);
+
+	cd_delete(cd);
+	stats_file_end();
+
+	return ret;
 }
 
 int main(int argc, char *argv[])
@@ -90,6 +103,7 @@ int main(int argc, char *argv[])
 		{"help", no_argument, NULL, 'h'},
 		{"input-format", required_argument, NULL, 'i'},
 		{"output-format", required_argument, NULL, 'o'},
+		{"stats", no_argument, NULL, 'S'},
 		{"version", no_argument, NULL, 'V'},
 		{NULL, 0, NULL, 0}
 	};
@@ -102,27 +116,22 @@ int main(int argc, char *argv[])
 			usage(0);
 			break;
 		case 'i':
-			if (0 == strcmp("cue", optarg)) {
-				iformat = CUE;
-			} else if (0 == strcmp("toc", optarg)) {
-				iformat = TOC;
-			} else {
+			if (UNKNOWN == (iformat = cf_format_from_name(optarg))) {
 				fprintf(stderr, "%s: error: unknown input file"
 				        " format `%s'\n", progname, optarg);
 				usage(1);
 			}
 			break;
 		case 'o':
-			if (0 == strcmp("cue", optarg)) {
-				oformat = CUE;
-			} else if (0 == strcmp("toc", optarg)) {
-				oformat = TOC;
-			} else {
+			if (UNKNOWN == (oformat = cf_format_from_name(optarg))) {
 				fprintf(stderr, "%s: error: unknown output file"
 				        " format `%s'\n", progname, optarg);
 				usage(1);
 			}
 			break;
+		case 'S':
+			stats_enable();
+			break;
 		case 'V':
 			version();
 			break;
@@ -146,5 +155,9 @@ int main(int argc, char *argv[])
 		usage(1);
 	}
 
+	if (stats_enabled()) {
+		stats_print(stderr);
+	}
+
 	return ret;
 }
@@ -0,0 +1,230 @@
+/*
+ * cuediff.c -- compare two cue or toc files track by track
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#include <getopt.h>	/* getopt_long() */
+#include <stdio.h>	/* fprintf(), printf(), stderr */
+#include <stdlib.h>	/* exit() */
+#include "cuefile.h"
+#include "stats.h"
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#else /* not HAVE_CONFIG_H */
+#define PACKAGE_STRING "cuediff"
+#endif /* HAVE_CONFIG_H */
+
+/* changes that call for a track's file to be tagged again */
+#define DIFF_TAGS	(DIFF_ADDED | DIFF_FILE | DIFF_ISRC | DIFF_CDTEXT)
+
+char *progname;
+
+/* Print usage information and exit */
+void usage(int status)
+{
+	if (0 == status) {
+		printf("Usage: %s [option...] old new\n", progname);
+		printf("Compare two CUE or TOC files field by field, track by track.\n"
+		       "\n"
+		       "OPTIONS\n"
+		       "-h, --help			print usage\n"
+		       "-i, --input-format cue|toc	set format of both files\n"
+		       "-t, --tracks			print only the numbers of the tracks\n"
+		       "				whose tags changed\n"
+		       "-q, --quiet			print nothing, only set the exit status\n"
+		       "--stats				print timing and allocation statistics\n"
+		       "-V, --version			print version information\n");
+	} else {
+		fprintf(stderr, "Try `%s --help' for more information.\n", progname);
+	}
+
+	exit (status);
+}
+
+/* Print version information and exit */
+void version()
+{
+	printf("%s\n", PACKAGE_STRING);
+
+	exit(0);
+}
+
+Cd *parse(char *name, int format)
+{
+	Cd *cd = NULL;
+
+	stats_file_begin(name);
+	if (NULL == (cd = cf_parse(name, &format))) {
+		fprintf(stderr, "%s: error: unable to parse input file"
+		        " `%s'\n", progname, name);
+	}
+	stats_file_end();
+
+	return cd;
+}
+
+/* print entry i (0 is the disc) and the names of the fields that changed */
+void print_entry(CdDiff *diff, int i)
+{
+	static const struct {
+		int flag;
+		char *name;
+	} flags[] = {
+		{FLAG_PRE_EMPHASIS, "PRE"},
+		{FLAG_COPY_PERMITTED, "DCP"},
+		{FLAG_DATA, "DATA"},
+		{FLAG_FOUR_CHANNEL, "4CH"},
+		{FLAG_SCMS, "SCMS"}
+	};
+	int changed = diff->changed[i];
+	char *sep = "=";
+	int pti;
+	int j;
+
+	printf("%d", i);
+	if (changed & DIFF_ADDED) {
+		printf(" added");
+	}
+	if (changed & DIFF_REMOVED) {
+		printf(" removed");
+	}
+	if (changed & DIFF_FILE) {
+		printf(" file");
+	}
+	if (changed & DIFF_LAYOUT) {
+		printf(" layout");
+	}
+	if (changed & DIFF_FLAGS) {
+		printf(" flags");
+		for (j = 0; j < (int) (sizeof(flags) / sizeof(flags[0])); j++) {
+			if (diff->flags[i] & flags[j].flag) {
+				printf("%s%s", sep, flags[j].name);
+				sep = ",";
+			}
+		}
+	}
+	if (changed & DIFF_ISRC) {
+		printf((0 == i) ? " catalog" : " isrc");
+	}
+	for (pti = 0; pti < PTI_END; pti++) {
+		if (diff->cdtext[i] & (1L << pti)) {
+			printf(" %s", cdtext_get_key(pti, 0 != i));
+		}
+	}
+	printf("\n");
+}
+
+/*
+ * print the tracks of new whose tags changed
+ * album fields and the track count are in the tags of every track
+ */
+void print_tracks(CdDiff *diff, int ntrack, int all)
+{
+	int i;
+
+	for (i = 1; i <= ntrack; i++) {
+		if (all || (diff->changed[i] & DIFF_TAGS)) {
+			printf("%d\n", i);
+		}
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	Cd *a = NULL;
+	Cd *b = NULL;
+	CdDiff diff;
+	int format = UNKNOWN;
+	int tracks = 0;
+	int quiet = 0;
+	int ret = 2;
+	int all;
+	int i;
+
+	/* option variables */
+	int c;
+	/* getopt_long() variables */
+	extern char *optarg;
+	extern int optind;
+
+	static struct option longopts[] = {
+		{"help", no_argument, NULL, 'h'},
+		{"input-format", required_argument, NULL, 'i'},
+		{"tracks", no_argument, NULL, 't'},
+		{"quiet", no_argument, NULL, 'q'},
+		{"stats", no_argument, NULL, 'S'},
+		{"version", no_argument, NULL, 'V'},
+		{NULL, 0, NULL, 0}
+	};
+
+	progname = argv[0];
+
+	while (-1 != (c = getopt_long(argc, argv, "hi:tqV", longopts, NULL))) {
+		switch (c) {
+		case 'h':
+			usage(0);
+			break;
+		case 'i':
+			if (UNKNOWN == (format = cf_format_from_name(optarg))) {
+				fprintf(stderr, "%s: error: unknown input file"
+				        " format `%s'\n", progname, optarg);
+				usage(2);
+			}
+			break;
+		case 't':
+			tracks = 1;
+			break;
+		case 'q':
+			quiet = 1;
+			break;
+		case 'S':
+			stats_enable();
+			break;
+		case 'V':
+			version();
+			break;
+		default:
+			usage(2);
+			break;
+		}
+	}
+
+	if (2 != argc - optind) {
+		usage(2);
+	}
+
+	if (NULL != (a = parse(argv[optind], format))
+	    && NULL != (b = parse(argv[optind + 1], format))) {
+		ret = (0 == cd_diff(a, b, &diff)) ? 0 : 1;
+
+		all = (0 != (diff.changed[0] & (DIFF_ISRC | DIFF_CDTEXT))
+		       || cd_get_ntrack(a) != cd_get_ntrack(b));
+		if (quiet) {
+			/* only the exit status */
+		} else if (tracks) {
+			print_tracks(&diff, cd_get_ntrack(b), all);
+		} else {
+			for (i = 0; i <= diff.ntrack; i++) {
+				if (0 != diff.changed[i]) {
+					print_entry(&diff, i);
+				}
+			}
+		}
+	}
+
+	if (NULL != a) {
+		cd_delete(a);
+	}
+	if (NULL != b) {
+		cd_delete(b);
+	}
+
+	if (stats_enabled()) {
+		stats_print(stderr);
+	}
+
+	return ret;
+}
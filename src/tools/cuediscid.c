@@ -0,0 +1,202 @@
+/*
+ * cuediscid.c -- compute disc IDs from a cue or toc file
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#include <getopt.h>	/* getopt_long() */
+#include <stdio.h>	/* fprintf(), printf(), stderr */
+#include <stdlib.h>	/* exit() */
+#include <string.h>	/* strcmp() */
+#include "cuefile.h"
+#include "discid.h"
+#include "stats.h"
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#else /* not HAVE_CONFIG_H */
+#define PACKAGE_STRING "cuediscid"
+#endif /* HAVE_CONFIG_H */
+
+/* disc ID types */
+enum IdType {
+	ID_CDDB		= 0x01,
+	ID_MUSICBRAINZ	= 0x02,
+	ID_ACCURATERIP	= 0x04,
+	ID_ALL		= 0x07
+};
+
+char *progname;
+
+/* Print usage information and exit */
+void usage(int status)
+{
+	if (0 == status) {
+		printf("Usage: %s [option...] [file...]\n", progname);
+		printf("Compute CDDB, MusicBrainz and AccurateRip disc IDs from a CUE or TOC file.\n"
+		       "\n"
+		       "OPTIONS\n"
+		       "-h, --help			print usage\n"
+		       "-i, --input-format cue|toc	set format of file(s)\n"
+		       "-t, --type cddb|musicbrainz|accuraterip\n"
+		       "				print only one type of disc ID\n"
+		       "--stats				print timing and allocation statistics\n"
+		       "-V, --version			print version information\n");
+	} else {
+		fprintf(stderr, "Try `%s --help' for more information.\n", progname);
+	}
+
+	exit (status);
+}
+
+/* Print version information and exit */
+void version()
+{
+	printf("%s\n", PACKAGE_STRING);
+
+	exit(0);
+}
+
+int discid(char *name, int format, int types)
+{
+	Cd *cd = NULL;
+	DiscToc toc;
+	char mbid[MUSICBRAINZ_ID_LEN + 1];
+	unsigned long id1;
+	unsigned long id2;
+	int naudio = 0;
+	int phase;
+	int i;
+	int n;
+
+	stats_file_begin(name);
+
+	if (NULL == (cd = cf_parse(name, &format))) {
+		fprintf(stderr, "%s: error: unable to parse input file"
+		        " `%s'\n", progname, name);
+		stats_file_end();
+		return -1;
+	}
+
+	phase = stats_phase(PHASE_IO);
+	cf_set_lengths(cd, name);
+	stats_phase(phase);
+
+	if (0 != discid_toc(cd, &toc)) {
+		fprintf(stderr, "%s: error: unable to lay out tracks of `%s'\n",
+		        progname, name);
+		cd_delete(cd);
+		stats_file_end();
+		return -1;
+	}
+
+	phase = stats_phase(PHASE_PRINT);
+	n = 0;
+	if (types & ID_CDDB) {
+		n += printf("%08lx ", discid_cddb(&toc));
+	}
+	if (types & ID_MUSICBRAINZ) {
+		discid_musicbrainz(&toc, mbid);
+		n += printf("%s ", mbid);
+	}
+	if (types & ID_ACCURATERIP) {
+		for (i = 0; i < toc.naudio; i++) {
+			naudio += !toc.data[i];
+		}
+		discid_accuraterip(&toc, &id1, &id2);
+		n += printf("%03d-%08lx-%08lx-%08lx ", naudio, id1, id2,
+		            discid_cddb(&toc));
+	}
+	n += printf(" %s\n", name);
+	stats_count(STATS_BYTES_WRITTEN, n);
+	stats_phase(phase);
+
+	cd_delete(cd);
+	stats_file_end();
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	int format = UNKNOWN;
+	int types = ID_ALL;
+	int ret = 0;		/* return value of discid() */
+
+	/* option variables */
+	int c;
+	/* getopt_long() variables */
+	extern char *optarg;
+	extern int optind;
+
+	static struct option longopts[] = {
+		{"help", no_argument, NULL, 'h'},
+		{"input-format", required_argument, NULL, 'i'},
+		{"type", required_argument, NULL, 't'},
+		{"stats", no_argument, NULL, 'S'},
+		{"version", no_argument, NULL, 'V'},
+		{NULL, 0, NULL, 0}
+	};
+
+	progname = argv[0];
+
+	while (-1 != (c = getopt_long(argc, argv, "hi:t:V", longopts, NULL))) {
+		switch (c) {
+		case 'h':
+			usage(0);
+			break;
+		case 'i':
+			if (UNKNOWN == (format = cf_format_from_name(optarg))) {
+				fprintf(stderr, "%s: error: unknown input file"
+				        " format `%s'\n", progname, optarg);
+				usage(1);
+			}
+			break;
+		case 't':
+			if (0 == strcmp("cddb", optarg)) {
+				types = ID_CDDB;
+			} else if (0 == strcmp("musicbrainz", optarg)) {
+				types = ID_MUSICBRAINZ;
+			} else if (0 == strcmp("accuraterip", optarg)) {
+				types = ID_ACCURATERIP;
+			} else {
+				fprintf(stderr, "%s: error: unknown disc ID"
+				        " type `%s'\n", progname, optarg);
+				usage(1);
+			}
+			break;
+		case 'S':
+			stats_enable();
+			break;
+		case 'V':
+			version();
+			break;
+		default:
+			usage(1);
+			break;
+		}
+	}
+
+	/* What we do depends on the number of operands. */
+	if (optind == argc) {
+		/* No operands: compute disc IDs of stdin. */
+		ret = discid("-", format, types);
+	} else {
+		/*
+		 * Compute disc IDs for each operand.  A bad sheet does not
+		 * stop a batch run, but is reflected in the exit status.
+		 */
+		for (; optind < argc; optind++) {
+			if (0 != discid(argv[optind], format, types)) {
+				ret = 1;
+			}
+		}
+	}
+
+	if (stats_enabled()) {
+		stats_print(stderr);
+	}
+
+	return ret;
+}
@@ -0,0 +1,489 @@
+/*
+ * cueextract.c -- extract the data tracks of a cue or toc file
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#include <errno.h>	/* errno, EINTR */
+#include <fcntl.h>	/* open() */
+#include <getopt.h>	/* getopt_long() */
+#include <stdio.h>	/* fprintf(), printf(), snprintf(), stderr */
+#include <stdlib.h>	/* exit(), atoi(), calloc(), free() */
+#include <string.h>	/* memcmp(), strcmp() */
+#include <sys/mman.h>	/* mmap(), madvise() */
+#include <sys/stat.h>	/* fstat() */
+#include <sys/uio.h>	/* writev() */
+#include <unistd.h>	/* close() */
+#include "cuefile.h"
+#include "probe.h"
+#include "stats.h"
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#else /* not HAVE_CONFIG_H */
+#define PACKAGE_STRING "cueextract"
+#endif /* HAVE_CONFIG_H */
+
+#define SECTOR_SIZE	2352
+#define USER_SIZE	2048	/* user data of a mode 1 or form 1 sector */
+#define FORM2_SIZE	2324	/* user data of a form 2 sector */
+#define BATCH		1024	/* sectors per writev(); at most IOV_MAX */
+
+#define SUBMODE_FORM2	0x20	/* XA subheader submode bit */
+
+/* the sync pattern that starts every raw data sector */
+static const unsigned char sync_pattern[12] = {
+	0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00
+};
+
+/* a mapped data track */
+typedef struct Image Image;
+struct Image {
+	unsigned char *map;
+	size_t mapsize;
+	const unsigned char *data;	/* first sector of the track */
+	long length;			/* sectors */
+	long block;			/* bytes per sector */
+};
+
+/* one file and channel of a mode 2 track */
+typedef struct Stream Stream;
+struct Stream {
+	int fd;
+	int file;
+	int channel;
+	long sectors;
+	long form2;		/* of those, form 2 sectors */
+	int n;			/* payloads waiting to be written */
+	struct iovec iov[BATCH];
+};
+
+char *progname;
+
+/* Print usage information and exit */
+void usage(int status)
+{
+	if (0 == status) {
+		printf("Usage: %s [option...] file\n", progname);
+		printf("Extract a data track of a CUE or TOC file as an ISO image.\n"
+		       "\n"
+		       "OPTIONS\n"
+		       "-h, --help			print usage\n"
+		       "-i, --input-format cue|toc	set format of file\n"
+		       "-o, --output file		write the image to file (default stdout)\n"
+		       "-t, --track n			extract track n (default first data track)\n"
+		       "-x, --demux prefix		split a mode 2 track into one file per\n"
+		       "				XA file and channel, named prefix-file-channel.bin\n"
+		       "--stats				print timing and allocation statistics\n"
+		       "-V, --version			print version information\n");
+	} else {
+		fprintf(stderr, "Try `%s --help' for more information.\n", progname);
+	}
+
+	exit (status);
+}
+
+/* Print version information and exit */
+void version()
+{
+	printf("%s\n", PACKAGE_STRING);
+
+	exit(0);
+}
+
+/* write all of iov, going on after short writes */
+int writev_all(int fd, struct iovec *iov, int n)
+{
+	ssize_t len;
+
+	while (0 < n) {
+		if (0 > (len = writev(fd, iov, n))) {
+			if (EINTR == errno) {
+				continue;
+			}
+			return -1;
+		}
+		stats_count(STATS_BYTES_WRITTEN, len);
+
+		for (; 0 < n && (size_t) len >= iov->iov_len; iov++, n--) {
+			len -= iov->iov_len;
+		}
+		if (0 < n) {
+			iov->iov_base = (char *) iov->iov_base + len;
+			iov->iov_len -= len;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * write the user data of n raw mode 1 sectors
+ * the sync, header, EDC and ECC are left out.  returns the number of
+ * sectors with a bad sync pattern or mode, or -1 on a write error
+ */
+long extract_mode1(int fd, const unsigned char *data, long n)
+{
+	struct iovec iov[BATCH];
+	const unsigned char *sector = NULL;
+	long bad = 0;
+	long i;
+	int k;
+
+	for (i = 0; i < n; i += k) {
+		for (k = 0; k < BATCH && i + k < n; k++) {
+			sector = data + (i + k) * SECTOR_SIZE;
+			if (0 != memcmp(sector, sync_pattern, 12) || 1 != sector[15]) {
+				bad++;
+			}
+			iov[k].iov_base = (void *) (sector + 16);
+			iov[k].iov_len = USER_SIZE;
+		}
+		if (0 != writev_all(fd, iov, k)) {
+			return -1;
+		}
+	}
+
+	return bad;
+}
+
+/* write len bytes at data */
+int write_all(int fd, const unsigned char *data, size_t len)
+{
+	struct iovec iov;
+
+	iov.iov_base = (void *) data;
+	iov.iov_len = len;
+
+	return writev_all(fd, &iov, 1);
+}
+
+/* track trackno, or the first data track if trackno is 0 */
+Track *find_track(Cd *cd, int trackno)
+{
+	int i;
+
+	if (0 != trackno) {
+		return (0 < trackno && trackno <= cd_get_ntrack(cd))
+		       ? cd_get_track(cd, trackno) : NULL;
+	}
+
+	for (i = 1; i <= cd_get_ntrack(cd); i++) {
+		if (MODE_AUDIO != track_get_mode(cd_get_track(cd, i))) {
+			return cd_get_track(cd, i);
+		}
+	}
+
+	return NULL;
+}
+
+/* map the data file of track; image->data is its first sector */
+int map_track(Image *image, Track *track, char *sheet)
+{
+	char path[4096];
+	struct stat st;
+	Probe probe;
+	long offset;
+	long end;		/* of the data in the file */
+	int fd;
+
+	cf_data_path(path, sizeof(path), sheet, track_get_filename(track));
+
+	if (-1 == (fd = open(path, O_RDONLY))) {
+		fprintf(stderr, "%s: error opening file\n", path);
+		return -1;
+	}
+	if (0 != fstat(fd, &st) || 0 == st.st_size) {
+		fprintf(stderr, "%s: empty file\n", path);
+		close(fd);
+		return -1;
+	}
+
+	image->mapsize = st.st_size;
+	image->map = mmap(NULL, image->mapsize, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (MAP_FAILED == image->map) {
+		fprintf(stderr, "%s: error mapping file\n", path);
+		return -1;
+	}
+	madvise(image->map, image->mapsize, MADV_SEQUENTIAL);
+
+	/* the track runs from its start to its length or the end of the file */
+	probe_memory(image->map, image->mapsize, track_get_filetype(track),
+	             &probe);
+	image->block = track_get_block_size(track);
+	end = probe.offset + probe.size;
+	offset = probe.offset + track_get_start(track) * image->block;
+	if (offset > end) {
+		offset = end;
+	}
+	image->data = image->map + offset;
+	image->length = track_get_length(track);
+	if (0 == image->length || image->length > (end - offset) / image->block) {
+		image->length = (end - offset) / image->block;
+	}
+	stats_count(STATS_BYTES_READ, image->length * image->block);
+
+	return 0;
+}
+
+/* write the user data of a mode 1 or form 1 track to outfd */
+int extract_track(Image *image, int outfd)
+{
+	long bad = 0;
+
+	if (SECTOR_SIZE == image->block) {
+		bad = extract_mode1(outfd, image->data, image->length);
+	} else {
+		bad = write_all(outfd, image->data, image->length * image->block);
+	}
+
+	if (0 > bad) {
+		fprintf(stderr, "%s: error: unable to write image\n", progname);
+		return -1;
+	} else if (0 < bad) {
+		fprintf(stderr, "%s: warning: %ld sectors with a bad header\n",
+		        progname, bad);
+	}
+
+	return 0;
+}
+
+/* queue the payload of a sector for its stream, flushing a full batch */
+int stream_add(Stream *stream, const unsigned char *payload, size_t len)
+{
+	stream->iov[stream->n].iov_base = (void *) payload;
+	stream->iov[stream->n].iov_len = len;
+	stream->sectors++;
+
+	if (BATCH == ++stream->n) {
+		stream->n = 0;
+		return writev_all(stream->fd, stream->iov, BATCH);
+	}
+
+	return 0;
+}
+
+/*
+ * route each sector of a mode 2 track to the stream of its XA subheader
+ * file and channel, writing each stream to prefix-file-channel.bin
+ * the image is read once, in order; the payloads are written from the
+ * mapping in batches of up to BATCH sectors per stream
+ */
+int demux_track(Image *image, char *prefix)
+{
+	Stream **stream = NULL;		/* by file << 8 | channel */
+	Stream *s = NULL;
+	const unsigned char *sector = NULL;
+	const unsigned char *sub = NULL;	/* XA subheader */
+	char name[4096];
+	long skip = (SECTOR_SIZE == image->block) ? 16 : 0;	/* sync, header */
+	long bad = 0;
+	long i;
+	int ret = 0;
+	int n;
+
+	if (NULL == (stream = calloc(65536, sizeof(Stream *)))) {
+		fprintf(stderr, "unable to allocate memory\n");
+		return -1;
+	}
+
+	for (i = 0; i < image->length && 0 == ret; i++) {
+		sector = image->data + i * image->block;
+		if (skip && (0 != memcmp(sector, sync_pattern, 12)
+		             || 2 != sector[15])) {
+			bad++;
+		}
+		sub = sector + skip;
+		n = sub[0] << 8 | sub[1];
+
+		if (NULL == (s = stream[n])) {
+			snprintf(name, sizeof(name), "%s-%d-%d.bin", prefix,
+			         sub[0], sub[1]);
+			if (NULL == (s = calloc(1, sizeof(Stream)))
+			    || -1 == (s->fd = open(name,
+			              O_WRONLY | O_CREAT | O_TRUNC, 0666))) {
+				fprintf(stderr, "%s: error opening file\n", name);
+				free(s);
+				ret = -1;
+				break;
+			}
+			s->file = sub[0];
+			s->channel = sub[1];
+			stream[n] = s;
+		}
+
+		/* the submode says which form the sector is */
+		if (sub[2] & SUBMODE_FORM2) {
+			s->form2++;
+			ret = stream_add(s, sub + 8, FORM2_SIZE);
+		} else {
+			ret = stream_add(s, sub + 8, USER_SIZE);
+		}
+	}
+
+	/* flush, close and list the streams */
+	for (n = 0; n < 65536; n++) {
+		if (NULL == (s = stream[n])) {
+			continue;
+		}
+		if (0 == ret && 0 < s->n) {
+			ret = writev_all(s->fd, s->iov, s->n);
+		}
+		if (0 != close(s->fd)) {
+			ret = -1;
+		}
+		printf("%s-%d-%d.bin\tfile %d\tchannel %d\t%ld sectors"
+		       " (%ld form 2)\n", prefix, s->file, s->channel, s->file,
+		       s->channel, s->sectors, s->form2);
+		free(s);
+	}
+	free(stream);
+
+	if (0 != ret) {
+		fprintf(stderr, "%s: error: unable to write streams\n", progname);
+		return -1;
+	} else if (0 < bad) {
+		fprintf(stderr, "%s: warning: %ld sectors with a bad header\n",
+		        progname, bad);
+	}
+
+	return 0;
+}
+
+int extract(char *name, int format, int trackno, char *out, char *prefix)
+{
+	Cd *cd = NULL;
+	Track *track = NULL;
+	Image image;
+	int outfd = STDOUT_FILENO;
+	int mode;
+	int phase;
+	int ret = -1;
+
+	stats_file_begin(name);
+
+	if (NULL == (cd = cf_parse(name, &format))) {
+		fprintf(stderr, "%s: error: unable to parse input file"
+		        " `%s'\n", progname, name);
+		stats_file_end();
+		return -1;
+	}
+
+	phase = stats_phase(PHASE_IO);
+	cf_set_lengths(cd, name);
+
+	track = find_track(cd, trackno);
+	mode = (NULL != track) ? track_get_mode(track) : MODE_AUDIO;
+
+	if (NULL == track || NULL == track_get_filename(track)) {
+		fprintf(stderr, "%s: error: no such data track in `%s'\n",
+		        progname, name);
+	} else if (NULL != prefix && MODE_MODE2 != mode
+	           && MODE_MODE2_FORM_MIX != mode && MODE_MODE2_RAW != mode) {
+		fprintf(stderr, "%s: error: not a mode 2 track with XA"
+		        " subheaders\n", progname);
+	} else if (NULL == prefix && MODE_MODE1 != mode
+	           && MODE_MODE1_RAW != mode && MODE_MODE2_FORM1 != mode) {
+		fprintf(stderr, "%s: error: not a mode 1 or mode 2 form 1"
+		        " track\n", progname);
+	} else if (0 == map_track(&image, track, name)) {
+		if (NULL != prefix) {
+			ret = demux_track(&image, prefix);
+		} else if (0 != strcmp("-", out) && -1 == (outfd = open(out,
+		           O_WRONLY | O_CREAT | O_TRUNC, 0666))) {
+			fprintf(stderr, "%s: error opening file\n", out);
+		} else {
+			ret = extract_track(&image, outfd);
+			if (STDOUT_FILENO != outfd && 0 != close(outfd)) {
+				fprintf(stderr, "%s: error writing file\n", out);
+				ret = -1;
+			}
+		}
+		munmap(image.map, image.mapsize);
+	}
+	stats_phase(phase);
+
+	cd_delete(cd);
+	stats_file_end();
+
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	int format = UNKNOWN;
+	int trackno = 0;
+	char *out = "-";
+	char *prefix = NULL;	/* demultiplex to prefix-file-channel.bin */
+
+	/* option variables */
+	int c;
+	/* getopt_long() variables */
+	extern char *optarg;
+	extern int optind;
+
+	static struct option longopts[] = {
+		{"help", no_argument, NULL, 'h'},
+		{"input-format", required_argument, NULL, 'i'},
+		{"output", required_argument, NULL, 'o'},
+		{"track", required_argument, NULL, 't'},
+		{"demux", required_argument, NULL, 'x'},
+		{"stats", no_argument, NULL, 'S'},
+		{"version", no_argument, NULL, 'V'},
+		{NULL, 0, NULL, 0}
+	};
+
+	progname = argv[0];
+
+	while (-1 != (c = getopt_long(argc, argv, "hi:o:t:x:V", longopts, NULL))) {
+		switch (c) {
+		case 'h':
+			usage(0);
+			break;
+		case 'i':
+			if (UNKNOWN == (format = cf_format_from_name(optarg))) {
+				fprintf(stderr, "%s: error: unknown input file"
+				        " format `%s'\n", progname, optarg);
+				usage(1);
+			}
+			break;
+		case 'o':
+			out = optarg;
+			break;
+		case 't':
+			if (0 >= (trackno = atoi(optarg))) {
+				fprintf(stderr, "%s: error: bad track number"
+				        " `%s'\n", progname, optarg);
+				usage(1);
+			}
+			break;
+		case 'x':
+			prefix = optarg;
+			break;
+		case 'S':
+			stats_enable();
+			break;
+		case 'V':
+			version();
+			break;
+		default:
+			usage(1);
+			break;
+		}
+	}
+
+	/* exactly one sheet; its data files are found relative to it */
+	if (optind + 1 != argc) {
+		usage(1);
+	}
+
+	c = extract(argv[optind], format, trackno, out, prefix);
+
+	if (stats_enabled()) {
+		stats_print(stderr);
+	}
+
+	return (0 == c) ? 0 : 1;
+}
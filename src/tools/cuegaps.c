@@ -0,0 +1,379 @@
+/*
+ * cuegaps.c -- write a cue or toc file for audio files by finding the silence
+ * between tracks
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#include <fcntl.h>	/* open() */
+#include <getopt.h>	/* getopt_long() */
+#include <math.h>	/* pow() */
+#include <stdint.h>	/* uint64_t */
+#include <stdio.h>	/* fprintf(), printf(), stderr */
+#include <stdlib.h>	/* exit(), atof(), malloc(), free() */
+#include <string.h>	/* strcmp() */
+#include <sys/mman.h>	/* mmap(), madvise() */
+#include <sys/stat.h>	/* fstat() */
+#include <unistd.h>	/* close() */
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "cuefile.h"
+#include "probe.h"
+#include "stats.h"
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#else /* not HAVE_CONFIG_H */
+#define PACKAGE_STRING "cuegaps"
+#endif /* HAVE_CONFIG_H */
+
+#define BYTES_PER_FRAME		2352
+#define VALUES_PER_FRAME	1176	/* 16-bit values, both channels */
+#define FRAMES_PER_SECOND	75
+
+/* where the silence between two tracks goes */
+enum GapMode {
+	GAP_PREGAP,	/* index 00 of the next track */
+	GAP_APPEND	/* end of the previous track */
+};
+
+char *progname;
+
+/* Print usage information and exit */
+void usage(int status)
+{
+	if (0 == status) {
+		printf("Usage: %s [option...] file...\n", progname);
+		printf("Write a CUE or TOC file for WAVE, AIFF or raw audio files, starting a track\n"
+		       "after each silence.\n"
+		       "\n"
+		       "OPTIONS\n"
+		       "-h, --help			print usage\n"
+		       "-o, --output-format cue|toc	set format of output (default cue)\n"
+		       "-t, --threshold dB		silence is quieter than dB (default -60)\n"
+		       "-g, --gap seconds		shortest silence between tracks (default 1.5)\n"
+		       "-m, --min-track seconds		shortest track (default 10)\n"
+		       "-a, --append-gaps		leave silence at the end of the previous\n"
+		       "				track instead of making it a pregap\n"
+		       "-b, --big-endian		raw files are big-endian (MOTOROLA)\n"
+		       "--stats				print timing and allocation statistics\n"
+		       "-V, --version			print version information\n");
+	} else {
+		fprintf(stderr, "Try `%s --help' for more information.\n", progname);
+	}
+
+	exit (status);
+}
+
+/* Print version information and exit */
+void version()
+{
+	printf("%s\n", PACKAGE_STRING);
+
+	exit(0);
+}
+
+/*
+ * sum of squares and peak of one frame of 16-bit samples
+ * swap is set for big-endian samples (most AIFF, or raw with --big-endian)
+ */
+void frame_level(const unsigned char *p, int swap, uint64_t *sumsq, int *peak)
+{
+	uint64_t sum = 0;
+	int max = 0;
+	int s;
+	int i;
+
+#ifdef __SSE2__
+	__m128i zero = _mm_setzero_si128();
+	__m128i acc = zero;
+	__m128i top = zero;
+	__m128i x;
+	__m128i sq;
+	uint64_t lanes[2];
+	int16_t peaks[8];
+
+	/* VALUES_PER_FRAME is a multiple of 8 */
+	for (i = 0; i < VALUES_PER_FRAME; i += 8) {
+		x = _mm_loadu_si128((const __m128i *) (p + 2 * i));
+		if (swap) {
+			x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+		}
+
+		/*
+		 * pairs of squares fit in 32 bits unsigned, so widen them
+		 * with zeros rather than signs
+		 */
+		sq = _mm_madd_epi16(x, x);
+		acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(sq, zero));
+		acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(sq, zero));
+
+		/* |x|, with -32768 saturating to 32767 */
+		top = _mm_max_epi16(top, _mm_max_epi16(x, _mm_subs_epi16(zero, x)));
+	}
+
+	_mm_storeu_si128((__m128i *) lanes, acc);
+	_mm_storeu_si128((__m128i *) peaks, top);
+	sum = lanes[0] + lanes[1];
+	for (s = 0; s < 8; s++) {
+		max = (peaks[s] > max) ? peaks[s] : max;
+	}
+#else
+	for (i = 0; i < VALUES_PER_FRAME; i++) {
+		s = swap ? (int16_t) (p[2 * i] << 8 | p[2 * i + 1])
+		         : (int16_t) (p[2 * i + 1] << 8 | p[2 * i]);
+		sum += (uint64_t) (s * s);
+		s = (0 > s) ? -s : s;
+		max = (s > max) ? s : max;
+	}
+#endif
+
+	*sumsq = sum;
+	*peak = max;
+}
+
+/*
+ * mark the silent frames of n frames of audio
+ * a frame is silent if its RMS level is below the threshold and its peak
+ * is less than 12 dB above it, so that clicks do not break up a silence
+ */
+void find_silence(const unsigned char *data, long n, int swap,
+                  double threshold, unsigned char *silent)
+{
+	/* the threshold as a sum of squares over a frame, and as a peak */
+	double amplitude = 32768.0 * pow(10.0, threshold / 20.0);
+	uint64_t limit = amplitude * amplitude * VALUES_PER_FRAME;
+	uint64_t sumsq;
+	int peak;
+	long i;
+
+	for (i = 0; i < n; i++) {
+		frame_level(data + i * BYTES_PER_FRAME, swap, &sumsq, &peak);
+		silent[i] = (sumsq < limit && peak < 4 * amplitude);
+	}
+}
+
+/*
+ * add a track of cd starting in file at frames index0 (pregap) and index1
+ * returns NULL if cd is full
+ */
+Track *add_track(Cd *cd, char *file, int filetype, long index0, long index1)
+{
+	Track *track = NULL;
+
+	if (MAXTRACK == cd_get_ntrack(cd)) {
+		fprintf(stderr, "%s: error: more than %d tracks found\n",
+		        progname, MAXTRACK);
+		return NULL;
+	}
+
+	track = cd_add_track(cd);
+	track_set_filename(track, file);
+	track_set_filetype(track, filetype);
+	track_set_mode(track, MODE_AUDIO);
+	track_set_start(track, index0);
+	track_add_index(track, 0);
+	track_add_index(track, index1 - index0);
+
+	return track;
+}
+
+/*
+ * split one audio file into tracks, adding them to cd
+ * rawtype is the FileType of a file with no header, BINARY or MOTOROLA
+ */
+int scan_file(Cd *cd, char *name, int rawtype, double threshold,
+              long mingap, long mintrack, int gapmode)
+{
+	Track *track = NULL;
+	struct stat st;
+	Probe probe;
+	unsigned char *map = NULL;
+	unsigned char *silent = NULL;
+	size_t mapsize;
+	long n;
+	long start = 0;		/* index 01 of the current track */
+	long run;		/* start of a run of silence */
+	long i;
+	int swap;
+	int fd;
+
+	if (-1 == (fd = open(name, O_RDONLY))) {
+		fprintf(stderr, "%s: error opening file\n", name);
+		return -1;
+	}
+	if (0 != fstat(fd, &st) || 0 == st.st_size) {
+		fprintf(stderr, "%s: empty file\n", name);
+		close(fd);
+		return -1;
+	}
+
+	mapsize = st.st_size;
+	map = mmap(NULL, mapsize, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (MAP_FAILED == map) {
+		fprintf(stderr, "%s: error mapping file\n", name);
+		return -1;
+	}
+	madvise(map, mapsize, MADV_SEQUENTIAL);
+
+	if (0 != probe_memory(map, mapsize, rawtype, &probe)
+	    || 44100 != probe.rate || 2 != probe.channels || 16 != probe.bits) {
+		fprintf(stderr, "%s: not 16-bit stereo 44.1 kHz audio\n", name);
+		munmap(map, mapsize);
+		return -1;
+	}
+	swap = probe.big_endian;
+	n = probe.size / BYTES_PER_FRAME;
+
+	if (NULL == (silent = malloc(n + 1))) {
+		fprintf(stderr, "unable to allocate memory\n");
+		munmap(map, mapsize);
+		return -1;
+	}
+	stats_count(STATS_BYTES_READ, n * BYTES_PER_FRAME);
+	find_silence(map + probe.offset, n, swap, threshold, silent);
+	silent[n] = 0;	/* stops the last run */
+	munmap(map, mapsize);
+
+	track = add_track(cd, name, probe.filetype, 0, 0);
+
+	/* a long enough run of silence, with sound after it, ends a track */
+	for (i = 0; i < n && NULL != track; i++) {
+		if (!silent[i]) {
+			continue;
+		}
+		for (run = i; silent[i]; i++)
+			;
+		if (i - run < mingap || i == n || run - start < mintrack) {
+			continue;
+		}
+
+		track_set_length(track, ((GAP_PREGAP == gapmode) ? run : i)
+		                        - track_get_start(track));
+		if (GAP_PREGAP == gapmode) {
+			track = add_track(cd, name, probe.filetype, run, i);
+		} else {
+			track = add_track(cd, name, probe.filetype, i, i);
+		}
+		start = i;
+	}
+	if (NULL != track) {
+		track_set_length(track, n - track_get_start(track));
+	}
+
+	free(silent);
+
+	return (NULL != track) ? 0 : -1;
+}
+
+int main(int argc, char *argv[])
+{
+	Cd *cd = NULL;
+	int format = CUE;
+	double threshold = -60.0;
+	double gap = 1.5;
+	double mintrack = 10.0;
+	int gapmode = GAP_PREGAP;
+	int rawtype = FILE_BINARY;
+	int phase;
+	int ret = 0;
+
+	/* option variables */
+	int c;
+	/* getopt_long() variables */
+	extern char *optarg;
+	extern int optind;
+
+	static struct option longopts[] = {
+		{"help", no_argument, NULL, 'h'},
+		{"output-format", required_argument, NULL, 'o'},
+		{"threshold", required_argument, NULL, 't'},
+		{"gap", required_argument, NULL, 'g'},
+		{"min-track", required_argument, NULL, 'm'},
+		{"append-gaps", no_argument, NULL, 'a'},
+		{"big-endian", no_argument, NULL, 'b'},
+		{"stats", no_argument, NULL, 'S'},
+		{"version", no_argument, NULL, 'V'},
+		{NULL, 0, NULL, 0}
+	};
+
+	progname = argv[0];
+
+	while (-1 != (c = getopt_long(argc, argv, "ho:t:g:m:abV", longopts,
+	                              NULL))) {
+		switch (c) {
+		case 'h':
+			usage(0);
+			break;
+		case 'o':
+			if (0 == strcmp("cue", optarg)) {
+				format = CUE;
+			} else if (0 == strcmp("toc", optarg)) {
+				format = TOC;
+			} else {
+				fprintf(stderr, "%s: error: unknown output file"
+				        " format `%s'\n", progname, optarg);
+				usage(1);
+			}
+			break;
+		case 't':
+			if (0 <= (threshold = atof(optarg))) {
+				fprintf(stderr, "%s: error: threshold must be"
+				        " below 0 dB\n", progname);
+				usage(1);
+			}
+			break;
+		case 'g':
+			gap = atof(optarg);
+			break;
+		case 'm':
+			mintrack = atof(optarg);
+			break;
+		case 'a':
+			gapmode = GAP_APPEND;
+			break;
+		case 'b':
+			rawtype = FILE_MOTOROLA;
+			break;
+		case 'S':
+			stats_enable();
+			break;
+		case 'V':
+			version();
+			break;
+		default:
+			usage(1);
+			break;
+		}
+	}
+
+	if (optind == argc) {
+		usage(1);
+	}
+
+	/* each file starts a track of its own */
+	cd = cd_init();
+	phase = stats_phase(PHASE_IO);
+	for (; optind < argc && 0 == ret; optind++) {
+		stats_file_begin(argv[optind]);
+		ret = scan_file(cd, argv[optind], rawtype, threshold,
+		                gap * FRAMES_PER_SECOND,
+		                mintrack * FRAMES_PER_SECOND, gapmode);
+		stats_file_end();
+	}
+	stats_phase(phase);
+
+	if (0 == ret) {
+		ret = cf_print("-", &format, cd);
+	}
+	cd_delete(cd);
+
+	if (stats_enabled()) {
+		stats_print(stderr);
+	}
+
+	return (0 == ret) ? 0 : 1;
+}
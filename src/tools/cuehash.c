@@ -0,0 +1,371 @@
+/*
+ * cuehash.c -- hash the canonical form of cue or toc files, and find
+ * duplicate discs
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#include <getopt.h>	/* getopt_long() */
+#include <stdio.h>	/* fprintf(), printf(), stderr */
+#include <stdlib.h>	/* exit(), malloc(), realloc(), free() */
+#include <string.h>	/* memcmp(), memcpy(), strdup() */
+#include "canon.h"
+#include "cuefile.h"
+#include "stats.h"
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#else /* not HAVE_CONFIG_H */
+#define PACKAGE_STRING "cuehash"
+#endif /* HAVE_CONFIG_H */
+
+/* a sheet, remembered for --duplicates */
+typedef struct Sheet Sheet;
+struct Sheet {
+	unsigned char hash[CANON_HASH_SIZE];
+	char *name;
+	long next;		/* next sheet with the same hash, or -1 */
+	long last;		/* of the first sheet of a group: its last */
+	long count;		/* of the first sheet of a group: its size */
+};
+
+/* sheets bucketed by hash, in an open addressing table of first sheets */
+typedef struct Buckets Buckets;
+struct Buckets {
+	Sheet *sheet;
+	long nsheet;
+	long size;		/* sheets allocated */
+	long *slot;		/* first sheet of a group, or -1 */
+	long nslot;		/* a power of two */
+	long ngroup;
+};
+
+char *progname;
+
+/* Print usage information and exit */
+void usage(int status)
+{
+	if (0 == status) {
+		printf("Usage: %s [option...] [file...]\n", progname);
+		printf("Print a hash of each CUE or TOC file that is the same for sheets of the same\n"
+		       "disc, however they were written, or list the sheets of the same disc.\n"
+		       "\n"
+		       "OPTIONS\n"
+		       "-h, --help			print usage\n"
+		       "-i, --input-format cue|toc	set format of file(s)\n"
+		       "-l, --layout			hash only the track layout, not the text\n"
+		       "-c, --canonical			print the canonical form instead of its hash\n"
+		       "-d, --duplicates		print the sheets that have the same hash,\n"
+		       "				in groups separated by blank lines\n"
+		       "-T, --files-from list		read the names of files from list, one per\n"
+		       "				line (- for standard input)\n"
+		       "-p, --probe			read the lengths of tracks from the headers\n"
+		       "				of their files\n"
+		       "--stats				print timing and allocation statistics\n"
+		       "-V, --version			print version information\n");
+	} else {
+		fprintf(stderr, "Try `%s --help' for more information.\n", progname);
+	}
+
+	exit (status);
+}
+
+/* Print version information and exit */
+void version()
+{
+	printf("%s\n", PACKAGE_STRING);
+
+	exit(0);
+}
+
+void print_hash(unsigned char *hash, char *name)
+{
+	int i;
+
+	for (i = 0; i < CANON_HASH_SIZE; i++) {
+		printf("%02x", hash[i]);
+	}
+	printf("  %s\n", name);
+}
+
+/* the slot of the group with hash, or of the empty slot it would go in */
+long buckets_find(Buckets *b, unsigned char *hash)
+{
+	unsigned long h = hash[0] | hash[1] << 8 | hash[2] << 16
+	                  | (unsigned long) hash[3] << 24;
+	long i = h & (b->nslot - 1);
+
+	while (-1 != b->slot[i]
+	       && 0 != memcmp(b->sheet[b->slot[i]].hash, hash,
+	                      CANON_HASH_SIZE)) {
+		i = (i + 1) & (b->nslot - 1);
+	}
+
+	return i;
+}
+
+/* double the table, keeping it at most half full */
+int buckets_grow(Buckets *b)
+{
+	long *old = b->slot;
+	long nold = b->nslot;
+	long i;
+
+	b->nslot = (0 == nold) ? 1024 : 2 * nold;
+	if (NULL == (b->slot = malloc(b->nslot * sizeof(long)))) {
+		b->slot = old;
+		b->nslot = nold;
+		return -1;
+	}
+	for (i = 0; i < b->nslot; i++) {
+		b->slot[i] = -1;
+	}
+
+	for (i = 0; i < nold; i++) {
+		if (-1 != old[i]) {
+			b->slot[buckets_find(b, b->sheet[old[i]].hash)] = old[i];
+		}
+	}
+	free(old);
+
+	return 0;
+}
+
+int buckets_add(Buckets *b, unsigned char *hash, char *name)
+{
+	Sheet *sheet = NULL;
+	long n = b->nsheet;
+	long size;
+	long i;
+
+	if (n == b->size) {
+		size = (0 == n) ? 1024 : 2 * n;
+		if (NULL == (sheet = realloc(b->sheet, size * sizeof(Sheet)))) {
+			return -1;
+		}
+		b->sheet = sheet;
+		b->size = size;
+	}
+	if (2 * (b->ngroup + 1) > b->nslot && 0 != buckets_grow(b)) {
+		return -1;
+	}
+
+	sheet = &b->sheet[n];
+	memcpy(sheet->hash, hash, CANON_HASH_SIZE);
+	if (NULL == (sheet->name = strdup(name))) {
+		return -1;
+	}
+	sheet->next = -1;
+	sheet->last = n;
+	sheet->count = 1;
+	b->nsheet++;
+
+	i = buckets_find(b, hash);
+	if (-1 == b->slot[i]) {
+		b->slot[i] = n;
+		b->ngroup++;
+	} else {
+		/* append to the group */
+		sheet->count = 0;
+		b->sheet[b->sheet[b->slot[i]].last].next = n;
+		b->sheet[b->slot[i]].last = n;
+		b->sheet[b->slot[i]].count++;
+	}
+
+	return 0;
+}
+
+/* groups of more than one sheet, in the order their first sheets came */
+void buckets_print(Buckets *b)
+{
+	char *sep = "";
+	long i;
+	long j;
+
+	for (i = 0; i < b->nsheet; i++) {
+		if (1 < b->sheet[i].count) {
+			printf("%s", sep);
+			for (j = i; -1 != j; j = b->sheet[j].next) {
+				print_hash(b->sheet[j].hash, b->sheet[j].name);
+			}
+			sep = "\n";
+		}
+	}
+}
+
+void buckets_free(Buckets *b)
+{
+	long i;
+
+	for (i = 0; i < b->nsheet; i++) {
+		free(b->sheet[i].name);
+	}
+	free(b->sheet);
+	free(b->slot);
+}
+
+/* canon flags, and whether to print the form, probe, or bucket */
+typedef struct Options Options;
+struct Options {
+	int format;
+	int flags;
+	int canonical;
+	int probe;
+	Buckets *buckets;
+};
+
+int hash(char *name, Options *opt)
+{
+	Cd *cd = NULL;
+	unsigned char digest[CANON_HASH_SIZE];
+	int format = opt->format;
+	int phase;
+	int ret = 0;
+
+	stats_file_begin(name);
+
+	if (NULL == (cd = cf_parse(name, &format))) {
+		fprintf(stderr, "%s: error: unable to parse input file"
+		        " `%s'\n", progname, name);
+		stats_file_end();
+		return -1;
+	}
+
+	if (opt->probe) {
+		phase = stats_phase(PHASE_IO);
+		cf_set_lengths(cd, name);
+		stats_phase(phase);
+	}
+
+	phase = stats_phase(PHASE_PRINT);
+	if (opt->canonical) {
+		ret = canon_print(stdout, cd, opt->flags);
+	} else if (0 != (ret = canon_hash(cd, opt->flags, digest))) {
+		/* out of memory */
+	} else if (NULL != opt->buckets) {
+		if (0 != (ret = buckets_add(opt->buckets, digest, name))) {
+			fprintf(stderr, "unable to allocate memory\n");
+		}
+	} else {
+		print_hash(digest, name);
+	}
+	stats_phase(phase);
+
+	cd_delete(cd);
+	stats_file_end();
+
+	return ret;
+}
+
+/* hash a file named in a list; a bad sheet does not stop the list */
+int hash_listed(void *arg, char *name)
+{
+	return (0 == hash(name, arg)) ? 0 : 1;
+}
+
+int main(int argc, char *argv[])
+{
+	Options opt;
+	Buckets buckets;
+	char *list = NULL;
+	int duplicates = 0;
+	int ret = 0;
+
+	/* option variables */
+	int c;
+	/* getopt_long() variables */
+	extern char *optarg;
+	extern int optind;
+
+	static struct option longopts[] = {
+		{"help", no_argument, NULL, 'h'},
+		{"input-format", required_argument, NULL, 'i'},
+		{"layout", no_argument, NULL, 'l'},
+		{"canonical", no_argument, NULL, 'c'},
+		{"duplicates", no_argument, NULL, 'd'},
+		{"files-from", required_argument, NULL, 'T'},
+		{"probe", no_argument, NULL, 'p'},
+		{"stats", no_argument, NULL, 'S'},
+		{"version", no_argument, NULL, 'V'},
+		{NULL, 0, NULL, 0}
+	};
+
+	progname = argv[0];
+	memset(&opt, 0, sizeof(opt));
+	memset(&buckets, 0, sizeof(buckets));
+	opt.format = UNKNOWN;
+	opt.flags = CANON_FULL;
+
+	while (-1 != (c = getopt_long(argc, argv, "hi:lcdT:pV", longopts,
+	                              NULL))) {
+		switch (c) {
+		case 'h':
+			usage(0);
+			break;
+		case 'i':
+			if (UNKNOWN == (opt.format = cf_format_from_name(optarg))) {
+				fprintf(stderr, "%s: error: unknown input file"
+				        " format `%s'\n", progname, optarg);
+				usage(1);
+			}
+			break;
+		case 'l':
+			opt.flags |= CANON_LAYOUT;
+			break;
+		case 'c':
+			opt.canonical = 1;
+			break;
+		case 'd':
+			duplicates = 1;
+			break;
+		case 'T':
+			list = optarg;
+			break;
+		case 'p':
+			opt.probe = 1;
+			break;
+		case 'S':
+			stats_enable();
+			break;
+		case 'V':
+			version();
+			break;
+		default:
+			usage(1);
+			break;
+		}
+	}
+
+	if (duplicates && opt.canonical) {
+		fprintf(stderr, "%s: error: --canonical and --duplicates do not"
+		        " go together\n", progname);
+		usage(1);
+	}
+	if (duplicates) {
+		opt.buckets = &buckets;
+	}
+
+	/* A bad sheet does not stop a batch run. */
+	if (NULL != list) {
+		ret = (0 == cf_read_list(list, hash_listed, &opt)) ? 0 : -1;
+	} else if (optind == argc) {
+		ret = hash("-", &opt);
+	}
+	for (; optind < argc; optind++) {
+		if (0 != hash(argv[optind], &opt)) {
+			ret = -1;
+		}
+	}
+
+	if (duplicates) {
+		buckets_print(&buckets);
+		buckets_free(&buckets);
+	}
+
+	if (stats_enabled()) {
+		stats_print(stderr);
+	}
+
+	return (0 == ret) ? 0 : 1;
+}
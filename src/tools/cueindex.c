@@ -0,0 +1,188 @@
+/*
+ * cueindex.c -- build a search index of the text of cue or toc files
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#include <getopt.h>	/* getopt_long() */
+#include <stdio.h>	/* fprintf(), printf(), stderr */
+#include <stdlib.h>	/* exit() */
+#include "cuefile.h"
+#include "search.h"
+#include "stats.h"
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#else /* not HAVE_CONFIG_H */
+#define PACKAGE_STRING "cueindex"
+#endif /* HAVE_CONFIG_H */
+
+char *progname;
+
+/* Print usage information and exit */
+void usage(int status)
+{
+	if (0 == status) {
+		printf("Usage: %s [option...] -o index [file...]\n", progname);
+		printf("Build a search index of the CD-TEXT, ISRCs and catalog numbers of CUE or TOC\n"
+		       "files, for cuesearch.\n"
+		       "\n"
+		       "OPTIONS\n"
+		       "-h, --help			print usage\n"
+		       "-i, --input-format cue|toc	set format of file(s)\n"
+		       "-o, --output index		write the index to index\n"
+		       "-T, --files-from list		read the names of files from list, one per\n"
+		       "				line (- for standard input)\n"
+		       "--stats				print timing and allocation statistics\n"
+		       "-V, --version			print version information\n");
+	} else {
+		fprintf(stderr, "Try `%s --help' for more information.\n", progname);
+	}
+
+	exit (status);
+}
+
+/* Print version information and exit */
+void version()
+{
+	printf("%s\n", PACKAGE_STRING);
+
+	exit(0);
+}
+
+/*
+ * add a sheet to the index
+ * returns 1 if it could not be parsed, -1 on a fatal error
+ */
+int add(SearchBuilder *b, char *name, int format)
+{
+	Cd *cd = NULL;
+	int ret = 0;
+
+	stats_file_begin(name);
+
+	if (NULL == (cd = cf_parse(name, &format))) {
+		fprintf(stderr, "%s: error: unable to parse input file"
+		        " `%s'\n", progname, name);
+		stats_file_end();
+		return 1;
+	}
+
+	ret = search_builder_add(b, name, cd);
+	cd_delete(cd);
+	stats_file_end();
+
+	return ret;
+}
+
+/* where the sheets of a list go */
+typedef struct Adder Adder;
+struct Adder {
+	SearchBuilder *b;
+	int format;
+};
+
+/* add a file named in a list */
+int add_listed(void *arg, char *name)
+{
+	Adder *adder = arg;
+
+	return add(adder->b, name, adder->format);
+}
+
+int main(int argc, char *argv[])
+{
+	SearchBuilder *b = NULL;
+	Adder adder;
+	char *output = NULL;
+	char *list = NULL;
+	int format = UNKNOWN;
+	int ret = 0;
+	int r;
+	int phase;
+
+	/* option variables */
+	int c;
+	/* getopt_long() variables */
+	extern char *optarg;
+	extern int optind;
+
+	static struct option longopts[] = {
+		{"help", no_argument, NULL, 'h'},
+		{"input-format", required_argument, NULL, 'i'},
+		{"output", required_argument, NULL, 'o'},
+		{"files-from", required_argument, NULL, 'T'},
+		{"stats", no_argument, NULL, 'S'},
+		{"version", no_argument, NULL, 'V'},
+		{NULL, 0, NULL, 0}
+	};
+
+	progname = argv[0];
+
+	while (-1 != (c = getopt_long(argc, argv, "hi:o:T:V", longopts,
+	                              NULL))) {
+		switch (c) {
+		case 'h':
+			usage(0);
+			break;
+		case 'i':
+			if (UNKNOWN == (format = cf_format_from_name(optarg))) {
+				fprintf(stderr, "%s: error: unknown input file"
+				        " format `%s'\n", progname, optarg);
+				usage(1);
+			}
+			break;
+		case 'o':
+			output = optarg;
+			break;
+		case 'T':
+			list = optarg;
+			break;
+		case 'S':
+			stats_enable();
+			break;
+		case 'V':
+			version();
+			break;
+		default:
+			usage(1);
+			break;
+		}
+	}
+
+	if (NULL == output || (NULL == list && optind == argc)) {
+		usage(1);
+	}
+
+	if (NULL == (b = search_builder_new())) {
+		return 1;
+	}
+
+	/* A bad sheet is left out, but is reflected in the exit status. */
+	if (NULL != list) {
+		adder.b = b;
+		adder.format = format;
+		ret = cf_read_list(list, add_listed, &adder);
+	}
+	for (; optind < argc && 0 <= ret; optind++) {
+		if (0 != (r = add(b, argv[optind], format))) {
+			ret = r;
+		}
+	}
+
+	if (0 <= ret) {
+		phase = stats_phase(PHASE_IO);
+		if (0 != search_builder_write(b, output)) {
+			ret = -1;
+		}
+		stats_phase(phase);
+	}
+	search_builder_delete(b);
+
+	if (stats_enabled()) {
+		stats_print(stderr);
+	}
+
+	return (0 == ret) ? 0 : 1;
+}
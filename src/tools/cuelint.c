@@ -0,0 +1,278 @@
+/*
+ * cuelint.c -- check cue or toc files against the Red Book
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#include <getopt.h>	/* getopt_long() */
+#include <stdio.h>	/* fprintf(), printf(), stderr */
+#include <stdlib.h>	/* exit(), atoi(), calloc(), free() */
+#include <string.h>	/* memset(), strcpy() */
+#include <unistd.h>	/* sysconf() */
+#include "cuefile.h"
+#include "lint.h"
+#include "pool.h"
+#include "stats.h"
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#else /* not HAVE_CONFIG_H */
+#define PACKAGE_STRING "cuelint"
+#endif /* HAVE_CONFIG_H */
+
+/* the report of a sheet, once checked */
+typedef struct Sheet Sheet;
+struct Sheet {
+	char *report;		/* lines to print */
+	size_t size;
+	int errors;
+};
+
+/* what the checks share */
+typedef struct Work Work;
+struct Work {
+	CfList list;		/* names of the sheets */
+	int format;
+	int flags;		/* enum LintFlags */
+	int quiet;
+	long errors;
+};
+
+/* where the problems of a sheet go */
+typedef struct Out Out;
+struct Out {
+	FILE *fp;
+	char *name;
+	int errors;
+	int quiet;
+};
+
+char *progname;
+
+/* Print usage information and exit */
+void usage(int status)
+{
+	if (0 == status) {
+		printf("Usage: %s [option...] [file...]\n", progname);
+		printf("Check CUE or TOC files for what will not burn to a Red Book CD: short tracks\n"
+		       "and pregaps, long discs, indexes out of order, bad ISRCs and catalog numbers,\n"
+		       "and data files that do not fit their tracks.  Each problem is printed as\n"
+		       "file, track, severity, check and message, separated by tabs.\n"
+		       "\n"
+		       "OPTIONS\n"
+		       "-h, --help			print usage\n"
+		       "-i, --input-format cue|toc	set format of file(s)\n"
+		       "-T, --files-from list		read the names of files from list, one per\n"
+		       "				line (- for standard input)\n"
+		       "-j, --jobs n			check n files at once (default: one per CPU)\n"
+		       "-s, --sheet-only		do not read the data files\n"
+		       "-q, --quiet			print errors only, not warnings\n"
+		       "--stats				print timing and allocation statistics\n"
+		       "-V, --version			print version information\n");
+	} else {
+		fprintf(stderr, "Try `%s --help' for more information.\n", progname);
+	}
+
+	exit (status);
+}
+
+/* Print version information and exit */
+void version()
+{
+	printf("%s\n", PACKAGE_STRING);
+
+	exit(0);
+}
+
+void print_issue(void *arg, const LintIssue *issue)
+{
+	Out *out = arg;
+
+	if (LINT_ERROR == issue->severity) {
+		out->errors++;
+	} else if (out->quiet) {
+		return;
+	}
+	fprintf(out->fp, "%s\t%d\t%s\t%s\t%s\n", out->name, issue->trackno,
+	        lint_severity_name(issue->severity), issue->check,
+	        issue->text);
+}
+
+/*
+ * check a sheet, printing its problems to fp
+ * returns the number of errors
+ */
+int check(FILE *fp, char *name, int format, int flags, int quiet)
+{
+	LintIssue issue;
+	Out out;
+	Cd *cd = NULL;
+
+	out.fp = fp;
+	out.name = name;
+	out.errors = 0;
+	out.quiet = quiet;
+
+	if (NULL == (cd = cf_parse(name, &format))) {
+		issue.severity = LINT_ERROR;
+		issue.check = "parse";
+		issue.trackno = 0;
+		strcpy(issue.text, "unable to parse input file");
+		print_issue(&out, &issue);
+		return out.errors;
+	}
+
+	lint_cd(cd, name, flags, print_issue, &out);
+	cd_delete(cd);
+
+	return out.errors;
+}
+
+/* check sheet i into a report in memory, to print in order */
+void *checker(void *arg, long i)
+{
+	Work *work = arg;
+	Sheet *sheet = NULL;
+	FILE *fp = NULL;
+
+	if (NULL == (sheet = calloc(1, sizeof(Sheet)))) {
+		fprintf(stderr, "unable to allocate memory\n");
+		return NULL;
+	}
+
+	stats_file_begin(work->list.name[i]);
+	if (NULL == (fp = open_memstream(&sheet->report, &sheet->size))) {
+		fprintf(stderr, "unable to allocate memory\n");
+		sheet->errors = 1;
+	} else {
+		sheet->errors = check(fp, work->list.name[i], work->format,
+		                      work->flags, work->quiet);
+		fclose(fp);
+	}
+	stats_file_end();
+
+	return sheet;
+}
+
+/* print the report of a sheet */
+int printer(void *arg, long i, void *result)
+{
+	Work *work = arg;
+	Sheet *sheet = result;
+
+	(void) i;
+	if (NULL == sheet) {
+		work->errors++;
+		return 0;
+	}
+	if (0 < sheet->size) {
+		fwrite(sheet->report, 1, sheet->size, stdout);
+	}
+	work->errors += sheet->errors;
+	free(sheet->report);
+	free(sheet);
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	Work work;
+	char *list = NULL;
+	int njobs = sysconf(_SC_NPROCESSORS_ONLN);
+
+	/* option variables */
+	int c;
+	/* getopt_long() variables */
+	extern char *optarg;
+	extern int optind;
+
+	static struct option longopts[] = {
+		{"help", no_argument, NULL, 'h'},
+		{"input-format", required_argument, NULL, 'i'},
+		{"files-from", required_argument, NULL, 'T'},
+		{"jobs", required_argument, NULL, 'j'},
+		{"sheet-only", no_argument, NULL, 's'},
+		{"quiet", no_argument, NULL, 'q'},
+		{"stats", no_argument, NULL, 'S'},
+		{"version", no_argument, NULL, 'V'},
+		{NULL, 0, NULL, 0}
+	};
+
+	progname = argv[0];
+	memset(&work, 0, sizeof(work));
+	work.format = UNKNOWN;
+	work.flags = LINT_FILES;
+
+	while (-1 != (c = getopt_long(argc, argv, "hi:T:j:sqV", longopts,
+	                              NULL))) {
+		switch (c) {
+		case 'h':
+			usage(0);
+			break;
+		case 'i':
+			if (UNKNOWN == (work.format = cf_format_from_name(optarg))) {
+				fprintf(stderr, "%s: error: unknown input file"
+				        " format `%s'\n", progname, optarg);
+				usage(2);
+			}
+			break;
+		case 'T':
+			list = optarg;
+			break;
+		case 'j':
+			if (0 >= (njobs = atoi(optarg))) {
+				fprintf(stderr, "%s: error: jobs must be"
+				        " positive\n", progname);
+				usage(2);
+			}
+			break;
+		case 's':
+			work.flags = LINT_SHEET;
+			break;
+		case 'q':
+			work.quiet = 1;
+			break;
+		case 'S':
+			stats_enable();
+			break;
+		case 'V':
+			version();
+			break;
+		default:
+			usage(2);
+			break;
+		}
+	}
+
+	if (NULL == list && optind == argc) {
+		usage(2);
+	}
+	if (0 >= njobs) {
+		njobs = 1;
+	}
+	/* only this thread is timed */
+	if (stats_enabled()) {
+		njobs = 0;
+	}
+
+	if (NULL != list
+	    && 0 != cf_read_list(list, cf_list_add, &work.list)) {
+		return 2;
+	}
+	for (; optind < argc; optind++) {
+		if (0 != cf_list_add(&work.list, argv[optind])) {
+			return 2;
+		}
+	}
+
+	pool_run(work.list.n, njobs, checker, printer, NULL, &work);
+	cf_list_free(&work.list);
+
+	if (stats_enabled()) {
+		stats_print(stderr);
+	}
+
+	return (0 == work.errors) ? 0 : 1;
+}
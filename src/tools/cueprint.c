@@ -11,6 +11,7 @@
 #include <stdlib.h>	/* exit() */
 #include <string.h>	/* strcasecmp() */
 #include "cuefile.h"
+#include "stats.h"
 
 #if HAVE_CONFIG_H
 #include "config.h"
@@ -66,14 +67,17 @@ void usage(int status)
 {
 	if (0 == status) {
 		printf("Usage: %s [option...] [file...]\n", progname);
-		printf("Report disc and track information from a CUE or TOC file.\n"
+		printf("Report disc and track information from a CUE or TOC file, or the cue\n"
+		       "sheet embedded in a FLAC file or APEv2 tag.\n"
 		       "\n"
 		       "OPTIONS\n"
 		       "-h, --help			print usage\n"
-		       "-i, --input-format cue|toc	set format of file(s)\n"
+		       "-i, --input-format cue|toc|flac|ape\n"
+		       "				set format of file(s)\n"
 		       "-n, --track-number <number>	only print track information for single track\n"
 		       "-d, --disc-template <template>	set disc template\n"
 		       "-t, --track-template <template>	set track template\n"
+		       "--stats				print timing and allocation statistics\n"
 		       "-V, --version			print version information\n"
 		       "\n"
 		       "Default disc template: %s\n"
@@ -235,6 +239,7 @@ void print_conv(char *start, int length, Cd *cd, int trackno)
 	char *conv;	/* copy of conversion specification */
 	Value value;
 	char *c;	/* pointer to conversion-char */
+	int n;		/* number of characters printed */
 
 	/* TODO: use strndup? */
 	conv = malloc((unsigned) (length + 1));
@@ -252,22 +257,23 @@ void print_conv(char *start, int length, Cd *cd, int trackno)
 
 	switch (*c) {
 	case 'c':
-		printf(conv, value.cval);
+		n = printf(conv, value.cval);
 		break;
 	case 'd':
-		printf(conv, value.ival);
+		n = printf(conv, value.ival);
 		break;
 	case 's':
 		if (NULL == value.sval)
-			printf(conv, VALUE_UNSET);
+			n = printf(conv, VALUE_UNSET);
 		else
-			printf(conv, value.sval);
+			n = printf(conv, value.sval);
 		break;
 	default:
-		printf("%zu: ", strlen(conv));
-		printf("%s", conv);
+		n = printf("%zu: ", strlen(conv));
+		n += printf("%s", conv);
 	}
 
+	stats_count(STATS_BYTES_WRITTEN, n);
 	free(conv);
 }
 
@@ -323,6 +329,7 @@ void cd_printf(char *format, Cd *cd, int trackno)
 			print_conv(conv_start, conv_length, cd, trackno);
 		} else {
 			putchar(*c);
+			stats_count(STATS_BYTES_WRITTEN, 1);
 		}
 	}
 }
@@ -331,14 +338,20 @@ int info(char *name, int format, int trackno, char *d_template, char *t_template
 {
 	Cd *cd = NULL;
 	int ntrack;
+	int phase;
+	int ret = 0;
+
+	stats_file_begin(name);
 
 	if (NULL == (cd = cf_parse(name, &format))) {
 		fprintf(stderr, "%s: error: unable to parse input file"
 		        " `%s'\n", progname, name);
+		stats_file_end();
 		return -1;
 	}
 
 	ntrack = cd_get_ntrack(cd);
+	phase = stats_phase(PHASE_PRINT);
 
 	if (-1 == trackno) {
 		cd_printf(d_template, cd, 0);
@@ -352,10 +365,14 @@ int info(char *name, int format, int trackno, char *d_template, char *t_template
 		cd_printf(t_template, cd, trackno);
 	} else {
 		fprintf(stderr, "%s: error: track number out of range\n", progname);
-		return -1;
+		ret = -1;
 	}
 
-	return 0;
+	stats_phase(phase);
+	cd_delete(cd);
+	stats_file_end();
+
+	return ret;
 }
 
 /* 
@@ -438,6 +455,7 @@ int main(int argc, char *argv[])
 		{"track-number", required_argument, NULL, 'n'},
 		{"disc-template", required_argument, NULL, 'd'},
 		{"track-template", required_argument, NULL, 't'},
+		{"stats", no_argument, NULL, 'S'},
 		{"version", no_argument, NULL, 'V'},
 		{NULL, 0, NULL, 0}
 	};
@@ -450,11 +468,7 @@ int main(int argc, char *argv[])
 			usage(0);
 			break;
 		case 'i':
-			if (0 == strcmp("cue", optarg)) {
-				format = CUE;
-			} else if (0 == strcmp("toc", optarg)) {
-				format = TOC;
-			} else {
+			if (UNKNOWN == (format = cf_format_from_name(optarg))) {
 				fprintf(stderr, "%s: error: unknown input file"
 				        " format `%s'\n", progname, optarg);
 				usage(1);
@@ -469,6 +483,9 @@ int main(int argc, char *argv[])
 		case 't':
 			t_template = optarg;
 			break;
+		case 'S':
+			stats_enable();
+			break;
 		case 'V':
 			version();
 			break;
@@ -506,11 +523,15 @@ int main(int argc, char *argv[])
 		for (; optind < argc; optind++) {
 			ret = info(argv[optind], format, trackno, d_template, t_template);
 			/* Exit if info() returns nonzero. */
-			if (!ret) {
+			if (0 != ret) {
 				break;
 			}
 		}
 	}
 
+	if (stats_enabled()) {
+		stats_print(stderr);
+	}
+
 	return ret;
 }
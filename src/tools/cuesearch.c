@@ -0,0 +1,157 @@
+/*
+ * cuesearch.c -- find discs and tracks in a search index of cue or toc
+ * files
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#include <getopt.h>	/* getopt_long() */
+#include <stdio.h>	/* fprintf(), printf(), stderr */
+#include <stdlib.h>	/* exit(), free() */
+#include "search.h"
+#include "stats.h"
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#else /* not HAVE_CONFIG_H */
+#define PACKAGE_STRING "cuesearch"
+#endif /* HAVE_CONFIG_H */
+
+char *progname;
+
+/* Print usage information and exit */
+void usage(int status)
+{
+	if (0 == status) {
+		printf("Usage: %s [option...] index word...\n", progname);
+		printf("Print the discs and tracks in a search index made by cueindex that match all\n"
+		       "words.  Words joined by OR match if either does.  A word may be prefixed by\n"
+		       "a field, as in performer:beatles, and end in * to match a prefix.\n"
+		       "\n"
+		       "OPTIONS\n"
+		       "-h, --help			print usage\n"
+		       "-c, --count			print only the number of matches\n"
+		       "-d, --discs			print only the discs\n"
+		       "-t, --tracks			print only the tracks\n"
+		       "--stats				print timing and allocation statistics\n"
+		       "-V, --version			print version information\n");
+	} else {
+		fprintf(stderr, "Try `%s --help' for more information.\n", progname);
+	}
+
+	exit (status);
+}
+
+/* Print version information and exit */
+void version()
+{
+	printf("%s\n", PACKAGE_STRING);
+
+	exit(0);
+}
+
+int main(int argc, char *argv[])
+{
+	Search *s = NULL;
+	SearchDoc doc;
+	uint32_t *docs = NULL;
+	long ndoc;
+	long count = 0;
+	int count_only = 0;
+	int discs = 1;
+	int tracks = 1;
+	int phase;
+	long i;
+
+	/* option variables */
+	int c;
+	/* getopt_long() variables */
+	extern char *optarg;
+	extern int optind;
+
+	static struct option longopts[] = {
+		{"help", no_argument, NULL, 'h'},
+		{"count", no_argument, NULL, 'c'},
+		{"discs", no_argument, NULL, 'd'},
+		{"tracks", no_argument, NULL, 't'},
+		{"stats", no_argument, NULL, 'S'},
+		{"version", no_argument, NULL, 'V'},
+		{NULL, 0, NULL, 0}
+	};
+
+	progname = argv[0];
+
+	/* "+" stops at the first word, so that a word may start with - */
+	while (-1 != (c = getopt_long(argc, argv, "+hcdtV", longopts,
+	                              NULL))) {
+		switch (c) {
+		case 'h':
+			usage(0);
+			break;
+		case 'c':
+			count_only = 1;
+			break;
+		case 'd':
+			tracks = 0;
+			discs = 1;
+			break;
+		case 't':
+			discs = 0;
+			tracks = 1;
+			break;
+		case 'S':
+			stats_enable();
+			break;
+		case 'V':
+			version();
+			break;
+		default:
+			usage(2);
+			break;
+		}
+	}
+
+	if (2 > argc - optind) {
+		usage(2);
+	}
+
+	phase = stats_phase(PHASE_IO);
+	s = search_open(argv[optind]);
+	stats_phase(phase);
+	if (NULL == s) {
+		return 2;
+	}
+
+	if (0 > (ndoc = search_query(s, argc - optind - 1, argv + optind + 1,
+	                             &docs))) {
+		search_close(s);
+		return 2;
+	}
+
+	phase = stats_phase(PHASE_PRINT);
+	for (i = 0; i < ndoc; i++) {
+		if (0 != search_doc(s, docs[i], &doc)
+		    || ((0 == doc.trackno) ? !discs : !tracks)) {
+			continue;
+		}
+		count++;
+		if (!count_only) {
+			printf("%s\t%d\n", doc.sheet, doc.trackno);
+		}
+	}
+	if (count_only) {
+		printf("%ld\n", count);
+	}
+	stats_phase(phase);
+
+	free(docs);
+	search_close(s);
+
+	if (stats_enabled()) {
+		stats_print(stderr);
+	}
+
+	/* as for grep(1) */
+	return (0 < count) ? 0 : 1;
+}
@@ -0,0 +1,561 @@
+/*
+ * cuesqlite.c -- export cue or toc files to an SQLite database
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#include <getopt.h>	/* getopt_long() */
+#include <stdio.h>	/* fprintf(), printf(), stderr */
+#include <stdlib.h>	/* exit(), atoi(), atol(), malloc(), free() */
+#include <string.h>	/* memset() */
+#include <unistd.h>	/* sysconf() */
+#include <sqlite3.h>
+#include "cuefile.h"
+#include "pool.h"
+#include "stats.h"
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#else /* not HAVE_CONFIG_H */
+#define PACKAGE_STRING "cuesqlite"
+#endif /* HAVE_CONFIG_H */
+
+#define BATCH		100000	/* rows in a transaction */
+
+static const char *schema =
+	"CREATE TABLE IF NOT EXISTS disc ("
+	" id INTEGER PRIMARY KEY,"
+	" path TEXT NOT NULL UNIQUE,"
+	" format TEXT,"
+	" mode TEXT,"
+	" catalog TEXT,"
+	" ntrack INTEGER);"
+	"CREATE TABLE IF NOT EXISTS track ("
+	" id INTEGER PRIMARY KEY,"
+	" disc INTEGER NOT NULL REFERENCES disc(id),"
+	" trackno INTEGER NOT NULL,"
+	" mode TEXT,"
+	" flags INTEGER,"
+	" isrc TEXT,"
+	" file TEXT,"
+	" filetype TEXT,"
+	" start INTEGER,"
+	" length INTEGER,"
+	" pregap INTEGER,"
+	" postgap INTEGER,"
+	" UNIQUE (disc, trackno));"
+	"CREATE TABLE IF NOT EXISTS track_index ("
+	" track INTEGER NOT NULL REFERENCES track(id),"
+	" number INTEGER NOT NULL,"
+	" frame INTEGER,"
+	" PRIMARY KEY (track, number));"
+	"CREATE TABLE IF NOT EXISTS cdtext ("
+	" disc INTEGER NOT NULL REFERENCES disc(id),"
+	" trackno INTEGER NOT NULL,"
+	" field TEXT NOT NULL,"
+	" value TEXT,"
+	" PRIMARY KEY (disc, trackno, field));";
+
+/* the statements of the writer, in the order of sql[] */
+enum Stmt {
+	FIND_DISC,
+	DELETE_INDEXES,
+	DELETE_CDTEXT,
+	DELETE_TRACKS,
+	DELETE_DISC,
+	INSERT_DISC,
+	INSERT_TRACK,
+	INSERT_INDEX,
+	INSERT_CDTEXT,
+	NSTMT
+};
+
+static const char *sql[NSTMT] = {
+	"SELECT id FROM disc WHERE path = ?",
+	"DELETE FROM track_index WHERE track IN"
+	" (SELECT id FROM track WHERE disc = ?)",
+	"DELETE FROM cdtext WHERE disc = ?",
+	"DELETE FROM track WHERE disc = ?",
+	"DELETE FROM disc WHERE id = ?",
+	"INSERT INTO disc (path, format, mode, catalog, ntrack)"
+	" VALUES (?, ?, ?, ?, ?)",
+	"INSERT INTO track (disc, trackno, mode, flags, isrc, file, filetype,"
+	" start, length, pregap, postgap)"
+	" VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)",
+	"INSERT INTO track_index (track, number, frame) VALUES (?, ?, ?)",
+	"INSERT INTO cdtext (disc, trackno, field, value) VALUES (?, ?, ?, ?)"
+};
+
+static const char *disc_modes[] = {"CD_DA", "CD_ROM", "CD_ROM_XA"};
+static const char *track_modes[] = {
+	"AUDIO", "MODE1", "MODE1_RAW", "MODE2", "MODE2_FORM1",
+	"MODE2_FORM2", "MODE2_FORM_MIX", "MODE2_RAW"
+};
+static const char *filetypes[] = {
+	NULL, "BINARY", "MOTOROLA", "AIFF", "WAVE", "MP3"
+};
+
+/* a sheet, once parsed */
+typedef struct Sheet Sheet;
+struct Sheet {
+	Cd *cd;			/* NULL if it could not be parsed */
+	int format;
+};
+
+/* the database and its statements */
+typedef struct Db Db;
+struct Db {
+	sqlite3 *db;
+	sqlite3_stmt *stmt[NSTMT];
+	long batch;		/* rows in a transaction, rounded up to a sheet */
+	long rows;		/* in this transaction */
+	long total;
+};
+
+/* what the parser threads and the writer share */
+typedef struct Work Work;
+struct Work {
+	CfList list;		/* names of the sheets */
+	int format;
+	Db *db;
+	int failed;		/* a sheet could not be parsed */
+};
+
+char *progname;
+
+/* Print usage information and exit */
+void usage(int status)
+{
+	if (0 == status) {
+		printf("Usage: %s [option...] database [file...]\n", progname);
+		printf("Export the discs, tracks, indexes and CD-TEXT of CUE or TOC files to an\n"
+		       "SQLite database.\n"
+		       "\n"
+		       "OPTIONS\n"
+		       "-h, --help			print usage\n"
+		       "-i, --input-format cue|toc	set format of file(s)\n"
+		       "-T, --files-from list		read the names of files from list, one per\n"
+		       "				line (- for standard input)\n"
+		       "-j, --jobs n			parse n files at once (default: one per CPU)\n"
+		       "-b, --batch n			write n rows per transaction (default 100000)\n"
+		       "--stats				print timing and allocation statistics\n"
+		       "-V, --version			print version information\n");
+	} else {
+		fprintf(stderr, "Try `%s --help' for more information.\n", progname);
+	}
+
+	exit (status);
+}
+
+/* Print version information and exit */
+void version()
+{
+	printf("%s\n", PACKAGE_STRING);
+
+	exit(0);
+}
+
+/* parse sheet i */
+void *parser(void *arg, long i)
+{
+	Work *work = arg;
+	Sheet *sheet = NULL;
+
+	if (NULL == (sheet = malloc(sizeof(Sheet)))) {
+		fprintf(stderr, "unable to allocate memory\n");
+		return NULL;
+	}
+
+	stats_file_begin(work->list.name[i]);
+	sheet->format = work->format;
+	if (NULL == (sheet->cd = cf_parse(work->list.name[i],
+	                                  &sheet->format))) {
+		fprintf(stderr, "%s: error: unable to parse input file"
+		        " `%s'\n", progname, work->list.name[i]);
+	}
+	stats_file_end();
+
+	return sheet;
+}
+
+int db_error(Db *db, const char *what)
+{
+	fprintf(stderr, "%s: error: %s: %s\n", progname, what,
+	        sqlite3_errmsg(db->db));
+
+	return -1;
+}
+
+int db_exec(Db *db, const char *s)
+{
+	char *msg = NULL;
+
+	if (SQLITE_OK != sqlite3_exec(db->db, s, NULL, NULL, &msg)) {
+		fprintf(stderr, "%s: error: %s\n", progname, msg);
+		sqlite3_free(msg);
+		return -1;
+	}
+
+	return 0;
+}
+
+int db_open(Db *db, char *name, long batch)
+{
+	int i;
+
+	memset(db, 0, sizeof(Db));
+	db->batch = batch;
+
+	if (SQLITE_OK != sqlite3_open(name, &db->db)) {
+		return db_error(db, name);
+	}
+	if (0 != db_exec(db, "PRAGMA journal_mode = WAL;"
+	                     "PRAGMA synchronous = NORMAL;")
+	    || 0 != db_exec(db, schema)) {
+		return -1;
+	}
+	for (i = 0; i < NSTMT; i++) {
+		if (SQLITE_OK != sqlite3_prepare_v2(db->db, sql[i], -1,
+		                                    &db->stmt[i], NULL)) {
+			return db_error(db, sql[i]);
+		}
+	}
+
+	return db_exec(db, "BEGIN");
+}
+
+/* commit and close; returns -1 if the last transaction failed */
+int db_close(Db *db, int commit)
+{
+	int ret = 0;
+	int i;
+
+	if (commit) {
+		ret = db_exec(db, "COMMIT");
+	}
+	for (i = 0; i < NSTMT; i++) {
+		sqlite3_finalize(db->stmt[i]);
+	}
+	sqlite3_close(db->db);
+
+	return ret;
+}
+
+/* bind text, or NULL */
+void bind_text(sqlite3_stmt *stmt, int i, const char *s)
+{
+	if (NULL == s) {
+		sqlite3_bind_null(stmt, i);
+	} else {
+		sqlite3_bind_text(stmt, i, s, -1, SQLITE_STATIC);
+	}
+}
+
+/*
+ * run a bound statement that returns no rows, counting a row written
+ * (see db_batch())
+ */
+int db_step(Db *db, int i)
+{
+	sqlite3_stmt *stmt = db->stmt[i];
+	int rc = sqlite3_step(stmt);
+
+	sqlite3_reset(stmt);
+	sqlite3_clear_bindings(stmt);
+	if (SQLITE_DONE != rc) {
+		return db_error(db, sql[i]);
+	}
+
+	db->rows++;
+	db->total++;
+
+	return 0;
+}
+
+/* commit once a batch of rows is written; only between sheets */
+int db_batch(Db *db)
+{
+	if (db->rows < db->batch) {
+		return 0;
+	}
+	db->rows = 0;
+
+	return (0 == db_exec(db, "COMMIT")) ? db_exec(db, "BEGIN") : -1;
+}
+
+/* remove an earlier export of path */
+int db_forget(Db *db, char *path)
+{
+	sqlite3_stmt *stmt = db->stmt[FIND_DISC];
+	sqlite3_int64 id;
+	int rc;
+	int i;
+
+	bind_text(stmt, 1, path);
+	rc = sqlite3_step(stmt);
+	id = (SQLITE_ROW == rc) ? sqlite3_column_int64(stmt, 0) : 0;
+	sqlite3_reset(stmt);
+	if (SQLITE_ROW != rc) {
+		return (SQLITE_DONE == rc) ? 0 : db_error(db, sql[FIND_DISC]);
+	}
+
+	for (i = DELETE_INDEXES; i <= DELETE_DISC; i++) {
+		sqlite3_bind_int64(db->stmt[i], 1, id);
+		if (0 != db_step(db, i)) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+int db_cdtext(Db *db, sqlite3_int64 disc, int trackno, Cdtext *cdtext)
+{
+	sqlite3_stmt *stmt = db->stmt[INSERT_CDTEXT];
+	char *value = NULL;
+	int pti;
+
+	for (pti = 0; pti < PTI_END; pti++) {
+		if (NULL == (value = cdtext_get(pti, cdtext))) {
+			continue;
+		}
+		sqlite3_bind_int64(stmt, 1, disc);
+		sqlite3_bind_int(stmt, 2, trackno);
+		bind_text(stmt, 3, cdtext_get_key(pti, 0 != trackno));
+		bind_text(stmt, 4, value);
+		if (0 != db_step(db, INSERT_CDTEXT)) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+int db_track(Db *db, sqlite3_int64 disc, int trackno, Track *track)
+{
+	sqlite3_stmt *stmt = db->stmt[INSERT_TRACK];
+	sqlite3_int64 id;
+	int i;
+
+	sqlite3_bind_int64(stmt, 1, disc);
+	sqlite3_bind_int(stmt, 2, trackno);
+	bind_text(stmt, 3, track_modes[track_get_mode(track)]);
+	sqlite3_bind_int(stmt, 4, track_is_set_flag(track, FLAG_ANY));
+	bind_text(stmt, 5, track_get_isrc(track));
+	bind_text(stmt, 6, track_get_filename(track));
+	bind_text(stmt, 7, filetypes[track_get_filetype(track)]);
+	sqlite3_bind_int64(stmt, 8, track_get_start(track));
+	if (0 < track_get_length(track)) {
+		sqlite3_bind_int64(stmt, 9, track_get_length(track));
+	}
+	sqlite3_bind_int64(stmt, 10, track_get_zero_pre(track));
+	sqlite3_bind_int64(stmt, 11, track_get_zero_post(track));
+	if (0 != db_step(db, INSERT_TRACK)) {
+		return -1;
+	}
+	id = sqlite3_last_insert_rowid(db->db);
+
+	stmt = db->stmt[INSERT_INDEX];
+	for (i = 0; i < track_get_nindex(track); i++) {
+		sqlite3_bind_int64(stmt, 1, id);
+		sqlite3_bind_int(stmt, 2, i);
+		sqlite3_bind_int64(stmt, 3, track_get_index(track, i));
+		if (0 != db_step(db, INSERT_INDEX)) {
+			return -1;
+		}
+	}
+
+	return db_cdtext(db, disc, trackno, track_get_cdtext(track));
+}
+
+int db_sheet(Db *db, char *path, int format, Cd *cd)
+{
+	sqlite3_stmt *stmt = db->stmt[INSERT_DISC];
+	sqlite3_int64 id;
+	int i;
+
+	if (0 != db_forget(db, path)) {
+		return -1;
+	}
+
+	bind_text(stmt, 1, path);
+	bind_text(stmt, 2, cf_get_format(format)->name);
+	bind_text(stmt, 3, disc_modes[cd_get_mode(cd)]);
+	bind_text(stmt, 4, cd_get_catalog(cd));
+	sqlite3_bind_int(stmt, 5, cd_get_ntrack(cd));
+	if (0 != db_step(db, INSERT_DISC)) {
+		return -1;
+	}
+	id = sqlite3_last_insert_rowid(db->db);
+
+	if (0 != db_cdtext(db, id, 0, cd_get_cdtext(cd))) {
+		return -1;
+	}
+	for (i = 1; i <= cd_get_ntrack(cd); i++) {
+		if (0 != db_track(db, id, i, cd_get_track(cd, i))) {
+			return -1;
+		}
+	}
+
+	return db_batch(db);
+}
+
+/* write a sheet, in order; -1 on a database error */
+int writer(void *arg, long i, void *result)
+{
+	Work *work = arg;
+	Sheet *sheet = result;
+	int ret = 0;
+
+	if (NULL == sheet || NULL == sheet->cd) {
+		work->failed = 1;
+		free(sheet);
+		return 0;
+	}
+	if (0 != db_sheet(work->db, work->list.name[i], sheet->format,
+	                  sheet->cd)) {
+		ret = -1;
+	}
+	cd_delete(sheet->cd);
+	free(sheet);
+
+	return ret;
+}
+
+/* free a sheet not written */
+void drop(void *arg, void *result)
+{
+	Sheet *sheet = result;
+
+	(void) arg;
+	if (NULL != sheet) {
+		cd_delete(sheet->cd);
+		free(sheet);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	Work work;
+	Db db;
+	char *list = NULL;
+	long batch = BATCH;
+	int njobs = sysconf(_SC_NPROCESSORS_ONLN);
+	int phase;
+	int ret = 0;
+	int i;
+
+	/* option variables */
+	int c;
+	/* getopt_long() variables */
+	extern char *optarg;
+	extern int optind;
+
+	static struct option longopts[] = {
+		{"help", no_argument, NULL, 'h'},
+		{"input-format", required_argument, NULL, 'i'},
+		{"files-from", required_argument, NULL, 'T'},
+		{"jobs", required_argument, NULL, 'j'},
+		{"batch", required_argument, NULL, 'b'},
+		{"stats", no_argument, NULL, 'S'},
+		{"version", no_argument, NULL, 'V'},
+		{NULL, 0, NULL, 0}
+	};
+
+	progname = argv[0];
+	memset(&work, 0, sizeof(work));
+	work.format = UNKNOWN;
+
+	while (-1 != (c = getopt_long(argc, argv, "hi:T:j:b:V", longopts,
+	                              NULL))) {
+		switch (c) {
+		case 'h':
+			usage(0);
+			break;
+		case 'i':
+			if (UNKNOWN == (work.format = cf_format_from_name(optarg))) {
+				fprintf(stderr, "%s: error: unknown input file"
+				        " format `%s'\n", progname, optarg);
+				usage(1);
+			}
+			break;
+		case 'T':
+			list = optarg;
+			break;
+		case 'j':
+			if (0 >= (njobs = atoi(optarg))) {
+				fprintf(stderr, "%s: error: jobs must be"
+				        " positive\n", progname);
+				usage(1);
+			}
+			break;
+		case 'b':
+			if (0 >= (batch = atol(optarg))) {
+				fprintf(stderr, "%s: error: batch must be"
+				        " positive\n", progname);
+				usage(1);
+			}
+			break;
+		case 'S':
+			stats_enable();
+			break;
+		case 'V':
+			version();
+			break;
+		default:
+			usage(1);
+			break;
+		}
+	}
+
+	if (optind == argc) {
+		usage(1);
+	}
+	if (0 >= njobs) {
+		njobs = 1;
+	}
+	/* only this thread is timed */
+	if (stats_enabled()) {
+		njobs = 0;
+	}
+
+	if (NULL != list
+	    && 0 != cf_read_list(list, cf_list_add, &work.list)) {
+		return 1;
+	}
+	for (i = optind + 1; i < argc; i++) {
+		if (0 != cf_list_add(&work.list, argv[i])) {
+			return 1;
+		}
+	}
+
+	phase = stats_phase(PHASE_IO);
+	if (0 != db_open(&db, argv[optind], batch)) {
+		db_close(&db, 0);
+		return 1;
+	}
+	stats_phase(phase);
+
+	work.db = &db;
+	if (0 != pool_run(work.list.n, njobs, parser, writer, drop, &work)) {
+		ret = -1;
+	} else if (work.failed) {
+		ret = 1;
+	}
+
+	phase = stats_phase(PHASE_IO);
+	if (0 != db_close(&db, 0 <= ret)) {
+		ret = -1;
+	}
+	stats_phase(phase);
+
+	cf_list_free(&work.list);
+
+	if (stats_enabled()) {
+		fprintf(stderr, "%ld rows\n", db.total);
+		stats_print(stderr);
+	}
+
+	return (0 == ret) ? 0 : 1;
+}
@@ -0,0 +1,233 @@
+/*
+ * cuesub.c -- write the P and Q sub-channel of cue or toc files
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#include <getopt.h>	/* getopt_long() */
+#include <stdio.h>	/* fprintf(), printf(), fopen(), stderr */
+#include <stdlib.h>	/* exit() */
+#include <string.h>	/* strcmp(), strrchr() */
+#include "cuefile.h"
+#include "stats.h"
+#include "sub.h"
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#else /* not HAVE_CONFIG_H */
+#define PACKAGE_STRING "cuesub"
+#endif /* HAVE_CONFIG_H */
+
+char *progname;
+
+/* Print usage information and exit */
+void usage(int status)
+{
+	if (0 == status) {
+		printf("Usage: %s [option...] file...\n", progname);
+		printf("Write the P and Q sub-channel of the disc of each CUE or TOC file to a\n"
+		       "sub-channel file (.sub) beside it, 96 bytes per sector.\n"
+		       "\n"
+		       "OPTIONS\n"
+		       "-h, --help			print usage\n"
+		       "-i, --input-format cue|toc	set format of file(s)\n"
+		       "-o, --output file		write to file (- for standard output); one\n"
+		       "				input file only\n"
+		       "-r, --interleaved		interleave the channels, as read raw from a\n"
+		       "				drive (default: each channel in turn)\n"
+		       "-T, --files-from list		read the names of files from list, one per\n"
+		       "				line (- for standard input)\n"
+		       "--stats				print timing and allocation statistics\n"
+		       "-V, --version			print version information\n");
+	} else {
+		fprintf(stderr, "Try `%s --help' for more information.\n", progname);
+	}
+
+	exit (status);
+}
+
+/* Print version information and exit */
+void version()
+{
+	printf("%s\n", PACKAGE_STRING);
+
+	exit(0);
+}
+
+/* name with its suffix, if any, replaced by .sub */
+void sub_name(char *out, size_t size, char *name)
+{
+	char *dot = strrchr(name, '.');
+	char *slash = strrchr(name, '/');
+
+	if (NULL == dot || (NULL != slash && dot < slash)) {
+		snprintf(out, size, "%s.sub", name);
+	} else {
+		snprintf(out, size, "%.*s.sub", (int) (dot - name), name);
+	}
+}
+
+/* write the sub-channel of a sheet to out, or beside it; -1 on error */
+int write_sub(char *name, char *out, int format, int subformat)
+{
+	Cd *cd = NULL;
+	FILE *fp = NULL;
+	SubGen gen;
+	char path[4096];
+	int ret = 0;
+
+	stats_file_begin(name);
+
+	if (NULL == (cd = cf_parse(name, &format))) {
+		fprintf(stderr, "%s: error: unable to parse input file"
+		        " `%s'\n", progname, name);
+		stats_file_end();
+		return -1;
+	}
+
+	/*
+	 * the length of each track must be known to lay out the disc; a file
+	 * that can not be probed matters only if its length is unknown, so
+	 * the layout cf_set_lengths() leaves is checked, before the output is
+	 * opened
+	 */
+	cf_set_lengths(cd, name);
+	if (0 != sub_init(&gen, cd)) {
+		fprintf(stderr, "%s: error: unable to lay out `%s'\n",
+		        progname, name);
+		cd_delete(cd);
+		stats_file_end();
+		return -1;
+	}
+
+	if (NULL == out) {
+		sub_name(path, sizeof(path), name);
+		out = path;
+	}
+	if (0 == strcmp("-", out)) {
+		fp = stdout;
+	} else if (NULL == (fp = fopen(out, "wb"))) {
+		fprintf(stderr, "%s: error: unable to open `%s'\n", progname,
+		        out);
+		cd_delete(cd);
+		stats_file_end();
+		return -1;
+	}
+
+	if (0 != sub_write(cd, fp, subformat)) {
+		ret = -1;
+	}
+	if (stdout != fp && 0 != fclose(fp)) {
+		ret = -1;
+	}
+	if (0 != ret) {
+		fprintf(stderr, "%s: error: unable to write `%s'\n", progname,
+		        out);
+	}
+
+	cd_delete(cd);
+	stats_file_end();
+
+	return ret;
+}
+
+/* the formats of the files of a list */
+typedef struct Listed Listed;
+struct Listed {
+	int format;
+	int subformat;
+};
+
+/* write beside a file named in a list; a bad one does not stop it */
+int each_listed(void *arg, char *name)
+{
+	Listed *l = arg;
+
+	return (0 == write_sub(name, NULL, l->format, l->subformat)) ? 0 : 1;
+}
+
+int main(int argc, char *argv[])
+{
+	Listed listed;
+	int format = UNKNOWN;
+	int subformat = SUB_PACKED;
+	char *output = NULL;
+	char *list = NULL;
+	int ret = 0;
+
+	/* option variables */
+	int c;
+	/* getopt_long() variables */
+	extern char *optarg;
+	extern int optind;
+
+	static struct option longopts[] = {
+		{"help", no_argument, NULL, 'h'},
+		{"input-format", required_argument, NULL, 'i'},
+		{"output", required_argument, NULL, 'o'},
+		{"interleaved", no_argument, NULL, 'r'},
+		{"files-from", required_argument, NULL, 'T'},
+		{"stats", no_argument, NULL, 'S'},
+		{"version", no_argument, NULL, 'V'},
+		{NULL, 0, NULL, 0}
+	};
+
+	progname = argv[0];
+
+	while (-1 != (c = getopt_long(argc, argv, "hi:o:rT:V", longopts,
+	                              NULL))) {
+		switch (c) {
+		case 'h':
+			usage(0);
+			break;
+		case 'i':
+			if (UNKNOWN == (format = cf_format_from_name(optarg))) {
+				fprintf(stderr, "%s: error: unknown input file"
+				        " format `%s'\n", progname, optarg);
+				usage(1);
+			}
+			break;
+		case 'o':
+			output = optarg;
+			break;
+		case 'r':
+			subformat = SUB_INTERLEAVED;
+			break;
+		case 'T':
+			list = optarg;
+			break;
+		case 'S':
+			stats_enable();
+			break;
+		case 'V':
+			version();
+			break;
+		default:
+			usage(1);
+			break;
+		}
+	}
+
+	if ((NULL == list && optind == argc)
+	    || (NULL != output && (NULL != list || optind + 1 != argc))) {
+		usage(1);
+	}
+
+	listed.format = format;
+	listed.subformat = subformat;
+	if (NULL != list && 0 != cf_read_list(list, each_listed, &listed)) {
+		ret = -1;
+	}
+	for (; optind < argc; optind++) {
+		if (0 != write_sub(argv[optind], output, format, subformat)) {
+			ret = -1;
+		}
+	}
+
+	if (stats_enabled()) {
+		stats_print(stderr);
+	}
+
+	return (0 == ret) ? 0 : 1;
+}
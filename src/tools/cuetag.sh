@@ -2,18 +2,22 @@
 
 # cuetag.sh - tag files based on cue/toc file information
 # uses cueprint output
-# usage: cuetag.sh <cuefile|tocfile> [file]...
+# usage: cuetag.sh [--since <old cuefile>] <cuefile|tocfile> [file]...
 
 CUEPRINT=cueprint
+CUEDIFF=cuediff
 cue_file=""
 
 # print usage instructions
 usage()
 {
-	echo "usage: cuetag.sh <cuefile|tocfile> [file]..."
+	echo "usage: cuetag.sh [--since <old cuefile>] <cuefile|tocfile> [file]..."
 	echo
 	echo "cuetag.sh adds tags to files based on cue or toc information"
 	echo
+	echo "With --since, only the files of tracks whose tags differ from those"
+	echo "in the old cue or toc file are tagged (uses cuediff)"
+	echo
 	echo "Supported formats (format extension, format name, tagging utility):"
 	echo "ogg, Ogg Vorbis, vorbiscomment"
 	echo "flac, FLAC, metaflac"
@@ -176,6 +180,21 @@ main()
 		exit
 	fi
 
+	# tracks to tag, or "all"
+	changed=all
+	if [ "$1" = "--since" ]; then
+		if [ $# -lt 3 ]; then
+			usage
+			exit
+		fi
+		changed=$($CUEDIFF -t "$2" "$3")
+		case $? in
+		0|1) ;;
+		*) changed=all;;
+		esac
+		shift 2
+	fi
+
 	cue_file=$1
 	shift
 
@@ -195,6 +214,12 @@ main()
 	fi
 
 	for file in "$@"; do
+		if [ "$changed" != all ] &&
+		   ! echo "$changed" | grep -qx "$trackno"; then
+			trackno=$(($trackno + 1))
+			continue
+		fi
+
 		case $file in
 		*.[Ff][Ll][Aa][Cc])
 			vorbis $trackno "$file" $FIELDS
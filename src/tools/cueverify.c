@@ -0,0 +1,768 @@
+/*
+ * cueverify.c -- verify the audio of a cue or toc file with AccurateRip
+ *
+ * Copyright (C) 2004, 2005, 2006, 2007, 2013 Svend Sorensen
+ * For license terms, see the file COPYING in this distribution.
+ */
+
+#include <fcntl.h>	/* open() */
+#include <getopt.h>	/* getopt_long() */
+#include <pthread.h>	/* pthread_create(), pthread_join() */
+#include <stdio.h>	/* fprintf(), printf(), stderr */
+#include <stdlib.h>	/* exit(), atoi(), atol(), calloc(), free() */
+#include <string.h>	/* memcpy(), memset(), strcmp() */
+#include <sys/mman.h>	/* mmap() */
+#include <sys/stat.h>	/* fstat() */
+#include <unistd.h>	/* close(), sysconf() */
+#include "cuefile.h"
+#include "accuraterip.h"
+#include "crc.h"
+#include "discid.h"
+#include "probe.h"
+#include "stats.h"
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#else /* not HAVE_CONFIG_H */
+#define PACKAGE_STRING "cueverify"
+#endif /* HAVE_CONFIG_H */
+
+#define BYTES_PER_FRAME	2352
+#define CHUNK_FRAMES	32	/* frames checksummed at a time (75 KiB) */
+#define CHUNK_SAMPLES	(CHUNK_FRAMES * SAMPLES_PER_FRAME)
+#define MAXJOBS		256
+#define NBEST		10	/* offsets reported by a search */
+
+/* a mapped data file */
+typedef struct Image Image;
+struct Image {
+	char *name;
+	unsigned char *map;
+	size_t mapsize;
+};
+
+/* one track to checksum, or to search over a range of offsets */
+typedef struct Job Job;
+struct Job {
+	int trackno;
+	long from;		/* disc frames [from, to) */
+	long to;
+	int first;		/* first or last track of the disc */
+	int last;
+	long offset_from;	/* offsets searched, in samples */
+	long offset_to;
+	ArSum ar;
+	uint32_t crc;
+	int error;
+};
+
+/* state shared by the worker threads */
+typedef struct Work Work;
+struct Work {
+	pthread_mutex_t lock;
+	int next;		/* next job to take */
+	int njob;
+	Job *job;
+	Cd *cd;			/* laid out (see cd_layout()) */
+	Image **image;		/* by extent of the layout */
+
+	/* offset search */
+	int search;
+	long range;		/* offsets -range to +range */
+	int *tracks;		/* tracks matching at each offset */
+	int *confidence;	/* their total confidence */
+	ArResponse *resp;
+	int nresp;
+};
+
+static const unsigned char silence[CHUNK_FRAMES * BYTES_PER_FRAME];
+
+char *progname;
+
+/* Print usage information and exit */
+void usage(int status)
+{
+	if (0 == status) {
+		printf("Usage: %s [option...] [file...]\n", progname);
+		printf("Compute AccurateRip and CRC32 checksums of the tracks of a CUE or TOC file.\n"
+		       "\n"
+		       "OPTIONS\n"
+		       "-h, --help			print usage\n"
+		       "-i, --input-format cue|toc	set format of file(s)\n"
+		       "-a, --accuraterip file		compare with an AccurateRip response\n"
+		       "-j, --jobs n			checksum n tracks at once\n"
+		       "-o, --offset-search n		find the read offset, up to n samples,\n"
+		       "				that matches the AccurateRip response\n"
+		       "--stats				print timing and allocation statistics\n"
+		       "-V, --version			print version information\n");
+	} else {
+		fprintf(stderr, "Try `%s --help' for more information.\n", progname);
+	}
+
+	exit (status);
+}
+
+/* Print version information and exit */
+void version()
+{
+	printf("%s\n", PACKAGE_STRING);
+
+	exit(0);
+}
+
+/*
+ * map the file a track refers to (relative to the sheet)
+ * image->name is set even if it can not be mapped, and image->map NULL
+ */
+int map_image(Image *image, char *file, int filetype, char *sheet)
+{
+	char path[4096];
+	struct stat st;
+	Probe probe;
+	int fd;
+
+	cf_data_path(path, sizeof(path), sheet, file);
+	image->name = file;
+	image->map = NULL;
+
+	if (-1 == (fd = open(path, O_RDONLY))) {
+		fprintf(stderr, "%s: error opening file\n", path);
+		return -1;
+	}
+	if (0 != fstat(fd, &st) || 0 == st.st_size) {
+		fprintf(stderr, "%s: empty file\n", path);
+		close(fd);
+		return -1;
+	}
+
+	image->mapsize = st.st_size;
+	image->map = mmap(NULL, image->mapsize, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (MAP_FAILED == image->map) {
+		fprintf(stderr, "%s: error mapping file\n", path);
+		image->map = NULL;
+		return -1;
+	}
+	madvise(image->map, image->mapsize, MADV_SEQUENTIAL);
+
+	/* only CD-DA in WAVE or little-endian raw files can be checksummed */
+	if (0 != probe_memory(image->map, image->mapsize, filetype, &probe)
+	    || (FILE_WAVE != probe.filetype && FILE_BINARY != probe.filetype)
+	    || 44100 != probe.rate || 2 != probe.channels || 16 != probe.bits) {
+		fprintf(stderr, "%s: not 16-bit stereo 44.1 kHz WAVE or raw"
+		        " audio\n", path);
+		munmap(image->map, image->mapsize);
+		image->map = NULL;
+		return -1;
+	}
+
+	return 0;
+}
+
+/* add n frames of data, or of silence if data is NULL */
+void sum_frames(Job *job, const unsigned char *data, long n)
+{
+	long len;
+
+	for (; 0 < n; n -= len) {
+		len = (CHUNK_FRAMES < n) ? CHUNK_FRAMES : n;
+		if (NULL == data) {
+			ar_skip(&job->ar, len * SAMPLES_PER_FRAME);
+			job->crc = crc32_update(job->crc, silence,
+			                        len * BYTES_PER_FRAME);
+		} else {
+			ar_update(&job->ar, data, len * SAMPLES_PER_FRAME);
+			job->crc = crc32_update(job->crc, data,
+			                        len * BYTES_PER_FRAME);
+			data += len * BYTES_PER_FRAME;
+		}
+	}
+}
+
+/*
+ * find the data of disc frame; *data is NULL for silence or missing data
+ * returns the number of frames from frame to the end of its extent, or
+ * -1 off the disc
+ */
+long frame_data(Work *work, long frame, const unsigned char **data,
+                int *missing)
+{
+	CdExtent *e = NULL;
+	Image *image = NULL;
+	long offset;
+	long n;
+	int i;
+
+	if (0 > (i = cd_frame_to_source(work->cd, frame, &offset))) {
+		return -1;
+	}
+	e = cd_get_extent(work->cd, i);
+	n = e->frame + e->length - frame;
+
+	*data = NULL;
+	*missing = 0;
+	if (NULL != e->filename) {
+		image = work->image[i];
+		if (NULL == image
+		    || offset + n * BYTES_PER_FRAME > (long) image->mapsize) {
+			*missing = 1;
+		} else {
+			*data = image->map + offset;
+		}
+	}
+
+	return n;
+}
+
+/* checksum the frames of a job, which may span several extents */
+void run_job(Job *job, Work *work)
+{
+	const unsigned char *data = NULL;
+	long frame = job->from;
+	long n;
+	int missing;
+
+	ar_init(&job->ar, (job->to - job->from) * SAMPLES_PER_FRAME,
+	        job->first, job->last);
+	job->crc = 0;
+
+	while (frame < job->to) {
+		if (0 > (n = frame_data(work, frame, &data, &missing))
+		    || missing) {
+			job->error = 1;
+			return;
+		}
+		n = (job->to - frame < n) ? job->to - frame : n;
+		sum_frames(job, data, n);
+		frame += n;
+	}
+}
+
+/*
+ * copy n samples starting at disc sample pos into buf
+ * silence, missing data and samples off the ends of the disc read as zero
+ */
+void read_samples(Work *work, long pos, long n, unsigned char *buf)
+{
+	const unsigned char *data = NULL;
+	long skip;
+	long len;
+	int missing;
+
+	for (; 0 < n; pos += len, n -= len, buf += len * BYTES_PER_SAMPLE) {
+		skip = pos % SAMPLES_PER_FRAME;
+		if (0 > pos) {
+			len = (-pos < n) ? -pos : n;
+			data = NULL;
+		} else if (0 > (len = frame_data(work, pos / SAMPLES_PER_FRAME,
+		                                 &data, &missing))) {
+			len = n;
+			data = NULL;
+		} else {
+			len = len * SAMPLES_PER_FRAME - skip;
+			len = (len < n) ? len : n;
+		}
+
+		if (NULL == data) {
+			memset(buf, 0, len * BYTES_PER_SAMPLE);
+		} else {
+			memcpy(buf, data + skip * BYTES_PER_SAMPLE,
+			       len * BYTES_PER_SAMPLE);
+		}
+	}
+}
+
+static uint32_t sample(const unsigned char *p)
+{
+	return (uint32_t) p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16
+	       | (uint32_t) p[3] << 24;
+}
+
+/*
+ * compute the v1 checksum of a track at each offset of a range
+ * the full sum is computed once; each later offset is one ar_slide()
+ */
+void run_search(Job *job, Work *work)
+{
+	unsigned char out[CHUNK_SAMPLES * BYTES_PER_SAMPLE];
+	unsigned char in[CHUNK_SAMPLES * BYTES_PER_SAMPLE];
+	long nsamples = (job->to - job->from) * SAMPLES_PER_FRAME;
+	long base = job->from * SAMPLES_PER_FRAME - 1;	/* before sample 1 */
+	long offset = job->offset_from;
+	long pos;
+	long n;
+	long i;
+	int confidence;
+
+	ar_init(&job->ar, nsamples, job->first, job->last);
+	for (pos = 1; pos <= nsamples; pos += n) {
+		n = (nsamples - pos + 1 < CHUNK_SAMPLES)
+		    ? nsamples - pos + 1 : CHUNK_SAMPLES;
+		read_samples(work, base + offset + pos, n, in);
+		ar_update(&job->ar, in, n);
+	}
+
+	while (offset < job->offset_to) {
+		/* samples leaving and entering the counted range */
+		n = (job->offset_to - offset < CHUNK_SAMPLES)
+		    ? job->offset_to - offset : CHUNK_SAMPLES;
+		read_samples(work, base + offset + job->ar.check_start, n, out);
+		read_samples(work, base + offset + job->ar.check_end + 1, n, in);
+
+		for (i = 0; i < n; i++, offset++) {
+			confidence = ar_confidence(work->resp, work->nresp,
+			                           job->trackno, job->ar.v1);
+			if (0 < confidence) {
+				pthread_mutex_lock(&work->lock);
+				work->tracks[offset + work->range]++;
+				work->confidence[offset + work->range] += confidence;
+				pthread_mutex_unlock(&work->lock);
+			}
+			ar_slide(&job->ar, sample(out + i * BYTES_PER_SAMPLE),
+			         sample(in + i * BYTES_PER_SAMPLE));
+		}
+	}
+}
+
+void *worker(void *arg)
+{
+	Work *work = arg;
+	Job *job = NULL;
+
+	for (;;) {
+		pthread_mutex_lock(&work->lock);
+		job = (work->next < work->njob) ? &work->job[work->next++] : NULL;
+		pthread_mutex_unlock(&work->lock);
+
+		if (NULL == job) {
+			return NULL;
+		} else if (work->search) {
+			run_search(job, work);
+		} else {
+			run_job(job, work);
+		}
+	}
+}
+
+/* run all jobs on up to njobs threads */
+void run_jobs(Work *work, int njobs)
+{
+	pthread_t thread[MAXJOBS];
+	int n = 0;
+
+	if (njobs > work->njob) {
+		njobs = work->njob;
+	}
+
+	pthread_mutex_init(&work->lock, NULL);
+	for (; n < njobs - 1; n++) {
+		if (0 != pthread_create(&thread[n], NULL, worker, work)) {
+			break;
+		}
+	}
+	worker(work);	/* this thread works too */
+	while (0 < n) {
+		pthread_join(thread[--n], NULL);
+	}
+	pthread_mutex_destroy(&work->lock);
+}
+
+/* print the checksums of each track, and whether they are accurate */
+int print_sums(Work *work, char *db)
+{
+	Job *job = NULL;
+	int confidence;
+	int ret = 0;
+	int n;
+	int i;
+
+	n = printf("Track\tCRC32\t\tAR v1\t\tAR v2%s\n",
+	           (NULL != db) ? "\t\tResult" : "");
+	for (i = 0; i < work->njob; i++) {
+		job = &work->job[i];
+		if (job->error) {
+			n += printf("%2d\tdata missing\n", job->trackno);
+			ret = -1;
+			continue;
+		}
+
+		n += printf("%2d\t%08lx\t%08lx\t%08lx", job->trackno,
+		            (unsigned long) job->crc,
+		            (unsigned long) job->ar.v1,
+		            (unsigned long) job->ar.v2);
+
+		if (NULL == db) {
+			n += printf("\n");
+		} else if (0 < (confidence = ar_confidence(work->resp,
+		           work->nresp, job->trackno, job->ar.v2))) {
+			n += printf("\taccurate (v2, confidence %d)\n", confidence);
+		} else if (0 < (confidence = ar_confidence(work->resp,
+		           work->nresp, job->trackno, job->ar.v1))) {
+			n += printf("\taccurate (v1, confidence %d)\n", confidence);
+		} else {
+			n += printf("\tno match\n");
+			ret = (0 == ret) ? 1 : ret;
+		}
+	}
+	stats_count(STATS_BYTES_WRITTEN, n);
+
+	return ret;
+}
+
+/* print the offsets at which the most tracks match */
+int print_offsets(Work *work, int ntrack)
+{
+	long best[NBEST];
+	int nbest = 0;
+	long o;
+	int n = 0;
+	int i;
+
+	/* keep the best offsets, most tracks first, then most confidence */
+	for (o = 0; o <= 2 * work->range; o++) {
+		if (0 == work->tracks[o]) {
+			continue;
+		}
+		for (i = nbest; 0 < i; i--) {
+			if (work->tracks[best[i - 1]] > work->tracks[o]
+			    || (work->tracks[best[i - 1]] == work->tracks[o]
+			        && work->confidence[best[i - 1]]
+			           >= work->confidence[o])) {
+				break;
+			}
+			if (NBEST > i) {
+				best[i] = best[i - 1];
+			}
+		}
+		if (NBEST > i) {
+			best[i] = o;
+			nbest += (NBEST > nbest);
+		}
+	}
+
+	if (0 == nbest) {
+		printf("no offset found\n");
+		return 1;
+	}
+
+	n = printf("Offset\tTracks\tConfidence\n");
+	for (i = 0; i < nbest; i++) {
+		n += printf("%+ld\t%d/%d\t%d\n", best[i] - work->range,
+		            work->tracks[best[i]], ntrack,
+		            work->confidence[best[i]]);
+	}
+	stats_count(STATS_BYTES_WRITTEN, n);
+
+	return 0;
+}
+
+/*
+ * split the offset range of each track among the threads
+ * returns the number of jobs
+ */
+int split_search(Job *job, int njob, long range, int njobs)
+{
+	long noffset = 2 * range + 1;
+	int nsplit = 1;
+	int n = 0;
+	int i;
+	int j;
+
+	if (njobs > njob) {
+		nsplit = (njobs + njob - 1) / njob;
+	}
+	if (nsplit * njob > MAXJOBS) {
+		nsplit = MAXJOBS / njob;
+	}
+	if (nsplit > noffset) {
+		nsplit = noffset;
+	}
+
+	/* job[i] goes to job[i * nsplit .. (i + 1) * nsplit - 1] */
+	for (i = njob - 1; 0 <= i; i--) {
+		for (j = nsplit - 1; 0 <= j; j--) {
+			n = i * nsplit + j;
+			job[n] = job[i];
+			job[n].offset_from = -range + noffset * j / nsplit;
+			job[n].offset_to = -range + noffset * (j + 1) / nsplit;
+		}
+	}
+
+	return njob * nsplit;
+}
+
+/*
+ * checksum the audio tracks of cd and print the results
+ * with range > 0, search offsets -range to +range instead
+ * returns 1 if a track does not match the AccurateRip response
+ */
+int verify_cd(Cd *cd, Image **image, char *db, int njobs, long range)
+{
+	DiscToc toc;
+	Job job[MAXJOBS];
+	Work work;
+	unsigned long id1;
+	unsigned long id2;
+	unsigned long cddb;
+	long bytes = 0;
+	int ntrack;
+	int phase;
+	int ret = 0;
+	int i;
+	int j;
+	int n;
+
+	if (0 != discid_toc(cd, &toc)) {
+		return -1;
+	}
+
+	memset(&work, 0, sizeof(Work));
+	if (NULL != db) {
+		if (0 > (work.nresp = ar_read_db(db, &work.resp))) {
+			return -1;
+		}
+
+		/* only responses for this disc */
+		discid_accuraterip(&toc, &id1, &id2);
+		cddb = discid_cddb(&toc);
+		for (i = 0, j = 0; i < work.nresp; i++) {
+			if (id1 == work.resp[i].id1 && id2 == work.resp[i].id2
+			    && cddb == work.resp[i].cddb) {
+				work.resp[j++] = work.resp[i];
+			}
+		}
+		if (0 == (work.nresp = j) && 0 < range) {
+			fprintf(stderr, "%s: `%s' has no response for this disc\n",
+			        progname, db);
+			ret = -1;
+		}
+	}
+
+	/* a track runs from its index 01 to that of the next track */
+	for (i = 0; i < toc.naudio; i++) {
+		if (toc.data[i]) {
+			continue;
+		}
+		n = work.njob++;
+		job[n].trackno = i + 1;
+		job[n].from = toc.offset[i];
+		job[n].to = (i + 1 < toc.naudio) ? toc.offset[i + 1]
+		                                 : toc.audio_leadout;
+		job[n].first = (0 == i);
+		job[n].last = (i + 1 == toc.naudio);
+		job[n].error = 0;
+		bytes += (job[n].to - job[n].from) * BYTES_PER_FRAME;
+	}
+	ntrack = work.njob;
+	work.job = job;
+	work.cd = cd;
+	work.image = image;
+
+	if (0 < range && 0 == ret) {
+		work.search = 1;
+		work.range = range;
+		work.tracks = calloc(2 * range + 1, sizeof(int));
+		work.confidence = calloc(2 * range + 1, sizeof(int));
+		if (NULL == work.tracks || NULL == work.confidence) {
+			fprintf(stderr, "unable to allocate memory\n");
+			ret = -1;
+		} else {
+			work.njob = split_search(job, work.njob, range, njobs);
+		}
+	}
+
+	if (0 == ret) {
+		phase = stats_phase(PHASE_IO);
+		run_jobs(&work, njobs);
+		stats_count(STATS_BYTES_READ, bytes);
+
+		stats_phase(PHASE_PRINT);
+		if (work.search) {
+			ret = print_offsets(&work, ntrack);
+		} else {
+			ret = print_sums(&work, db);
+		}
+		stats_phase(phase);
+	}
+
+	free(work.tracks);
+	free(work.confidence);
+	free(work.resp);
+
+	return ret;
+}
+
+int verify(char *name, int format, char *db, int njobs, long range)
+{
+	Cd *cd = NULL;
+	Track *track = NULL;
+	CdExtent *e = NULL;
+	Image image[MAXTRACK];
+	int nimage = 0;
+	Image *ext_image[3 * MAXTRACK];	/* by extent */
+	int phase;
+	int ret = 0;
+	int i;
+	int j;
+
+	stats_file_begin(name);
+
+	if (NULL == (cd = cf_parse(name, &format))) {
+		fprintf(stderr, "%s: error: unable to parse input file"
+		        " `%s'\n", progname, name);
+		stats_file_end();
+		return -1;
+	}
+
+	/* map each data file once */
+	phase = stats_phase(PHASE_IO);
+	if (0 != cf_set_lengths(cd, name)) {
+		fprintf(stderr, "%s: error: unable to find the track lengths"
+		        " of `%s'\n", progname, name);
+		stats_phase(phase);
+		cd_delete(cd);
+		stats_file_end();
+		return -1;
+	}
+	for (i = 0; i < cd_get_nextent(cd); i++) {
+		e = cd_get_extent(cd, i);
+		ext_image[i] = NULL;
+		if (NULL == e->filename) {
+			continue;
+		}
+		for (j = 0; j < nimage; j++) {
+			if (0 == strcmp(image[j].name, e->filename)) {
+				break;
+			}
+		}
+		/* a file that can not be mapped is tried once */
+		if (j == nimage) {
+			track = cd_get_track(cd, e->trackno);
+			map_image(&image[j], e->filename,
+			          track_get_filetype(track), name);
+			nimage++;
+		}
+		if (NULL != image[j].map) {
+			ext_image[i] = &image[j];
+		}
+	}
+	stats_phase(phase);
+
+	if (0 > (ret = verify_cd(cd, ext_image, db, njobs, range))) {
+		fprintf(stderr, "%s: error: unable to verify `%s'\n",
+		        progname, name);
+	}
+
+	for (i = 0; i < nimage; i++) {
+		if (NULL != image[i].map) {
+			munmap(image[i].map, image[i].mapsize);
+		}
+	}
+	cd_delete(cd);
+	stats_file_end();
+
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	int format = UNKNOWN;
+	char *db = NULL;
+	int njobs = sysconf(_SC_NPROCESSORS_ONLN);
+	long range = 0;		/* offset search range */
+	int multi;		/* more than one operand */
+	int ret = 0;		/* return value of verify() */
+
+	/* option variables */
+	int c;
+	/* getopt_long() variables */
+	extern char *optarg;
+	extern int optind;
+
+	static struct option longopts[] = {
+		{"help", no_argument, NULL, 'h'},
+		{"input-format", required_argument, NULL, 'i'},
+		{"accuraterip", required_argument, NULL, 'a'},
+		{"jobs", required_argument, NULL, 'j'},
+		{"offset-search", required_argument, NULL, 'o'},
+		{"stats", no_argument, NULL, 'S'},
+		{"version", no_argument, NULL, 'V'},
+		{NULL, 0, NULL, 0}
+	};
+
+	progname = argv[0];
+
+	while (-1 != (c = getopt_long(argc, argv, "hi:a:j:o:V", longopts, NULL))) {
+		switch (c) {
+		case 'h':
+			usage(0);
+			break;
+		case 'i':
+			if (UNKNOWN == (format = cf_format_from_name(optarg))) {
+				fprintf(stderr, "%s: error: unknown input file"
+				        " format `%s'\n", progname, optarg);
+				usage(1);
+			}
+			break;
+		case 'a':
+			db = optarg;
+			break;
+		case 'j':
+			if (0 >= (njobs = atoi(optarg))) {
+				fprintf(stderr, "%s: error: bad number of jobs"
+				        " `%s'\n", progname, optarg);
+				usage(1);
+			}
+			break;
+		case 'o':
+			if (0 >= (range = atol(optarg))) {
+				fprintf(stderr, "%s: error: bad offset range"
+				        " `%s'\n", progname, optarg);
+				usage(1);
+			}
+			break;
+		case 'S':
+			stats_enable();
+			break;
+		case 'V':
+			version();
+			break;
+		default:
+			usage(1);
+			break;
+		}
+	}
+
+	if (0 >= njobs) {
+		njobs = 1;
+	}
+
+	if (0 < range && NULL == db) {
+		fprintf(stderr, "%s: error: offset search needs an AccurateRip"
+		        " response\n", progname);
+		usage(1);
+	}
+
+	/* What we do depends on the number of operands. */
+	if (optind == argc) {
+		/* No operands: verify stdin. */
+		ret = verify("-", format, db, njobs, range);
+	} else {
+		/* Verify each operand, going on past bad ones. */
+		multi = (1 < argc - optind);
+		for (; optind < argc; optind++) {
+			if (multi) {
+				printf("%s:\n", argv[optind]);
+			}
+			if (0 != verify(argv[optind], format, db, njobs, range)) {
+				ret = 1;
+			}
+		}
+	}
+
+	if (stats_enabled()) {
+		stats_print(stderr);
+	}
+
+	return ret;
+}